@@ -0,0 +1,336 @@
+// Copyright 2018 Alexander Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Micro benchmark for json::numbers::NumberToString and json::numbers::StringToNumber.
+//
+// Usage:
+//      bench_numbers [canada.json]
+//
+// If a JSON file is specified, all numbers contained in the file are used as an
+// additional data set. Otherwise test_data/canada.json is tried.
+//
+// The size/speed trade-off of the conversion routines is controlled by the
+// DTOA_OPTIMIZE_SIZE and STRTOD_OPTIMIZE_SIZE macros, which must be set when
+// compiling the json library (use premake5 --full-number-tables to select the
+// full tables). See result_numbers.txt for results.
+
+#include "../../src/json.h"
+#include "../../src/json_numbers.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+//==================================================================================================
+// Data sets
+//==================================================================================================
+
+struct DataSet
+{
+    char const* name;
+    std::vector<double> values;
+    std::vector<std::string> strings; // Shortest representations of values
+};
+
+std::vector<std::string> ToStrings(std::vector<double> const& values)
+{
+    std::vector<std::string> strings;
+    strings.reserve(values.size());
+
+    char buf[32];
+    for (double const v : values)
+    {
+        char* const end = json::numbers::NumberToString(buf, buf + 32, v);
+        strings.emplace_back(buf, end);
+    }
+
+    return strings;
+}
+
+DataSet MakeDataSet(char const* name, std::vector<double> values)
+{
+    DataSet ds;
+    ds.name = name;
+    ds.strings = ToStrings(values);
+    ds.values = std::move(values);
+    return ds;
+}
+
+constexpr size_t kNumValues = 1 << 16;
+
+// Uniformly distributed bit patterns (excluding NaN and Infinity).
+DataSet RandomDoubles(std::mt19937_64& rng)
+{
+    std::vector<double> values;
+    values.reserve(kNumValues);
+
+    while (values.size() < kNumValues)
+    {
+        uint64_t const bits = rng();
+
+        double value;
+        std::memcpy(&value, &bits, sizeof(double));
+        if (!std::isfinite(value))
+            continue;
+
+        values.push_back(value);
+    }
+
+    return MakeDataSet("random doubles", std::move(values));
+}
+
+// Integers in the range [-2^53, 2^53] with a uniformly distributed number of digits.
+DataSet Integers(std::mt19937_64& rng)
+{
+    std::uniform_int_distribution<int> gen_digits(1, 16);
+
+    std::vector<double> values;
+    values.reserve(kNumValues);
+
+    while (values.size() < kNumValues)
+    {
+        int64_t const max_value = static_cast<int64_t>(std::pow(10.0, gen_digits(rng)) - 1);
+
+        std::uniform_int_distribution<int64_t> gen_value(-max_value, max_value);
+        values.push_back(static_cast<double>(gen_value(rng)));
+    }
+
+    return MakeDataSet("integers", std::move(values));
+}
+
+// Decimal numbers with up to 6 significant digits, like "12.5" or "0.0375".
+DataSet ShortDecimals(std::mt19937_64& rng)
+{
+    std::uniform_int_distribution<int> gen_digits(1, 6);
+    std::uniform_int_distribution<int> gen_exponent(-6, 0);
+
+    std::vector<double> values;
+    values.reserve(kNumValues);
+
+    char buf[32];
+    while (values.size() < kNumValues)
+    {
+        int const max_value = static_cast<int>(std::pow(10.0, gen_digits(rng)) - 1);
+
+        std::uniform_int_distribution<int> gen_value(0, max_value);
+        std::snprintf(buf, 32, "%de%d", gen_value(rng), gen_exponent(rng));
+
+        values.push_back(std::strtod(buf, nullptr));
+    }
+
+    return MakeDataSet("short decimals", std::move(values));
+}
+
+// Coordinates like in canada.json: longitudes in [-141, -52], latitudes in
+// [41, 84], mostly printed with 15-17 significant digits.
+DataSet CanadaLike(std::mt19937_64& rng)
+{
+    std::uniform_real_distribution<double> gen_lon(-141.0, -52.0);
+    std::uniform_real_distribution<double> gen_lat(41.0, 84.0);
+
+    std::vector<double> values;
+    values.reserve(kNumValues);
+
+    while (values.size() < kNumValues)
+    {
+        values.push_back(gen_lon(rng));
+        values.push_back(gen_lat(rng));
+    }
+
+    return MakeDataSet("canada-like", std::move(values));
+}
+
+void CollectNumbers(std::vector<double>& values, json::Value const& v)
+{
+    switch (v.type())
+    {
+    case json::Type::number:
+        values.push_back(v.get_number());
+        break;
+    case json::Type::array:
+        for (auto const& e : v.get_array())
+            CollectNumbers(values, e);
+        break;
+    case json::Type::object:
+        for (auto const& m : v.get_object())
+            CollectNumbers(values, m.second);
+        break;
+    default:
+        break;
+    }
+}
+
+bool LoadFile(DataSet& ds, char const* filename)
+{
+    FILE* fh = std::fopen(filename, "rb");
+    if (!fh)
+        return false;
+
+    std::string contents;
+
+    char buf[4096];
+    for (;;)
+    {
+        size_t const n = std::fread(buf, 1, sizeof(buf), fh);
+        if (n == 0)
+            break;
+        contents.append(buf, n);
+    }
+    std::fclose(fh);
+
+    json::Value value;
+    if (json::parse(value, contents) != json::ParseStatus::success)
+    {
+        std::fprintf(stderr, "failed to parse file: %s\n", filename);
+        return false;
+    }
+
+    std::vector<double> values;
+    CollectNumbers(values, value);
+    if (values.empty())
+        return false;
+
+    ds = MakeDataSet(filename, std::move(values));
+    return true;
+}
+
+//==================================================================================================
+// Benchmarks
+//==================================================================================================
+
+constexpr int kNumRuns = 15;
+
+template <typename Fn>
+double Measure(size_t count, Fn fn)
+{
+    using Clock = std::chrono::steady_clock;
+
+    double fastest = DBL_MAX;
+    for (int run = 0; run < kNumRuns; ++run)
+    {
+        auto const t0 = Clock::now();
+        fn();
+        auto const t1 = Clock::now();
+
+        fastest = std::min(fastest, std::chrono::duration<double, std::nano>(t1 - t0).count());
+    }
+
+    return fastest / static_cast<double>(count);
+}
+
+volatile double g_sink_double;
+volatile size_t g_sink_size;
+
+void Run(DataSet const& ds)
+{
+    size_t const count = ds.values.size();
+
+    double const dtoa_ns = Measure(count, [&] {
+        char buf[32];
+        size_t total = 0;
+        for (double const v : ds.values)
+        {
+            char* const end = json::numbers::NumberToString(buf, buf + 32, v);
+            total += static_cast<size_t>(end - buf);
+        }
+        g_sink_size = total;
+    });
+
+    double const strtod_ns = Measure(count, [&] {
+        double total = 0;
+        for (auto const& s : ds.strings)
+        {
+            double value = 0;
+            json::numbers::StringToNumber(value, s.data(), s.data() + s.size());
+            total += value;
+        }
+        g_sink_double = total;
+    });
+
+    std::vector<json::numbers::NumberString> number_strings;
+    number_strings.reserve(count);
+    for (auto const& s : ds.strings)
+    {
+        number_strings.push_back({s.data(), s.data() + s.size()});
+    }
+
+    std::vector<double> batch_values(count);
+    std::string batch_output;
+
+    double const batch_dtoa_ns = Measure(count, [&] {
+        batch_output.clear();
+        json::numbers::NumbersToString(batch_output, ds.values.data(), count);
+        g_sink_size = batch_output.size();
+    });
+
+    double const batch_strtod_ns = Measure(count, [&] {
+        json::numbers::StringsToNumbers(batch_values.data(), number_strings.data(), count);
+        g_sink_double = batch_values[count / 2];
+    });
+
+    // Verify round-trip.
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto const& s = ds.strings[i];
+
+        double value = 0;
+        if (!json::numbers::StringToNumber(value, s.data(), s.data() + s.size()) || value != ds.values[i] || batch_values[i] != ds.values[i])
+        {
+            std::fprintf(stderr, "round-trip failed: %s\n", s.c_str());
+            std::abort();
+        }
+    }
+
+    std::printf("%-30s%10zu%15.2f%15.2f%15.2f%15.2f\n", ds.name, count, dtoa_ns, strtod_ns, batch_dtoa_ns, batch_strtod_ns);
+    std::fflush(stdout);
+}
+
+} // namespace
+
+int main(int argc, char const** argv)
+{
+    std::printf("DTOA_OPTIMIZE_SIZE=%d, STRTOD_OPTIMIZE_SIZE=%d\n", json::numbers::kDtoaOptimizeSize, json::numbers::kStrtodOptimizeSize);
+    std::printf("%-30s%10s%15s%15s%15s%15s\n", "Data set", "Count", "dtoa [ns]", "strtod [ns]", "batch dtoa", "batch strtod");
+
+    std::mt19937_64 rng(0x5EED);
+
+    Run(RandomDoubles(rng));
+    Run(Integers(rng));
+    Run(ShortDecimals(rng));
+    Run(CanadaLike(rng));
+
+    DataSet file_ds;
+    if (LoadFile(file_ds, argc > 1 ? argv[1] : "test_data/canada.json"))
+    {
+        Run(file_ds);
+    }
+
+    return 0;
+}
@@ -10,6 +10,11 @@ newoption {
     description = "Additional linker options",
 }
 
+newoption {
+    trigger = "full-number-tables",
+    description = "Use the full (faster, but larger) power tables for number conversions",
+}
+
 --------------------------------------------------------------------------------
 workspace "Json"
     configurations { "release", "debug" }
@@ -58,6 +63,11 @@ workspace "Json"
             -- "-ftime-report",
         }
 
+    configuration { "gmake", "linux" }
+        linkoptions {
+            "-pthread", -- stringify_parallel
+        }
+
     configuration { "gmake", "debug", "linux" }
         buildoptions {
             -- "-fno-omit-frame-pointer",
@@ -108,6 +118,14 @@ workspace "Json"
             }
     end
 
+    if _OPTIONS["full-number-tables"] then
+        configuration {}
+            defines {
+                "DTOA_OPTIMIZE_SIZE=0",
+                "STRTOD_OPTIMIZE_SIZE=0",
+            }
+    end
+
 --------------------------------------------------------------------------------
 group "Libs"
 
@@ -171,3 +189,22 @@ project "benchmark"
             "-Wconversion",
             "-pedantic",
         }
+
+project "bench_numbers"
+    language "C++"
+    kind "ConsoleApp"
+    files {
+        "benchmark/numbers/*.cc",
+    }
+    links {
+        "json",
+    }
+    configuration { "gmake" }
+        buildoptions {
+            "-Wsign-compare",
+            "-Wsign-conversion",
+            "-Wold-style-cast",
+            "-Wshadow",
+            "-Wconversion",
+            "-pedantic",
+        }
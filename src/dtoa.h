@@ -1435,12 +1435,18 @@ DTOA_INLINE int PrintDecimalDigits(char* next, char* last, uint64_t output)
 
 constexpr int kDoubleToDecimalMaxLength = 17;
 
-inline void DoubleToDecimal(char* next, char* last, int& num_digits, int& exponent, double value)
+namespace dtoa_impl {
+
+// Single-precision numbers are converted using the double-precision tables.
+// The 128-bit multiplications used here have more than enough precision for
+// significands with at most 24+2 bits (and the exponent range of single-precision
+// numbers is a subset of the exponent range of double-precision numbers).
+template <typename Float>
+inline void BinaryToDecimal(char* next, char* last, int& num_digits, int& exponent, Float value)
 {
-    using Double = dtoa_impl::IEEE<double>;
-    using namespace dtoa_impl;
+    using Double = dtoa_impl::IEEE<Float>;
 
-    DTOA_ASSERT(last - next >= kDoubleToDecimalMaxLength);
+    DTOA_ASSERT(last - next >= std::numeric_limits<Float>::max_digits10);
     DTOA_ASSERT(Double(value).IsFinite());
     DTOA_ASSERT(value > 0);
 
@@ -1677,6 +1683,22 @@ inline void DoubleToDecimal(char* next, char* last, int& num_digits, int& expone
     exponent = e10;
 }
 
+} // namespace dtoa_impl
+
+inline void DoubleToDecimal(char* next, char* last, int& num_digits, int& exponent, double value)
+{
+    DTOA_ASSERT(last - next >= kDoubleToDecimalMaxLength);
+    base_conv::dtoa_impl::BinaryToDecimal(next, last, num_digits, exponent, value);
+}
+
+constexpr int kFloatToDecimalMaxLength = 9;
+
+inline void FloatToDecimal(char* next, char* last, int& num_digits, int& exponent, float value)
+{
+    DTOA_ASSERT(last - next >= kFloatToDecimalMaxLength);
+    base_conv::dtoa_impl::BinaryToDecimal(next, last, num_digits, exponent, value);
+}
+
 //==================================================================================================
 // PositiveDtoa
 //==================================================================================================
@@ -1789,16 +1811,17 @@ DTOA_INLINE char* FormatExponential(char* buffer, int length, int exponent, char
 
 constexpr int kPositiveDtoaMaxLength = 24;
 
-inline char* PositiveDtoa(char* next, char* last, double value, bool force_trailing_dot_zero = false)
+template <typename Float>
+inline char* PositiveDtoa(char* next, char* last, Float value, bool force_trailing_dot_zero = false)
 {
     DTOA_ASSERT(last - next >= kPositiveDtoaMaxLength);
     DTOA_ASSERT(value > 0);
 
     int num_digits = 0;
     int exponent = 0;
-    base_conv::DoubleToDecimal(next, last, num_digits, exponent, value);
+    base_conv::dtoa_impl::BinaryToDecimal(next, last, num_digits, exponent, value);
 
-    DTOA_ASSERT(num_digits <= std::numeric_limits<double>::max_digits10);
+    DTOA_ASSERT(num_digits <= std::numeric_limits<Float>::max_digits10);
 
 #if 0//test
     char* end = next + num_digits;
@@ -1855,15 +1878,18 @@ DTOA_INLINE char* StrCopy(char* next, char* last, char const* source)
 
 constexpr int kDtoaMaxLength = 1/* minus-sign */ + kPositiveDtoaMaxLength;
 
+// Converts the double- or single-precision number VALUE into the shortest
+// decimal representation which round-trips.
+template <typename Float>
 inline char* Dtoa(
     char*       next,
     char*       last,
-    double      value,
+    Float       value,
     bool        force_trailing_dot_zero = false,
     char const* nan_string = "NaN",
     char const* inf_string = "Infinity")
 {
-    using Double = dtoa_impl::IEEE<double>;
+    using Double = dtoa_impl::IEEE<Float>;
 
     DTOA_ASSERT(next != nullptr);
     DTOA_ASSERT(last != nullptr);
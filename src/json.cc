@@ -19,6 +19,8 @@
 // SOFTWARE.
 
 #include "json.h"
+#include "json_cbor.h"
+#include "json_lexer.h"
 #include "json_numbers.h"
 #include "json_strings.h"
 
@@ -27,9 +29,28 @@
 #include <cstdlib>
 #include <cstring>
 #include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <system_error>
+#include <thread>
 
 using namespace json;
 
+//==================================================================================================
+// Traits
+//==================================================================================================
+
+double json::impl::FloatToNumber(float value)
+{
+    return numbers::FloatToNumber(value);
+}
+
+float json::impl::NumberToFloat(double value)
+{
+    return numbers::NumberToFloat(value);
+}
+
 //==================================================================================================
 // Value
 //==================================================================================================
@@ -50,6 +71,7 @@ Value::Value(Value const& rhs)
     case Type::string:
         data_.string = new String(*rhs.data_.string);
         type_ = Type::string;
+        escaped_ = rhs.escaped_;
         break;
     case Type::array:
         data_.array = new Array(*rhs.data_.array);
@@ -142,6 +164,12 @@ String& Value::assign(Tag_string, String&& v)
     return _assign_string(std::move(v));
 }
 
+void Value::assign_escaped(Tag_string, String&& v)
+{
+    _assign_string(std::move(v));
+    escaped_ = true;
+}
+
 Array& Value::assign(Tag_array)
 {
     return _assign_array(Array{});
@@ -191,7 +219,10 @@ Value& Value::operator=(Value const& rhs)
             assign(number_tag, rhs.get_number());
             break;
         case Type::string:
-            assign(string_tag, rhs.get_string());
+            if (rhs.is_escaped_string())
+                assign_escaped(string_tag, String(rhs.get_escaped_string()));
+            else
+                assign(string_tag, rhs.get_string());
             break;
         case Type::array:
             assign(array_tag, rhs.get_array());
@@ -229,6 +260,23 @@ void Value::_clear_allocated()
     type_ = Type::undefined;
 }
 
+void Value::_unescape_string() const noexcept
+{
+    JSON_ASSERT(is_string());
+    JSON_ASSERT(escaped_);
+
+    // Unescaping never makes the string longer. Unescape in place.
+    String& str = *data_.string;
+
+    char* out = &str[0];
+    auto const res = strings::UnescapeStringBulk(str.data(), str.data() + str.size(), out);
+    static_cast<void>(res);
+    JSON_ASSERT(res.status == strings::UnescapeStringStatus::success);
+
+    str.resize(static_cast<size_t>(out - str.data()));
+    escaped_ = false;
+}
+
 template <typename T>
 String& Value::_assign_string(T&& value)
 {
@@ -243,6 +291,7 @@ String& Value::_assign_string(T&& value)
         break;
     case Type::string:
         *data_.string = std::forward<T>(value);
+        escaped_ = false;
         break;
     case Type::array:
         {
@@ -286,6 +335,7 @@ Array& Value::_assign_array(T&& value)
             delete data_.string;
             data_.array = p;
             type_ = Type::array;
+            escaped_ = false;
         }
         break;
     case Type::array:
@@ -324,6 +374,7 @@ Object& Value::_assign_object(T&& value)
             delete data_.string;
             data_.object = p;
             type_ = Type::object;
+            escaped_ = false;
         }
         break;
     case Type::array:
@@ -467,6 +518,7 @@ void Value::swap(Value& rhs) noexcept
 {
     std::swap(data_, rhs.data_);
     std::swap(type_, rhs.type_);
+    std::swap(escaped_, rhs.escaped_);
 }
 
 size_t Value::size() const noexcept
@@ -615,6 +667,30 @@ Value& Value::operator[](Object::key_type&& key)
     return _get_or_assign_object()[std::move(key)];
 }
 
+Value& Value::operator[](Key const& key)
+{
+    auto& obj = _get_or_assign_object();
+
+    auto const it = obj.find(key);
+    if (it != obj.end()) {
+        return it->second;
+    }
+
+    return obj[key.str()];
+}
+
+size_t Value::erase(Key const& key)
+{
+    auto& obj = get_object();
+
+    auto const it = obj.find(key);
+    if (it == obj.end())
+        return 0;
+
+    obj.erase(it);
+    return 1;
+}
+
 Value::item_iterator Value::erase(const_item_iterator pos)
 {
     auto& obj = get_object();
@@ -895,32 +971,28 @@ struct ParseValueCallbacks /*final*/ : ParseCallbacks
     {
         if (options.parse_numbers_as_strings)
             stack.emplace_back(json::string_tag, first, last);
+        else if (options.parse_numbers_as_float)
+            stack.emplace_back(numbers::StringToFloatNumber(first, last, nc));
         else
             stack.emplace_back(numbers::StringToNumber(first, last, nc));
 
         return {};
     }
 
-    ParseStatus HandleString(char const* first, char const* last, bool needs_cleaning, Options const& /*options*/) override
+    ParseStatus HandleString(char const* first, char const* last, bool needs_cleaning, Options const& options) override
     {
-        if (needs_cleaning)
+        if (needs_cleaning && options.lazy_string_unescaping)
         {
-            String str;
-            str.reserve(static_cast<size_t>(last - first));
-
-#if 0
-            // XXX:
-            // next (first special character) should be stored when lexing the string...
-            auto const next = strings::SkipNonSpecial(first, last);
-            str.append(first, next);
-            first = next;
-#endif
-
-            auto const res = strings::UnescapeString(first, last, [&](char ch) {
-                str.push_back(ch);
-            });
+            if (strings::ValidateString(first, last).status != strings::UnescapeStringStatus::success)
+                return ParseStatus::invalid_string;
 
-            if (res.status != strings::UnescapeStringStatus::success)
+            stack.emplace_back();
+            stack.back().assign_escaped(json::string_tag, String(first, last));
+        }
+        else if (needs_cleaning)
+        {
+            String str;
+            if (strings::UnescapeStringBulk(str, first, last).status != strings::UnescapeStringStatus::success)
                 return ParseStatus::invalid_string;
 
             stack.emplace_back(std::move(str));
@@ -976,13 +1048,7 @@ struct ParseValueCallbacks /*final*/ : ParseCallbacks
         if (needs_cleaning)
         {
             keys.emplace_back();
-            keys.back().reserve(static_cast<size_t>(last - first));
-
-            auto const res = strings::UnescapeString(first, last, [&](char ch) {
-                keys.back().push_back(ch);
-            });
-
-            if (res.status != strings::UnescapeStringStatus::success)
+            if (strings::UnescapeStringBulk(keys.back(), first, last).status != strings::UnescapeStringStatus::success)
                 return ParseStatus::invalid_string; // return ParseStatus::invalid_key;
         }
         else
@@ -1092,235 +1158,1636 @@ ParseStatus json::parse(Value& value, std::string const& str, Options const& opt
     return json::parse(value, next, last, options).ec;
 }
 
-//==================================================================================================
-// stringify
-//==================================================================================================
+ParseResult16 json::parse(Value& value, char16_t const* next, char16_t const* last, Options const& options)
+{
+    ParseValueCallbacks cb;
 
-static bool StringifyValue(std::string& str, Value const& value, Options const& options, int curr_indent);
+    auto const res = json::parse(cb, next, last, options);
+    if (res.ec == ParseStatus::success)
+    {
+        JSON_ASSERT(cb.stack.size() == 1);
+        value = std::move(cb.stack.back());
+    }
 
-static bool StringifyNull(std::string& str)
-{
-    str += "null";
-    return true;
+    return res;
 }
 
-static bool StringifyBoolean(std::string& str, bool value)
+ParseStatus json::parse(Value& value, std::u16string const& str, Options const& options)
 {
-    str += value ? "true" : "false";
-    return true;
+    char16_t const* next = str.data();
+    char16_t const* last = str.data() + str.size();
+
+    return json::parse(value, next, last, options).ec;
 }
 
-static bool StringifyNumber(std::string& str, double value, Options const& options)
+ParseResult json::from_cbor(Value& value, char const* next, char const* last, Options const& options)
 {
-    if (!std::isfinite(value))
-    {
-        if (!options.allow_nan_inf)
-        {
-            str += "null";
-        }
-        else if (std::isnan(value))
-        {
-            str += "NaN";
-        }
-        else
-        {
-            if (value < 0)
-                str += '-';
-
-            str += "Infinity";
-        }
-    }
-#if 0
-    else if (value == 0.0)
-    {
-        // Handle +-0.
-        // Interpret -0 as a floating-point number and +0 as an integer.
+    ParseValueCallbacks cb;
 
-        if (std::signbit(value))
-            str += "-0.0";
-        else
-            str += '0';
-    }
-#endif
-    else
+    auto const res = json::parse_cbor(cb, next, last, options);
+    if (res.ec == ParseStatus::success)
     {
-        char buf[32];
-        char* end = numbers::NumberToString(buf, buf + 32, value, /*emit_trailing_dot_zero*/ true);
-
-        str.append(buf, end);
+        JSON_ASSERT(cb.stack.size() == 1);
+        value = std::move(cb.stack.back());
     }
 
-    return true;
+    return res;
 }
 
-static bool StringifyString(std::string& str, String const& value, Options const& /*options*/)
+ParseStatus json::from_cbor(Value& value, std::string const& str, Options const& options)
 {
-    char const* const first = value.data();
-    char const* const last  = value.data() + value.size();
+    char const* next = str.data();
+    char const* last = str.data() + str.size();
 
-    bool success = true;
+    return json::from_cbor(value, next, last, options).ec;
+}
 
-    str += '"';
+//==================================================================================================
+// Pointer
+//==================================================================================================
 
-    auto const next = json::strings::SkipNonSpecial(first, last);
-    str.append(first, next);
+// Returns the array index represented by KEY, or SIZE_MAX if KEY is not a
+// valid array index.
+static size_t ToArrayIndex(String const& key)
+{
+    if (key.empty() || key.size() > 18 || (key[0] == '0' && key.size() > 1))
+        return SIZE_MAX;
 
-    if (next != last)
+    size_t index = 0;
+    for (char const ch : key)
     {
-        auto const res = strings::EscapeString(next, last, [&](char ch) { str += ch; });
-        success = res.status == strings::EscapeStringStatus::success;
+        if (ch < '0' || ch > '9')
+            return SIZE_MAX;
+        index = index * 10 + static_cast<size_t>(ch - '0');
     }
 
-    str += '"';
-
-    return success;
+    return index;
 }
 
-static bool StringifyArray(std::string& str, Array const& value, Options const& options, int curr_indent)
+// Splits the JSON Pointer STR into its (unescaped) reference tokens.
+// Returns false if STR is not a valid JSON Pointer.
+static bool SplitPointer(std::vector<String>& tokens, std::string const& str)
 {
-    str += '[';
+    if (str.empty())
+        return true;
+    if (str[0] != '/')
+        return false;
 
-    auto       I = value.begin();
-    auto const E = value.end();
-    if (I != E)
+    for (size_t i = 1; i <= str.size(); ++i)
     {
-        if (options.indent_width > 0)
+        tokens.emplace_back();
+        for ( ; i != str.size() && str[i] != '/'; ++i)
         {
-            // Prevent overflow in curr_indent + options.indent_width
-            int const indent_width = (curr_indent <= INT_MAX - options.indent_width) ? options.indent_width : 0;
-            curr_indent += indent_width;
-
-            for (;;)
+            if (str[i] != '~')
             {
-                str += '\n';
-                str.append(static_cast<size_t>(curr_indent), ' ');
+                tokens.back() += str[i];
+                continue;
+            }
 
-                if (!StringifyValue(str, *I, options, curr_indent))
-                    return false;
+            ++i;
+            if (i == str.size() || (str[i] != '0' && str[i] != '1'))
+                return false;
+            tokens.back() += (str[i] == '0') ? '~' : '/';
+        }
+    }
 
-                if (++I == E)
-                    break;
+    return true;
+}
 
-                str += ',';
-            }
+constexpr size_t Pointer::kNoIndex;
+constexpr size_t Pointer::kEndIndex;
 
-            curr_indent -= indent_width;
+Pointer::Pointer(std::string const& str)
+{
+    std::vector<String> tokens;
+    if (!SplitPointer(tokens, str))
+    {
+        valid_ = false;
+        return;
+    }
 
-            str += '\n';
-            str.append(static_cast<size_t>(curr_indent), ' ');
-        }
-        else
+    tokens_.reserve(tokens.size());
+    for (auto& t : tokens)
+    {
+        size_t const index = (t == "-") ? kEndIndex : ToArrayIndex(t);
+        tokens_.push_back({Key(std::move(t)), index});
+    }
+}
+
+std::string Pointer::to_string() const
+{
+    std::string str;
+    for (auto const& t : tokens_)
+    {
+        str += '/';
+        for (char const ch : t.key.str())
         {
-            for (;;)
-            {
-                if (!StringifyValue(str, *I, options, curr_indent))
-                    return false;
+            if (ch == '~')
+                str += "~0";
+            else if (ch == '/')
+                str += "~1";
+            else
+                str += ch;
+        }
+    }
 
-                if (++I == E)
-                    break;
+    return str;
+}
 
-                str += ',';
-                if (options.indent_width == 0)
-                    str += ' ';
-            }
-        }
+// Returns the child of V referenced by TOKEN, or nullptr.
+template <typename V, typename Token>
+static V* GetChild(V& v, Token const& token)
+{
+    if (v.is_object())
+        return v.get_ptr(token.key);
+
+    if (v.is_array())
+    {
+        if (token.index < v.size()) // NB: kNoIndex and kEndIndex are never valid.
+            return &v.get_array()[token.index];
     }
 
-    str += ']';
+    return nullptr;
+}
 
-    return true;
+Value* Pointer::get(Value& root) const
+{
+    if (!valid_)
+        return nullptr;
+
+    Value* v = &root;
+    for (auto const& t : tokens_)
+    {
+        v = GetChild(*v, t);
+        if (v == nullptr)
+            return nullptr;
+    }
+
+    return v;
 }
 
-static bool StringifyObject(std::string& str, Object const& value, Options const& options, int curr_indent)
+Value const* Pointer::get(Value const& root) const
 {
-    str += '{';
+    if (!valid_)
+        return nullptr;
 
-    auto       I = value.begin();
-    auto const E = value.end();
-    if (I != E)
+    Value const* v = &root;
+    for (auto const& t : tokens_)
     {
-        if (options.indent_width > 0)
-        {
-            // Prevent overflow in curr_indent + options.indent_width
-            int const indent_width = (curr_indent <= INT_MAX - options.indent_width) ? options.indent_width : 0;
-            curr_indent += indent_width;
+        v = GetChild(*v, t);
+        if (v == nullptr)
+            return nullptr;
+    }
 
-            for (;;)
-            {
-                str += '\n';
-                str.append(static_cast<size_t>(curr_indent), ' ');
+    return v;
+}
 
-                if (!StringifyString(str, I->first, options))
-                    return false;
-                str += ':';
-                str += ' ';
-                if (!StringifyValue(str, I->second, options, curr_indent))
-                    return false;
+Value* Pointer::set(Value& root, Value value) const
+{
+    if (!valid_)
+        return nullptr;
 
-                if (++I == E)
-                    break;
+    // As for "add" in RFC 6902, an array index must not be larger than the
+    // size of the array. Check all indices first, so that ROOT is only modified
+    // if set succeeds: once the checks passed and a new value has been created,
+    // all following reference tokens succeed.
+    Value const* existing = &root;
+    for (auto const& t : tokens_)
+    {
+        // Undefined and null values (and missing values) become empty arrays
+        // if indexed by an array index.
+        bool const is_array = existing == nullptr || !existing->is_object();
+        size_t const size = existing != nullptr && existing->is_array() ? existing->size() : 0;
+        if (is_array && t.index < kEndIndex && t.index > size)
+            return nullptr;
+
+        existing = existing != nullptr ? GetChild(*existing, t) : nullptr;
+    }
 
-                str += ',';
-            }
+    Value* v = &root;
+    for (auto const& t : tokens_)
+    {
+        if (v->is_undefined() || v->is_null())
+        {
+            if (t.index == kNoIndex)
+                *v = Value(json::object_tag);
+            else
+                *v = Value(json::array_tag);
+        }
 
-            curr_indent -= indent_width;
+        if (v->is_object())
+        {
+            v = &(*v)[t.key];
+        }
+        else if (v->is_array())
+        {
+            if (t.index == kNoIndex)
+                return nullptr;
 
-            str += '\n';
-            str.append(static_cast<size_t>(curr_indent), ' ');
+            auto& arr = v->get_array();
+            if (t.index == kEndIndex || t.index == arr.size())
+            {
+                arr.emplace_back();
+                v = &arr.back();
+            }
+            else
+            {
+                JSON_ASSERT(t.index < arr.size());
+                v = &arr[t.index];
+            }
         }
         else
         {
-            for (;;)
-            {
-                if (!StringifyString(str, I->first, options))
-                    return false;
-                str += ':';
-                if (options.indent_width == 0)
-                    str += ' ';
-                if (!StringifyValue(str, I->second, options, curr_indent))
-                    return false;
+            return nullptr;
+        }
+    }
 
-                if (++I == E)
-                    break;
+    *v = std::move(value);
+    return v;
+}
 
-                str += ',';
-                if (options.indent_width == 0)
-                    str += ' ';
-            }
-        }
+bool Pointer::erase(Value& root) const
+{
+    if (!valid_ || tokens_.empty())
+        return false;
+
+    Value* parent = &root;
+    for (auto I = tokens_.begin(), E = tokens_.end() - 1; I != E; ++I)
+    {
+        parent = GetChild(*parent, *I);
+        if (parent == nullptr)
+            return false;
     }
 
-    str += '}';
+    auto const& t = tokens_.back();
+    if (parent->is_object())
+        return parent->erase(t.key) != 0;
 
-    return true;
+    if (parent->is_array() && t.index < parent->size())
+    {
+        parent->erase(t.index);
+        return true;
+    }
+
+    return false;
 }
 
-static bool StringifyValue(std::string& str, Value const& value, Options const& options, int curr_indent)
+//==================================================================================================
+// parse (Projection)
+//==================================================================================================
+
+struct Projection::Node
 {
-    switch (value.type())
+    struct Child
     {
-    case Type::undefined:
-        JSON_ASSERT(false && "cannot stringify 'undefined'"); // LCOV_EXCL_LINE
-        return StringifyNull(str);
-    case Type::null:
-        return StringifyNull(str);
-    case Type::boolean:
-        return StringifyBoolean(str, value.get_boolean());
-    case Type::number:
-        return StringifyNumber(str, value.get_number(), options);
-    case Type::string:
-        return StringifyString(str, value.get_string(), options);
-    case Type::array:
-        return StringifyArray(str, value.get_array(), options, curr_indent);
-    case Type::object:
-        return StringifyObject(str, value.get_object(), options, curr_indent);
-    default:
-        JSON_ASSERT(false && "invalid type"); // LCOV_EXCL_LINE
+        String key;
+        size_t index; // SIZE_MAX if KEY is not an array index
+        std::unique_ptr<Node> node;
+    };
+
+    std::vector<Child> children;
+    // The highest array index of all children, or SIZE_MAX if there are none.
+    size_t max_index = SIZE_MAX;
+    // If true, the whole value is selected.
+    bool selected = false;
+
+    Node const* Find(char const* key, size_t length) const
+    {
+        for (auto const& c : children)
+        {
+            if (c.key.size() == length && std::memcmp(c.key.data(), key, length) == 0)
+                return c.node.get();
+        }
+
+        return nullptr;
+    }
+
+    Node const* Find(size_t index) const
+    {
+        for (auto const& c : children)
+        {
+            if (c.index == index)
+                return c.node.get();
+        }
+
+        return nullptr;
+    }
+};
+
+Projection::Projection()
+    : root_(new Node)
+{
+}
+
+Projection::Projection(Projection&&) noexcept = default;
+
+Projection& Projection::operator=(Projection&&) noexcept = default;
+
+Projection::~Projection()
+{
+}
+
+// Splits the JSON Pointer or dotted path PATH into its components.
+// Returns false if PATH is an invalid JSON Pointer.
+static bool SplitPath(std::vector<String>& components, std::string const& path)
+{
+    if (path.empty() || path[0] == '/')
+        return SplitPointer(components, path);
+
+    for (size_t pos = 0; ; )
+    {
+        size_t const dot = path.find('.', pos);
+        if (dot == std::string::npos)
+        {
+            components.emplace_back(path, pos);
+            return true;
+        }
+
+        components.emplace_back(path, pos, dot - pos);
+        pos = dot + 1;
+    }
+}
+
+bool Projection::add(std::string const& path)
+{
+    std::vector<String> components;
+    if (!SplitPath(components, path))
+        return false;
+
+    Node* node = root_.get();
+    for (auto& key : components)
+    {
+        if (node->selected)
+            return true;
+
+        Node* child = nullptr;
+        for (auto& c : node->children)
+        {
+            if (c.key == key)
+            {
+                child = c.node.get();
+                break;
+            }
+        }
+
+        if (child == nullptr)
+        {
+            size_t const index = ToArrayIndex(key);
+            if (index != SIZE_MAX)
+                node->max_index = (node->max_index == SIZE_MAX) ? index : std::max(node->max_index, index);
+
+            node->children.push_back({std::move(key), index, std::unique_ptr<Node>(new Node)});
+            child = node->children.back().node.get();
+        }
+
+        node = child;
+    }
+
+    node->selected = true;
+    node->children.clear();
+    node->max_index = SIZE_MAX;
+
+    return true;
+}
+
+// Forwards the parts of a value selected by a Projection to a
+// ParseValueCallbacks object.
+struct json::ProjectionCallbacks /*final*/ : ParseCallbacks
+{
+    using Node = Projection::Node;
+
+    // A partially selected array or object.
+    struct Frame
+    {
+        Node const* node;
+        bool is_array;
+        bool keep_current; // true if the current element or member is kept
+        size_t index;      // Index of the current element
+        size_t count;      // Number of elements or members forwarded since the last call to HandleEnd{Element,Member}
+    };
+
+    ParseValueCallbacks& cb;
+    Node const* root;
+    std::vector<Frame> stack;
+    int skip_depth = 0;    // > 0 while inside an array or object which is skipped
+    int forward_depth = 0; // > 0 while inside an array or object which is selected as a whole
+    // The current member of an object.
+    Node const* member_node = nullptr;
+    char const* member_key_first = nullptr;
+    char const* member_key_last = nullptr;
+    bool member_key_needs_cleaning = false;
+    String key_buffer;
+
+    ProjectionCallbacks(ParseValueCallbacks& cb_, Projection const& projection)
+        : cb(cb_)
+        , root(projection.root_.get())
+    {
+    }
+
+    enum class Action {
+        skip,
+        forward,
+        enter, // Partially selected.
+    };
+
+    // Decides what to do with the next value, and emits the key or a
+    // placeholder if necessary.
+    ParseStatus BeginValue(Action& action, Node const*& node, bool is_structured, Options const& options)
+    {
+        if (stack.empty())
+        {
+            node = root;
+            action = (node->selected || !is_structured) ? Action::forward : Action::enter;
+            return {};
+        }
+
+        auto& frame = stack.back();
+        if (frame.is_array)
+        {
+            node = frame.node->Find(frame.index);
+            if (node == nullptr || (!node->selected && !is_structured))
+            {
+                action = Action::skip;
+                if (frame.node->max_index != SIZE_MAX && frame.index <= frame.node->max_index)
+                {
+                    frame.keep_current = true;
+                    return cb.HandleNull(options);
+                }
+                return {};
+            }
+        }
+        else
+        {
+            node = member_node;
+            if (node == nullptr || (!node->selected && !is_structured))
+            {
+                action = Action::skip;
+                return {};
+            }
+
+            auto const ec = cb.HandleKey(member_key_first, member_key_last, member_key_needs_cleaning, options);
+            if (ec != ParseStatus::success)
+                return ec;
+        }
+
+        frame.keep_current = true;
+        action = node->selected ? Action::forward : Action::enter;
+        return {};
+    }
+
+    // Calls fn() if the value is kept, and skip() otherwise.
+    template <typename Fn, typename SkipFn>
+    ParseStatus HandlePrimitive(Fn fn, SkipFn skip, Options const& options)
+    {
+        if (skip_depth > 0)
+            return skip();
+        if (forward_depth > 0)
+            return fn();
+
+        Action action;
+        Node const* node;
+        auto const ec = BeginValue(action, node, /*is_structured*/ false, options);
+        if (ec != ParseStatus::success)
+            return ec;
+
+        if (action == Action::forward)
+            return fn();
+
+        return skip();
+    }
+
+    static ParseStatus Success()
+    {
+        return ParseStatus::success;
+    }
+
+    template <typename Fn>
+    ParseStatus HandleBeginStructured(bool is_array, Fn fn, Options const& options)
+    {
+        if (skip_depth > 0)
+        {
+            ++skip_depth;
+            return {};
+        }
+        if (forward_depth > 0)
+        {
+            ++forward_depth;
+            return fn();
+        }
+
+        Action action;
+        Node const* node;
+        auto const ec = BeginValue(action, node, /*is_structured*/ true, options);
+        if (ec != ParseStatus::success)
+            return ec;
+
+        switch (action)
+        {
+        case Action::skip:
+            skip_depth = 1;
+            return {};
+        case Action::forward:
+            forward_depth = 1;
+            return fn();
+        case Action::enter:
+            stack.push_back({node, is_array, false, 0, 0});
+            return fn();
+        }
+
+        return {};
+    }
+
+    template <typename Fn>
+    ParseStatus HandleEndStructured(Fn fn)
+    {
+        if (skip_depth > 0)
+        {
+            --skip_depth;
+            return {};
+        }
+        if (forward_depth > 0)
+        {
+            --forward_depth;
+            return fn(/*use_own_count*/ false);
+        }
+
+        JSON_ASSERT(!stack.empty());
+        auto const ec = fn(/*use_own_count*/ true);
+        stack.pop_back();
+        return ec;
+    }
+
+    template <typename Fn>
+    ParseStatus HandleEndChild(Fn fn)
+    {
+        if (skip_depth > 0)
+            return {};
+        if (forward_depth > 0)
+            return fn(/*use_own_count*/ false);
+
+        JSON_ASSERT(!stack.empty());
+        auto& frame = stack.back();
+
+        ParseStatus ec = ParseStatus::success;
+        if (frame.keep_current)
+        {
+            ++frame.count;
+            ec = fn(/*use_own_count*/ true);
+        }
+
+        frame.keep_current = false;
+        ++frame.index;
+        return ec;
+    }
+
+    ParseStatus HandleNull(Options const& options) override
+    {
+        return HandlePrimitive([&] { return cb.HandleNull(options); }, Success, options);
+    }
+
+    ParseStatus HandleBoolean(bool value, Options const& options) override
+    {
+        return HandlePrimitive([&] { return cb.HandleBoolean(value, options); }, Success, options);
+    }
+
+    ParseStatus HandleNumber(char const* first, char const* last, NumberClass nc, Options const& options) override
+    {
+        return HandlePrimitive([&] { return cb.HandleNumber(first, last, nc, options); }, Success, options);
+    }
+
+    ParseStatus HandleString(char const* first, char const* last, bool needs_cleaning, Options const& options) override
+    {
+        auto const validate = [&] {
+            // Strings which are not stored must still be valid.
+            if (needs_cleaning && strings::ValidateString(first, last).status != strings::UnescapeStringStatus::success)
+                return ParseStatus::invalid_string;
+            return ParseStatus::success;
+        };
+
+        return HandlePrimitive([&] { return cb.HandleString(first, last, needs_cleaning, options); }, validate, options);
+    }
+
+    ParseStatus HandleBeginArray(Options const& options) override
+    {
+        return HandleBeginStructured(/*is_array*/ true, [&] { return cb.HandleBeginArray(options); }, options);
+    }
+
+    ParseStatus HandleEndArray(size_t count, Options const& options) override
+    {
+        return HandleEndStructured([&](bool use_own_count) { return cb.HandleEndArray(use_own_count ? stack.back().count : count, options); });
+    }
+
+    ParseStatus HandleEndElement(size_t& count, Options const& options) override
+    {
+        return HandleEndChild([&](bool use_own_count) { return cb.HandleEndElement(use_own_count ? stack.back().count : count, options); });
+    }
+
+    ParseStatus HandleBeginObject(Options const& options) override
+    {
+        return HandleBeginStructured(/*is_array*/ false, [&] { return cb.HandleBeginObject(options); }, options);
+    }
+
+    ParseStatus HandleEndObject(size_t count, Options const& options) override
+    {
+        return HandleEndStructured([&](bool use_own_count) { return cb.HandleEndObject(use_own_count ? stack.back().count : count, options); });
+    }
+
+    ParseStatus HandleEndMember(size_t& count, Options const& options) override
+    {
+        return HandleEndChild([&](bool use_own_count) { return cb.HandleEndMember(use_own_count ? stack.back().count : count, options); });
+    }
+
+    ParseStatus HandleKey(char const* first, char const* last, bool needs_cleaning, Options const& options) override
+    {
+        if (skip_depth > 0)
+        {
+            if (needs_cleaning && strings::ValidateString(first, last).status != strings::UnescapeStringStatus::success)
+                return ParseStatus::invalid_string; // return ParseStatus::invalid_key;
+            return {};
+        }
+        if (forward_depth > 0)
+            return cb.HandleKey(first, last, needs_cleaning, options);
+
+        JSON_ASSERT(!stack.empty());
+        JSON_ASSERT(!stack.back().is_array);
+
+        // The key is forwarded only if the value is kept.
+        member_key_first = first;
+        member_key_last = last;
+        member_key_needs_cleaning = needs_cleaning;
+
+        if (needs_cleaning)
+        {
+            if (strings::UnescapeStringBulk(key_buffer, first, last).status != strings::UnescapeStringStatus::success)
+                return ParseStatus::invalid_string; // return ParseStatus::invalid_key;
+
+            member_node = stack.back().node->Find(key_buffer.data(), key_buffer.size());
+        }
+        else
+        {
+            member_node = stack.back().node->Find(first, static_cast<size_t>(last - first));
+        }
+
         return {};
     }
+};
+
+ParseResult json::parse(Value& value, Projection const& projection, char const* next, char const* last, Options const& options)
+{
+    ParseValueCallbacks value_cb;
+    ProjectionCallbacks cb(value_cb, projection);
+
+    auto const res = json::parse(cb, next, last, options);
+    if (res.ec == ParseStatus::success)
+    {
+        JSON_ASSERT(value_cb.stack.size() == 1);
+        value = std::move(value_cb.stack.back());
+    }
+
+    return res;
 }
 
-bool json::stringify(std::string& str, Value const& value, Options const& options)
+ParseStatus json::parse(Value& value, Projection const& projection, std::string const& str, Options const& options)
 {
-    return StringifyValue(str, value, options, 0);
+    char const* next = str.data();
+    char const* last = str.data() + str.size();
+
+    return json::parse(value, projection, next, last, options).ec;
+}
+
+//==================================================================================================
+// stringify
+//==================================================================================================
+
+// Appends the ASCII string s to str.
+static void AppendASCII(std::string& str, char const* s)
+{
+    str += s;
+}
+
+static void AppendASCII(std::u16string& str, char const* s)
+{
+    for ( ; *s != '\0'; ++s)
+    {
+        str += static_cast<char16_t>(*s);
+    }
+}
+
+// Appends the (valid) UTF-8 string [first, last) to str.
+static void AppendUTF8(std::string& str, char const* first, char const* last)
+{
+    str.append(first, last);
+}
+
+// Converts the (valid) UTF-8 string [first, last) to UTF-16 and appends the
+// result to str.
+static void AppendUTF8(std::u16string& str, char const* first, char const* last)
+{
+    while (first != last)
+    {
+        if (static_cast<unsigned char>(*first) < 0x80)
+        {
+            str += static_cast<char16_t>(*first);
+            ++first;
+            continue;
+        }
+
+        uint32_t U = 0;
+        first = unicode::DecodeUTF8Sequence(first, last, U);
+        JSON_ASSERT(U != unicode::kInvalidCodepoint);
+
+        unicode::EncodeUTF16(U, [&](uint16_t code_unit) { str += static_cast<char16_t>(code_unit); });
+    }
+}
+
+template <typename Str>
+static bool StringifyValue(Str& str, Value const& value, Options const& options, int curr_indent);
+
+template <typename Str>
+static bool StringifyNull(Str& str)
+{
+    AppendASCII(str, "null");
+    return true;
+}
+
+template <typename Str>
+static bool StringifyBoolean(Str& str, bool value)
+{
+    AppendASCII(str, value ? "true" : "false");
+    return true;
+}
+
+template <typename Str>
+static bool StringifyNumber(Str& str, double value, Options const& options)
+{
+    if (!std::isfinite(value))
+    {
+        if (!options.allow_nan_inf)
+        {
+            AppendASCII(str, "null");
+        }
+        else if (std::isnan(value))
+        {
+            AppendASCII(str, "NaN");
+        }
+        else
+        {
+            if (value < 0)
+                str += '-';
+
+            AppendASCII(str, "Infinity");
+        }
+    }
+#if 0
+    else if (value == 0.0)
+    {
+        // Handle +-0.
+        // Interpret -0 as a floating-point number and +0 as an integer.
+
+        if (std::signbit(value))
+            AppendASCII(str, "-0.0");
+        else
+            str += '0';
+    }
+#endif
+    else
+    {
+        char buf[32];
+        char* end = numbers::NumberToString(buf, buf + 32, value, /*emit_trailing_dot_zero*/ true);
+
+        str.append(buf, end);
+    }
+
+    return true;
+}
+
+template <typename Str>
+static bool StringifyString(Str& str, String const& value, Options const& options)
+{
+    char const* const first = value.data();
+    char const* const last  = value.data() + value.size();
+
+    bool success = true;
+
+    str += '"';
+
+    auto const next = json::strings::SkipNonSpecial(first, last);
+    str.append(first, next);
+
+    if (next != last)
+    {
+        auto const res = strings::EscapeStringBulk(next, last, [&](char const* f, char const* l) { AppendUTF8(str, f, l); }, options.ascii_only);
+        success = res.status == strings::EscapeStringStatus::success;
+    }
+
+    str += '"';
+
+    return success;
+}
+
+// Returns whether the escaped string value contains a "</" or an unescaped
+// U+2028 or U+2029, which StringifyString would escape.
+static bool NeedsReEscaping(String const& value)
+{
+    char const* const first = value.data();
+    char const* const last  = value.data() + value.size();
+
+    for (auto p = first; ; ++p)
+    {
+        p = static_cast<char const*>(std::memchr(p, '/', static_cast<size_t>(last - p)));
+        if (p == nullptr)
+            break;
+        if (p != first && p[-1] == '<')
+            return true;
+    }
+
+    // U+2028 and U+2029 are encoded as E2 80 A8 and E2 80 A9, resp.
+    for (auto p = first; ; ++p)
+    {
+        p = static_cast<char const*>(std::memchr(p, 0xE2, static_cast<size_t>(last - p)));
+        if (p == nullptr)
+            break;
+        if (last - p >= 3 && p[1] == '\x80' && (p[2] == '\xA8' || p[2] == '\xA9'))
+            return true;
+    }
+
+    return false;
+}
+
+static bool IsASCII(String const& value)
+{
+    return std::all_of(value.begin(), value.end(), [](char ch) { return static_cast<unsigned char>(ch) < 0x80; });
+}
+
+template <typename Str>
+static bool StringifyEscapedString(Str& str, String const& value, Options const& options)
+{
+    if (NeedsReEscaping(value) || (options.ascii_only && !IsASCII(value)))
+    {
+        String unescaped;
+        if (strings::UnescapeStringBulk(unescaped, value.data(), value.data() + value.size()).status != strings::UnescapeStringStatus::success)
+            return false;
+
+        return StringifyString(str, unescaped, options);
+    }
+
+    // The string is still escaped and can be copied as-is.
+    str += '"';
+    AppendUTF8(str, value.data(), value.data() + value.size());
+    str += '"';
+
+    return true;
+}
+
+template <typename Str>
+static bool StringifyArray(Str& str, Array const& value, Options const& options, int curr_indent)
+{
+    str += '[';
+
+    auto       I = value.begin();
+    auto const E = value.end();
+    if (I != E)
+    {
+        if (options.indent_width > 0)
+        {
+            // Prevent overflow in curr_indent + options.indent_width
+            int const indent_width = (curr_indent <= INT_MAX - options.indent_width) ? options.indent_width : 0;
+            curr_indent += indent_width;
+
+            for (;;)
+            {
+                str += '\n';
+                str.append(static_cast<size_t>(curr_indent), ' ');
+
+                if (!StringifyValue(str, *I, options, curr_indent))
+                    return false;
+
+                if (++I == E)
+                    break;
+
+                str += ',';
+            }
+
+            curr_indent -= indent_width;
+
+            str += '\n';
+            str.append(static_cast<size_t>(curr_indent), ' ');
+        }
+        else
+        {
+            for (;;)
+            {
+                if (!StringifyValue(str, *I, options, curr_indent))
+                    return false;
+
+                if (++I == E)
+                    break;
+
+                str += ',';
+                if (options.indent_width == 0)
+                    str += ' ';
+            }
+        }
+    }
+
+    str += ']';
+
+    return true;
+}
+
+template <typename Str>
+static bool StringifyObject(Str& str, Object const& value, Options const& options, int curr_indent)
+{
+    str += '{';
+
+    auto       I = value.begin();
+    auto const E = value.end();
+    if (I != E)
+    {
+        if (options.indent_width > 0)
+        {
+            // Prevent overflow in curr_indent + options.indent_width
+            int const indent_width = (curr_indent <= INT_MAX - options.indent_width) ? options.indent_width : 0;
+            curr_indent += indent_width;
+
+            for (;;)
+            {
+                str += '\n';
+                str.append(static_cast<size_t>(curr_indent), ' ');
+
+                if (!StringifyString(str, I->first, options))
+                    return false;
+                str += ':';
+                str += ' ';
+                if (!StringifyValue(str, I->second, options, curr_indent))
+                    return false;
+
+                if (++I == E)
+                    break;
+
+                str += ',';
+            }
+
+            curr_indent -= indent_width;
+
+            str += '\n';
+            str.append(static_cast<size_t>(curr_indent), ' ');
+        }
+        else
+        {
+            for (;;)
+            {
+                if (!StringifyString(str, I->first, options))
+                    return false;
+                str += ':';
+                if (options.indent_width == 0)
+                    str += ' ';
+                if (!StringifyValue(str, I->second, options, curr_indent))
+                    return false;
+
+                if (++I == E)
+                    break;
+
+                str += ',';
+                if (options.indent_width == 0)
+                    str += ' ';
+            }
+        }
+    }
+
+    str += '}';
+
+    return true;
+}
+
+template <typename Str>
+static bool StringifyValue(Str& str, Value const& value, Options const& options, int curr_indent)
+{
+    switch (value.type())
+    {
+    case Type::undefined:
+        JSON_ASSERT(false && "cannot stringify 'undefined'"); // LCOV_EXCL_LINE
+        return StringifyNull(str);
+    case Type::null:
+        return StringifyNull(str);
+    case Type::boolean:
+        return StringifyBoolean(str, value.get_boolean());
+    case Type::number:
+        return StringifyNumber(str, value.get_number(), options);
+    case Type::string:
+        if (value.is_escaped_string())
+            return StringifyEscapedString(str, value.get_escaped_string(), options);
+        return StringifyString(str, value.get_string(), options);
+    case Type::array:
+        return StringifyArray(str, value.get_array(), options, curr_indent);
+    case Type::object:
+        return StringifyObject(str, value.get_object(), options, curr_indent);
+    default:
+        JSON_ASSERT(false && "invalid type"); // LCOV_EXCL_LINE
+        return {};
+    }
+}
+
+bool json::stringify(std::string& str, Value const& value, Options const& options)
+{
+    return StringifyValue(str, value, options, 0);
+}
+
+bool json::stringify(std::u16string& str, Value const& value, Options const& options)
+{
+    return StringifyValue(str, value, options, 0);
+}
+
+//==================================================================================================
+// stringify_parallel
+//==================================================================================================
+
+static void StringifyElementSeparator(std::string& str, bool first, Options const& options, int indent)
+{
+    if (!first)
+    {
+        str += ',';
+        if (options.indent_width == 0)
+            str += ' ';
+    }
+
+    if (options.indent_width > 0)
+    {
+        str += '\n';
+        str.append(static_cast<size_t>(indent), ' ');
+    }
+}
+
+// Stringify the array elements [I, E), including the separators. The output
+// matches the corresponding part of the output of StringifyArray.
+static bool StringifyElements(std::string& str, Value const* I, Value const* E, bool first, Options const& options, int indent)
+{
+    for ( ; I != E; ++I, first = false)
+    {
+        StringifyElementSeparator(str, first, options, indent);
+
+        if (!StringifyValue(str, *I, options, indent))
+            return false;
+    }
+
+    return true;
+}
+
+// Stringify the object members [I, E), including the separators. The output
+// matches the corresponding part of the output of StringifyObject.
+static bool StringifyMembers(std::string& str, Object::value_type const* const* I, Object::value_type const* const* E, bool first, Options const& options, int indent)
+{
+    for ( ; I != E; ++I, first = false)
+    {
+        StringifyElementSeparator(str, first, options, indent);
+
+        if (!StringifyString(str, (*I)->first, options))
+            return false;
+        str += ':';
+        if (options.indent_width >= 0)
+            str += ' ';
+        if (!StringifyValue(str, (*I)->second, options, indent))
+            return false;
+    }
+
+    return true;
+}
+
+// The number of chunks per thread used by the parallel algorithms below.
+// Using more than one chunk per thread balances the load if the chunks take
+// different amounts of time, e.g. elements of different sizes or lines of
+// different lengths.
+static constexpr size_t kChunksPerThread = 8;
+
+// Calls fn(chunk_index, thread_index) for all chunk_index in [0, num_chunks)
+// using up to num_threads threads (including the calling thread, which has
+// thread_index 0).
+template <typename Fn>
+static void ParallelFor(size_t num_chunks, int num_threads, Fn fn)
+{
+    std::atomic<size_t> next_chunk{0};
+    std::exception_ptr error;
+    std::atomic<bool> failed{false};
+
+    auto const worker = [&](std::exception_ptr& ep, size_t thread_index) {
+        try
+        {
+            for (;;)
+            {
+                size_t const i = next_chunk.fetch_add(1);
+                if (i >= num_chunks || failed.load(std::memory_order_relaxed))
+                    break;
+                fn(i, thread_index);
+            }
+        }
+        catch (...)
+        {
+            ep = std::current_exception();
+            failed = true;
+        }
+    };
+
+    size_t const num_workers = std::min(static_cast<size_t>(num_threads) - 1, num_chunks - 1);
+
+    std::vector<std::exception_ptr> errors(num_workers);
+    std::vector<std::thread> threads;
+    threads.reserve(num_workers);
+    for (size_t i = 0; i != num_workers; ++i)
+    {
+        try
+        {
+            threads.emplace_back(worker, std::ref(errors[i]), 1 + i);
+        }
+        catch (std::system_error const&)
+        {
+            // Could not start another thread, e.g. because the system is out
+            // of threads. The threads started so far (and the calling thread)
+            // process the remaining chunks.
+            break;
+        }
+    }
+
+    worker(error, 0);
+
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+    for (auto const& ep : errors)
+    {
+        if (ep)
+            std::rethrow_exception(ep);
+    }
+}
+
+bool json::stringify_parallel(std::string& str, Value const& value, Options const& options, int num_threads)
+{
+    if (num_threads <= 0)
+        num_threads = static_cast<int>(std::thread::hardware_concurrency());
+
+    size_t const size = value.is_structured() ? value.size() : 0;
+    if (num_threads <= 1 || size < 2)
+        return StringifyValue(str, value, options, 0);
+
+    size_t const num_chunks = std::min(size, static_cast<size_t>(num_threads) * kChunksPerThread);
+
+    // The elements are at indentation level 1.
+    int const indent = options.indent_width > 0 ? options.indent_width : 0;
+
+    std::vector<std::string> chunks(num_chunks);
+    std::unique_ptr<bool[]> chunk_ok(new bool[num_chunks]);
+
+    auto const chunk_begin = [&](size_t i) { return size / num_chunks * i + std::min(i, size % num_chunks); };
+
+    if (value.is_array())
+    {
+        Value const* const elements = value.get_array().data();
+
+        ParallelFor(num_chunks, num_threads, [&](size_t i, size_t /*thread_index*/) {
+            chunk_ok[i] = StringifyElements(chunks[i], elements + chunk_begin(i), elements + chunk_begin(i + 1), i == 0, options, indent);
+        });
+    }
+    else
+    {
+        std::vector<Object::value_type const*> members;
+        members.reserve(size);
+        for (auto const& m : value.get_object())
+        {
+            members.push_back(&m);
+        }
+
+        ParallelFor(num_chunks, num_threads, [&](size_t i, size_t /*thread_index*/) {
+            chunk_ok[i] = StringifyMembers(chunks[i], members.data() + chunk_begin(i), members.data() + chunk_begin(i + 1), i == 0, options, indent);
+        });
+    }
+
+    size_t total_size = 2 + (options.indent_width > 0 ? 1 : 0);
+    for (size_t i = 0; i != num_chunks; ++i)
+    {
+        if (!chunk_ok[i])
+            return false;
+        total_size += chunks[i].size();
+    }
+
+    str.reserve(str.size() + total_size);
+
+    str += value.is_array() ? '[' : '{';
+    for (auto const& chunk : chunks)
+    {
+        str += chunk;
+    }
+    if (options.indent_width > 0)
+        str += '\n';
+    str += value.is_array() ? ']' : '}';
+
+    return true;
+}
+
+//==================================================================================================
+// parse_lines
+//==================================================================================================
+
+// Splits [next, last) into (at most) num_chunks ranges of roughly equal size,
+// which start at the beginning of a line.
+// Returns the boundaries of the ranges.
+static std::vector<char const*> SplitLines(char const* next, char const* last, size_t num_chunks)
+{
+    JSON_ASSERT(num_chunks >= 1);
+
+    size_t const size = static_cast<size_t>(last - next);
+
+    std::vector<char const*> bounds;
+    bounds.push_back(next);
+
+    for (size_t i = 1; i < num_chunks; ++i)
+    {
+        char const* p = std::max(bounds.back(), next + size / num_chunks * i);
+
+        auto const nl = static_cast<char const*>(std::memchr(p, '\n', static_cast<size_t>(last - p)));
+        if (nl == nullptr)
+            break;
+
+        p = nl + 1;
+        if (p != last)
+            bounds.push_back(p);
+    }
+
+    bounds.push_back(last);
+
+    return bounds;
+}
+
+static bool IsBlankLine(char const* first, char const* last)
+{
+    for ( ; first != last; ++first)
+    {
+        if (*first != ' ' && *first != '\t' && *first != '\r')
+            return false;
+    }
+
+    return true;
+}
+
+// Calls fn(line_first, line_last) for all non-blank lines in [first, last).
+// Stops at the first error.
+template <typename Fn>
+static ParseResult ParseLines(char const* first, char const* last, Fn fn)
+{
+    while (first != last)
+    {
+        auto const nl = static_cast<char const*>(std::memchr(first, '\n', static_cast<size_t>(last - first)));
+        auto const line_last = (nl != nullptr) ? nl : last;
+
+        if (!IsBlankLine(first, line_last))
+        {
+            auto const res = fn(first, line_last);
+            if (res.ec != ParseStatus::success)
+                return res;
+        }
+
+        first = (nl != nullptr) ? nl + 1 : last;
+    }
+
+    return {ParseStatus::success, last, last};
+}
+
+static int NumThreadsOrDefault(int num_threads)
+{
+    if (num_threads <= 0)
+        num_threads = static_cast<int>(std::thread::hardware_concurrency());
+    if (num_threads <= 0)
+        num_threads = 1;
+
+    return num_threads;
+}
+
+// Calls parse_chunk(chunk_index, thread_index, first, last) for the chunks
+// defined by BOUNDS, using up to num_threads threads.
+// Returns the error for the first invalid chunk.
+template <typename Fn>
+static ParseResult ParseChunksParallel(std::vector<char const*> const& bounds, int num_threads, Fn parse_chunk)
+{
+    JSON_ASSERT(bounds.size() >= 2);
+
+    size_t const num_chunks = bounds.size() - 1;
+    char const* const last = bounds.back();
+
+    std::vector<ParseResult> results(num_chunks, ParseResult{ParseStatus::success, last, last});
+
+    // Chunks after the first invalid chunk need not be parsed.
+    std::atomic<size_t> first_error{SIZE_MAX};
+
+    ParallelFor(num_chunks, num_threads, [&](size_t i, size_t thread_index) {
+        if (i > first_error.load(std::memory_order_relaxed))
+            return;
+
+        results[i] = parse_chunk(i, thread_index, bounds[i], bounds[i + 1]);
+
+        if (results[i].ec != ParseStatus::success)
+        {
+            size_t e = first_error.load(std::memory_order_relaxed);
+            while (i < e && !first_error.compare_exchange_weak(e, i, std::memory_order_relaxed))
+            {
+            }
+        }
+    });
+
+    for (auto const& res : results)
+    {
+        if (res.ec != ParseStatus::success)
+            return res;
+    }
+
+    return {ParseStatus::success, last, last};
+}
+
+ParseResult json::parse_lines(std::vector<Value>& values, char const* next, char const* last, Options const& options, int num_threads)
+{
+    num_threads = NumThreadsOrDefault(num_threads);
+
+    Options line_options = options;
+    line_options.allow_trailing_characters = false;
+
+    auto const bounds = SplitLines(next, last, static_cast<size_t>(num_threads) * kChunksPerThread);
+
+    std::vector<std::vector<Value>> chunks(bounds.size() - 1);
+
+    auto const res = ParseChunksParallel(bounds, num_threads, [&](size_t i, size_t /*thread_index*/, char const* first, char const* chunk_last) {
+        ParseValueCallbacks cb;
+
+        return ParseLines(first, chunk_last, [&](char const* line_first, char const* line_last) {
+            cb.stack.clear();
+            cb.keys.clear();
+
+            auto const line_res = json::parse(cb, line_first, line_last, line_options);
+            if (line_res.ec == ParseStatus::success)
+            {
+                JSON_ASSERT(cb.stack.size() == 1);
+                chunks[i].push_back(std::move(cb.stack.back()));
+            }
+
+            return line_res;
+        });
+    });
+
+    if (res.ec != ParseStatus::success)
+        return res;
+
+    size_t total_size = values.size();
+    for (auto const& chunk : chunks)
+    {
+        total_size += chunk.size();
+    }
+
+    values.reserve(total_size);
+    for (auto& chunk : chunks)
+    {
+        values.insert(values.end(), std::make_move_iterator(chunk.begin()), std::make_move_iterator(chunk.end()));
+    }
+
+    return res;
+}
+
+ParseStatus json::parse_lines(std::vector<Value>& values, std::string const& str, Options const& options, int num_threads)
+{
+    char const* next = str.data();
+    char const* last = str.data() + str.size();
+
+    return json::parse_lines(values, next, last, options, num_threads).ec;
+}
+
+ParseResult json::parse_lines(ParseCallbacks* const* callbacks, int num_callbacks, char const* next, char const* last, Options const& options)
+{
+    JSON_ASSERT(num_callbacks >= 1);
+
+    Options line_options = options;
+    line_options.allow_trailing_characters = false;
+
+    auto const bounds = SplitLines(next, last, static_cast<size_t>(num_callbacks) * kChunksPerThread);
+
+    return ParseChunksParallel(bounds, num_callbacks, [&](size_t /*i*/, size_t thread_index, char const* first, char const* chunk_last) {
+        auto& cb = *callbacks[thread_index];
+
+        return ParseLines(first, chunk_last, [&](char const* line_first, char const* line_last) {
+            return json::parse(cb, line_first, line_last, line_options);
+        });
+    });
+}
+
+//==================================================================================================
+// parse_parallel
+//==================================================================================================
+
+// Must match Parser::kMaxDepth.
+static constexpr int kMaxParseDepth = 500;
+
+static char const* SkipWhitespace(char const* next, char const* last)
+{
+    for ( ; next != last; ++next)
+    {
+        if (*next != ' ' && *next != '\t' && *next != '\n' && *next != '\r')
+            break;
+    }
+
+    return next;
+}
+
+// Scans the array starting at NEXT (which must point to a '[') for its
+// closing bracket, which is stored in CLOSE. Only strings and the nesting of
+// brackets and braces are tracked, the input is not validated otherwise.
+// The positions of top-level commas after each position in SPLIT_POINTS
+// (which must be sorted) are appended to BOUNDS.
+// Returns false if the closing bracket could not be found (or is a '}'), or if
+// the nesting is too deep.
+static bool ScanArray(char const*& close, std::vector<char const*>& bounds, char const* next, char const* last, std::vector<char const*> const& split_points)
+{
+    JSON_ASSERT(next != last);
+    JSON_ASSERT(*next == '[');
+
+    auto split = split_points.begin();
+
+    int depth = 0;
+    for ( ; next != last; ++next)
+    {
+        switch (*next)
+        {
+        case '"':
+            for (++next; ; ++next)
+            {
+                if (next == last)
+                    return false;
+                if (*next == '"')
+                    break;
+                if (*next == '\\')
+                {
+                    ++next;
+                    if (next == last)
+                        return false;
+                }
+            }
+            break;
+        case '[':
+        case '{':
+            if (++depth >= kMaxParseDepth)
+                return false;
+            break;
+        case ']':
+        case '}':
+            if (--depth == 0)
+            {
+                // The elements are validated by the parser, but the closing
+                // bracket of the array itself is not.
+                if (*next != ']')
+                    return false;
+
+                close = next;
+                return true;
+            }
+            break;
+        case ',':
+            if (depth == 1 && split != split_points.end() && next >= *split)
+            {
+                bounds.push_back(next);
+                while (split != split_points.end() && next >= *split)
+                    ++split;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    return false;
+}
+
+// Parses the elements [first, last) of an array into VALUES.
+// Unless FIRST is the start of the array, it must point to a ',' which
+// separates the elements from the previous chunk.
+// Returns false if the elements are invalid.
+static bool ParseElements(std::vector<Value>& values, ParseValueCallbacks& cb, char const* first, char const* last, bool is_first_chunk, bool is_last_chunk, Options const& options)
+{
+    if (!is_first_chunk)
+    {
+        JSON_ASSERT(*first == ',');
+        ++first;
+    }
+
+    // Parse single values, and check for separating commas here.
+    Options element_options = options;
+    element_options.skip_bom = false;
+    element_options.allow_trailing_characters = true;
+
+    for (;;)
+    {
+        first = SkipWhitespace(first, last);
+        if (first == last)
+        {
+            if (is_first_chunk && values.empty())
+                return is_last_chunk; // "[]"
+            else
+                return is_last_chunk && options.allow_trailing_comma; // "[1,]"
+        }
+
+        cb.stack.clear();
+        cb.keys.clear();
+
+        auto const res = json::parse(cb, first, last, element_options);
+        if (res.ec != ParseStatus::success)
+            return false;
+
+        JSON_ASSERT(cb.stack.size() == 1);
+        values.push_back(std::move(cb.stack.back()));
+
+        first = SkipWhitespace(res.ptr, last);
+        if (first == last)
+            return true;
+        if (*first != ',')
+            return false;
+
+        ++first;
+    }
+}
+
+ParseResult json::parse_parallel(Value& value, char const* next, char const* last, Options const& options, int num_threads)
+{
+    num_threads = NumThreadsOrDefault(num_threads);
+
+    char const* first = next;
+    if (options.skip_bom)
+    {
+        if (last - first >= 3 && std::memcmp(first, "\xEF\xBB\xBF", 3) == 0)
+            first += 3;
+    }
+    first = SkipWhitespace(first, last);
+
+    if (num_threads <= 1 || options.strip_comments || first == last || *first != '[')
+        return json::parse(value, next, last, options);
+
+    size_t const size = static_cast<size_t>(last - first);
+    size_t const num_chunks = static_cast<size_t>(num_threads) * kChunksPerThread;
+
+    std::vector<char const*> split_points;
+    for (size_t i = 1; i < num_chunks; ++i)
+    {
+        split_points.push_back(first + size / num_chunks * i);
+    }
+
+    char const* close = nullptr;
+
+    std::vector<char const*> bounds;
+    bounds.push_back(first + 1);
+    if (!ScanArray(close, bounds, first, last, split_points))
+        return json::parse(value, next, last, options);
+    bounds.push_back(close);
+
+    // Check for trailing characters. The position of the next token is
+    // reported exactly as by the parser.
+    auto const trailing = lexer::Lexer<char>(close + 1, last).Lex(options);
+    if (trailing.kind != lexer::TokenKind::eof && !options.allow_trailing_characters)
+        return json::parse(value, next, last, options);
+
+    std::vector<std::vector<Value>> chunks(bounds.size() - 1);
+
+    auto const res = ParseChunksParallel(bounds, num_threads, [&](size_t i, size_t /*thread_index*/, char const* chunk_first, char const* chunk_last) {
+        ParseValueCallbacks cb;
+
+        bool const is_first_chunk = (i == 0);
+        bool const is_last_chunk = (i == chunks.size() - 1);
+        if (!ParseElements(chunks[i], cb, chunk_first, chunk_last, is_first_chunk, is_last_chunk, options))
+            return ParseResult{ParseStatus::invalid_value, chunk_first, chunk_last};
+
+        return ParseResult{ParseStatus::success, chunk_last, chunk_last};
+    });
+
+    // Parse again to get the correct error.
+    if (res.ec != ParseStatus::success)
+        return json::parse(value, next, last, options);
+
+    size_t total_size = 0;
+    for (auto const& chunk : chunks)
+    {
+        total_size += chunk.size();
+    }
+
+    Array arr;
+    arr.reserve(total_size);
+    for (auto& chunk : chunks)
+    {
+        arr.insert(arr.end(), std::make_move_iterator(chunk.begin()), std::make_move_iterator(chunk.end()));
+    }
+
+    value = std::move(arr);
+
+    return {ParseStatus::success, trailing.ptr, trailing.end};
+}
+
+ParseStatus json::parse_parallel(Value& value, std::string const& str, Options const& options, int num_threads)
+{
+    char const* next = str.data();
+    char const* last = str.data() + str.size();
+
+    return json::parse_parallel(value, next, last, options, num_threads).ec;
 }
@@ -26,6 +26,7 @@
 #include <cstdint>
 #include <functional>
 #include <map>
+#include <memory>
 #include <string>
 #include <type_traits>
 #include <utility>
@@ -165,6 +166,24 @@ struct DefaultTraits_object {
     template <typename V> static decltype(auto) from_json(V&& in) { return std::forward<V>(in).get_object(); }
 };
 
+// Returns the double-precision number closest to the shortest decimal
+// representation of VALUE, i.e. numbers::StringToNumber(numbers::FloatToString(VALUE)).
+double FloatToNumber(float value);
+
+// Returns the single-precision number closest to the shortest decimal
+// representation of VALUE, i.e. numbers::StringToFloat(numbers::NumberToString(VALUE)).
+float NumberToFloat(double value);
+
+// Single-precision numbers are stored as the double-precision number which is
+// closest to their shortest decimal representation. Stringifying such a value
+// produces the same (short) output as numbers::FloatToString, and converting
+// back to float recovers the original value.
+struct DefaultTraits_float {
+    using tag = Tag_number;
+    static double to_json(float in) { return FloatToNumber(in); }
+    template <typename V> static float from_json(V&& in) { return NumberToFloat(std::forward<V>(in).get_number()); }
+};
+
 template <typename T, typename /*Enable*/ = void>
 struct DefaultTraits
 {
@@ -183,7 +202,7 @@ struct DefaultTraits<Value>
 template <> struct DefaultTraits<std::nullptr_t    > : DefaultTraits_null    {};
 template <> struct DefaultTraits<bool              > : DefaultTraits_boolean {};
 template <> struct DefaultTraits<double            > : DefaultTraits_number  {};
-template <> struct DefaultTraits<float             > : DefaultTraits_number  {};
+template <> struct DefaultTraits<float             > : DefaultTraits_float   {};
 template <> struct DefaultTraits<signed char       > : DefaultTraits_number  {};
 template <> struct DefaultTraits<signed short      > : DefaultTraits_number  {};
 template <> struct DefaultTraits<signed int        > : DefaultTraits_number  {};
@@ -271,6 +290,45 @@ using TargetTypeFor = typename impl::TargetType<TagFor<T>::value>::type;
 template <typename T>
 using ToJsonResultTypeFor = decltype(( TraitsFor<T>::to_json(std::declval<T>()) ));
 
+// A pre-processed object key for frequent lookups:
+//
+//      static json::Key const kName("name");
+//      ...
+//      if (auto* name = request.get_ptr(kName)) { ... }
+//
+// Objects are ordered maps, so a lookup still requires O(log n) key
+// comparisons. But most comparisons with a Key are decided by the first
+// character, which is stored in the Key and compared inline, before falling
+// back to the full string comparison.
+class Key final
+{
+    String str_;
+    unsigned char first_ = 0;
+
+public:
+    explicit Key(String str)
+        : str_(std::move(str))
+        , first_(static_cast<unsigned char>(str_.data()[0]))
+    {
+    }
+
+    String const& str() const noexcept { return str_; }
+
+    // Returns <0, 0, or >0, like String::compare.
+    int compare(String const& str) const noexcept
+    {
+        // NB: str.data()[str.size()] == '\0'
+        unsigned char const c = static_cast<unsigned char>(str.data()[0]);
+        if (first_ != c)
+            return first_ < c ? -1 : 1;
+
+        return str_.compare(str);
+    }
+
+    friend bool operator<(Key const& lhs, String const& rhs) noexcept { return lhs.compare(rhs) < 0; }
+    friend bool operator<(String const& lhs, Key const& rhs) noexcept { return rhs.compare(lhs) > 0; }
+};
+
 class Value final
 {
     union Data {
@@ -283,6 +341,10 @@ class Value final
 
     Data data_;
     Type type_ = Type::undefined;
+    // If true, data_.string holds the escaped contents of a JSON string, which
+    // are unescaped on first access (see Options::lazy_string_unescaping).
+    // Mutable, since const access unescapes in place, too.
+    mutable bool escaped_ = false;
 
     static Value const kUndefined;
 
@@ -300,6 +362,7 @@ public:
     Value(Value&& rhs) noexcept
         : data_(rhs.data_)
         , type_(std::exchange(rhs.type_, Type::undefined))
+        , escaped_(std::exchange(rhs.escaped_, false))
     {
     }
 
@@ -429,6 +492,11 @@ public:
     String& assign(Tag_string, String const& value);
     String& assign(Tag_string, String&& value);
 
+    // Assigns the escaped contents of a JSON string (without the enclosing
+    // quotes). The string is unescaped on first access through get_string().
+    // PRE: value is a valid JSON string, e.g. as checked by strings::ValidateString.
+    void assign_escaped(Tag_string, String&& value);
+
     // array
 
     Array& assign(Tag_array);
@@ -450,6 +518,7 @@ public:
 
         data_ = rhs.data_;
         type_ = std::exchange(rhs.type_, Type::undefined);
+        escaped_ = std::exchange(rhs.escaped_, false);
         return *this;
     }
 
@@ -483,6 +552,8 @@ public:
 private:
     void _clear()
     {
+        escaped_ = false;
+
         if (type_ < Type::string) {
             type_ = Type::undefined;
             return;
@@ -492,6 +563,7 @@ private:
     }
 
     void _clear_allocated();
+    void _unescape_string() const noexcept;
     template <typename T> String& _assign_string(T&& value);
     template <typename T> Array&  _assign_array (T&& value);
     template <typename T> Object& _assign_object(T&& value);
@@ -558,21 +630,46 @@ public:
     String& get_string() & noexcept
     {
         JSON_ASSERT(is_string());
+        if (escaped_)
+            _unescape_string();
         return *data_.string;
     }
 
+    // If the string is still escaped, it is unescaped in place, so that const
+    // access always returns the unescaped contents. This is not thread-safe:
+    // see Options::lazy_string_unescaping.
     String const& get_string() const& noexcept
     {
         JSON_ASSERT(is_string());
+        if (escaped_)
+            _unescape_string();
         return *data_.string;
     }
 
     String get_string() && noexcept
     {
         JSON_ASSERT(is_string());
+        if (escaped_)
+            _unescape_string();
         return std::move(*data_.string);
     }
 
+    // Returns whether this JSON object holds a string which has not yet been
+    // unescaped (see Options::lazy_string_unescaping).
+    bool is_escaped_string() const noexcept
+    {
+        return is_string() && escaped_;
+    }
+
+    // Returns the contents of the string as they appear in the JSON source,
+    // i.e. still escaped and without the enclosing quotes.
+    // PRE: is_escaped_string() == true
+    String const& get_escaped_string() const noexcept
+    {
+        JSON_ASSERT(is_escaped_string());
+        return *data_.string;
+    }
+
     Array& get_array() & noexcept
     {
         JSON_ASSERT(is_array());
@@ -853,10 +950,11 @@ public:
     // PRE: is_undefined() or is_object()
     Value& operator[](Object::key_type const& key);
     Value& operator[](Object::key_type&& key);
+    Value& operator[](Key const& key);
 
     // Convert this value into an object and return a reference to the value with the given key.
     // PRE: is_undefined() or is_object()
-    template <typename T, std::enable_if_t< !IsObjectKeyType<T>::value && IsTransparentKey<T>::value, int > = 0>
+    template <typename T, std::enable_if_t< !IsObjectKeyType<T>::value && !std::is_same<Key, std::decay_t<T>>::value && IsTransparentKey<T>::value, int > = 0>
     Value& operator[](T&& key)
     {
         auto& obj = _get_or_assign_object();
@@ -947,12 +1045,16 @@ public:
 
     // Erase the the given key.
     // PRE: is_object()
-    template <typename T, std::enable_if_t< IsTransparentKey<T>::value && !std::is_convertible<T, const_item_iterator>::value, int > = 0>
+    template <typename T, std::enable_if_t< IsTransparentKey<T>::value && !std::is_convertible<T, const_item_iterator>::value && !std::is_same<Key, std::decay_t<T>>::value, int > = 0>
     size_t erase(T&& key)
     {
         return get_object().erase(std::forward<T>(key));
     }
 
+    // Erase the the given key.
+    // PRE: is_object()
+    size_t erase(Key const& key);
+
     // Erase the the given key.
     // PRE: is_object()
     item_iterator erase(const_item_iterator pos);
@@ -1403,6 +1505,69 @@ struct TestConversionToJson
 {
 };
 
+//==================================================================================================
+//==================================================================================================
+// Pointer
+//==================================================================================================
+
+// A JSON Pointer (RFC 6901), like "/a/b~1c/0".
+//
+// The pointer is parsed once, so that it can be resolved against any number
+// of values without allocating memory.
+class Pointer final
+{
+    struct Token
+    {
+        Key key;      // The unescaped reference token
+        size_t index; // The array index, kNoIndex or kEndIndex ("-")
+    };
+
+    static constexpr size_t kNoIndex = SIZE_MAX;
+    static constexpr size_t kEndIndex = SIZE_MAX - 1;
+
+    std::vector<Token> tokens_;
+    bool valid_ = true;
+
+public:
+    // Creates a pointer to the whole value.
+    Pointer() = default;
+
+    // Parses the string representation STR.
+    // If STR is not a valid JSON Pointer, is_valid() returns false and the
+    // pointer does not refer to any value.
+    explicit Pointer(std::string const& str);
+
+    bool is_valid() const noexcept { return valid_; }
+
+    // Returns the number of reference tokens.
+    size_t size() const noexcept { return tokens_.size(); }
+
+    // Returns the string representation of this pointer.
+    std::string to_string() const;
+
+    // Returns a pointer to the value referenced by this pointer.
+    // Or nullptr if no such value exists.
+    Value*       get(Value& root) const;
+    Value const* get(Value const& root) const;
+
+    // Stores VALUE at the location referenced by this pointer and returns a
+    // pointer to the stored value.
+    // Missing intermediate values (and undefined or null values) are created:
+    // as arrays if the next reference token is an array index or "-", and as
+    // objects otherwise. As for "add" in RFC 6902, an array index must not be
+    // larger than the size of the array: the index of the end of the array
+    // (like "-") appends a new element.
+    // Returns nullptr (and leaves ROOT unchanged) if an intermediate value is
+    // neither an object nor an array, if an array is indexed by a key, or if an
+    // array index is out of range.
+    Value* set(Value& root, Value value) const;
+
+    // Removes the value referenced by this pointer from its parent.
+    // Returns false if no such value exists, or if this pointer refers to the
+    // whole value.
+    bool erase(Value& root) const;
+};
+
 //==================================================================================================
 // parse
 //==================================================================================================
@@ -1413,6 +1578,92 @@ ParseResult parse(Value& value, char const* next, char const* last, Options cons
 // Parse the JSON value stored in STR.
 ParseStatus parse(Value& value, std::string const& str, Options const& options = {});
 
+// Parse the UTF-16 encoded JSON value stored in [NEXT, LAST).
+ParseResult16 parse(Value& value, char16_t const* next, char16_t const* last, Options const& options = {});
+
+// Parse the UTF-16 encoded JSON value stored in STR.
+ParseStatus parse(Value& value, std::u16string const& str, Options const& options = {});
+
+struct ProjectionCallbacks;
+
+// A set of paths to select parts of a JSON value while parsing.
+class Projection final
+{
+    friend struct ProjectionCallbacks;
+
+    struct Node;
+    std::unique_ptr<Node> root_;
+
+public:
+    Projection();
+    Projection(Projection&&) noexcept;
+    Projection& operator=(Projection&&) noexcept;
+   ~Projection();
+
+    // Adds PATH to the set. PATH is either a JSON Pointer, like "/a/b~1c/0",
+    // or a dotted path, like "a.b/c.0". The empty path selects the whole
+    // value.
+    // Returns false if PATH is an invalid JSON Pointer.
+    bool add(std::string const& path);
+};
+
+// Parse the JSON value stored in [NEXT, LAST), but only keep the parts
+// selected by PROJECTION. Object members which are not selected are
+// omitted. Array elements which are not selected are replaced by null (to
+// keep the indices of the selected elements) or omitted if no element
+// with a higher index is selected.
+// The input is still fully validated, but values which are not selected are
+// not converted and never stored.
+ParseResult parse(Value& value, Projection const& projection, char const* next, char const* last, Options const& options = {});
+
+// Parse the JSON value stored in STR. See above.
+ParseStatus parse(Value& value, Projection const& projection, std::string const& str, Options const& options = {});
+
+//==================================================================================================
+// parse_lines
+//==================================================================================================
+
+// Parse the newline-delimited JSON values ("JSON Lines", "NDJSON") stored in
+// [NEXT, LAST). Each line must contain exactly one JSON value. Lines which
+// contain only whitespace are skipped.
+// NB: Block comments must not span multiple lines.
+//
+// The input is split into chunks of consecutive lines, which are parsed
+// concurrently using up to NUM_THREADS threads. If NUM_THREADS <= 0,
+// std::thread::hardware_concurrency() threads are used.
+//
+// On success, the values are appended to VALUES in input order.
+// Otherwise, returns the error for the first invalid line and VALUES is not
+// modified.
+ParseResult parse_lines(std::vector<Value>& values, char const* next, char const* last, Options const& options = {}, int num_threads = 0);
+
+// Parse the newline-delimited JSON values stored in STR.
+ParseStatus parse_lines(std::vector<Value>& values, std::string const& str, Options const& options = {}, int num_threads = 0);
+
+// Same as above, but instead of building Values, calls
+// parse(*callbacks[i], ...) for each line, where 0 <= i < NUM_CALLBACKS is the
+// index of the thread parsing the line. A thread always parses consecutive
+// lines in input order, but the lines parsed by different threads are
+// interleaved arbitrarily.
+ParseResult parse_lines(ParseCallbacks* const* callbacks, int num_callbacks, char const* next, char const* last, Options const& options = {});
+
+//==================================================================================================
+// parse_parallel
+//==================================================================================================
+
+// Same as parse, but if the JSON value is an array, its elements are parsed
+// concurrently using up to NUM_THREADS threads. If NUM_THREADS <= 0,
+// std::thread::hardware_concurrency() threads are used.
+//
+// The element boundaries are found in a (fast) sequential pre-scan. If the
+// input is invalid, it is parsed again using parse, so that errors are
+// reported exactly as by parse.
+// Falls back to parse if options.strip_comments is set.
+ParseResult parse_parallel(Value& value, char const* next, char const* last, Options const& options = {}, int num_threads = 0);
+
+// Parse the JSON value stored in STR. See above.
+ParseStatus parse_parallel(Value& value, std::string const& str, Options const& options = {}, int num_threads = 0);
+
 //==================================================================================================
 // stringify
 //==================================================================================================
@@ -1423,6 +1674,15 @@ ParseStatus parse(Value& value, std::string const& str, Options const& options =
 // options.allow_invalid_unicode is false.
 bool stringify(std::string& str, Value const& value, Options const& options = {});
 
+// Same as stringify, but writes UTF-16.
+bool stringify(std::u16string& str, Value const& value, Options const& options = {});
+
+// Same as stringify, but if VALUE is an array or an object, the elements resp.
+// members are stringified concurrently using up to NUM_THREADS threads. If
+// NUM_THREADS <= 0, std::thread::hardware_concurrency() threads are used.
+// On success, the output is the same as the output of stringify.
+bool stringify_parallel(std::string& str, Value const& value, Options const& options = {}, int num_threads = 0);
+
 } // namespace json
 
 //==================================================================================================
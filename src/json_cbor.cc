@@ -0,0 +1,678 @@
+// Copyright 2018 Alexander Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "json_cbor.h"
+#include "json_numbers.h"
+#include "json_unicode.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+using namespace json;
+
+// Major types
+static constexpr unsigned kUnsigned = 0;
+static constexpr unsigned kNegative = 1;
+static constexpr unsigned kBytes    = 2;
+static constexpr unsigned kText     = 3;
+static constexpr unsigned kArray    = 4;
+static constexpr unsigned kMap      = 5;
+static constexpr unsigned kTag      = 6;
+static constexpr unsigned kSimple   = 7;
+
+// Additional information
+static constexpr unsigned kFalse      = 20;
+static constexpr unsigned kTrue       = 21;
+static constexpr unsigned kNull       = 22;
+static constexpr unsigned kUndefined  = 23;
+static constexpr unsigned kHalf       = 25;
+static constexpr unsigned kSingle     = 26;
+static constexpr unsigned kDouble     = 27;
+static constexpr unsigned kIndefinite = 31;
+
+static constexpr char kBreak = static_cast<char>(0xFF);
+
+//==================================================================================================
+// to_cbor
+//==================================================================================================
+
+static void PutHead(std::string& out, unsigned major, uint64_t arg)
+{
+    char const m = static_cast<char>(major << 5);
+
+    int num_bytes;
+    if (arg < 24)
+    {
+        out += static_cast<char>(m | static_cast<char>(arg));
+        return;
+    }
+    else if (arg <= 0xFF)
+    {
+        out += static_cast<char>(m | 24);
+        num_bytes = 1;
+    }
+    else if (arg <= 0xFFFF)
+    {
+        out += static_cast<char>(m | 25);
+        num_bytes = 2;
+    }
+    else if (arg <= 0xFFFFFFFF)
+    {
+        out += static_cast<char>(m | 26);
+        num_bytes = 4;
+    }
+    else
+    {
+        out += static_cast<char>(m | 27);
+        num_bytes = 8;
+    }
+
+    // Big-endian
+    for (int i = num_bytes - 1; i >= 0; --i)
+        out += static_cast<char>(static_cast<unsigned char>(arg >> (8 * i)));
+}
+
+// Returns whether the double D can be represented exactly as a half-precision
+// number, and if so, stores its bits in HALF.
+static bool DoubleToHalf(uint16_t& half, double d)
+{
+    if (std::isnan(d))
+    {
+        half = 0x7E00;
+        return true;
+    }
+
+    float const f = static_cast<float>(d);
+    if (static_cast<double>(f) != d)
+        return false;
+
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(float));
+
+    uint16_t const sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    uint32_t const biased_exp = (bits >> 23) & 0xFF;
+    uint32_t const mantissa = bits & 0x7FFFFF;
+
+    if (biased_exp == 0xFF) // Infinity
+    {
+        half = static_cast<uint16_t>(sign | 0x7C00);
+        return true;
+    }
+
+    if (biased_exp == 0)
+    {
+        if (mantissa != 0) // Too small
+            return false;
+
+        half = sign;
+        return true;
+    }
+
+    int const e = static_cast<int>(biased_exp) - 127;
+    if (e > 15 || e < -24)
+        return false;
+
+    if (e >= -14) // Normal
+    {
+        if ((mantissa & 0x1FFF) != 0)
+            return false;
+
+        half = static_cast<uint16_t>(sign | (static_cast<uint32_t>(e + 15) << 10) | (mantissa >> 13));
+        return true;
+    }
+
+    // Subnormal
+    uint32_t const significand = mantissa | 0x800000;
+    int const shift = 13 + (-14 - e);
+    if ((significand & ((uint32_t{1} << shift) - 1)) != 0)
+        return false;
+
+    half = static_cast<uint16_t>(sign | (significand >> shift));
+    return true;
+}
+
+static void PutNumber(std::string& out, double d)
+{
+    // Integers
+    if (std::floor(d) == d && !(d == 0.0 && std::signbit(d)))
+    {
+        if (d >= 0.0 && d < 18446744073709551616.0)
+        {
+            PutHead(out, kUnsigned, static_cast<uint64_t>(d));
+            return;
+        }
+
+        if (d < 0.0 && d >= -9223372036854775808.0)
+        {
+            // -1 - n = d
+            PutHead(out, kNegative, ~static_cast<uint64_t>(static_cast<int64_t>(d)));
+            return;
+        }
+    }
+
+    uint16_t half;
+    if (DoubleToHalf(half, d))
+    {
+        out += static_cast<char>(kSimple << 5 | kHalf);
+        out += static_cast<char>(half >> 8);
+        out += static_cast<char>(half & 0xFF);
+        return;
+    }
+
+    float const f = static_cast<float>(d);
+    if (static_cast<double>(f) == d)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &f, sizeof(float));
+
+        out += static_cast<char>(kSimple << 5 | kSingle);
+        for (int i = 3; i >= 0; --i)
+            out += static_cast<char>(static_cast<unsigned char>(bits >> (8 * i)));
+        return;
+    }
+
+    uint64_t bits;
+    std::memcpy(&bits, &d, sizeof(double));
+
+    out += static_cast<char>(kSimple << 5 | kDouble);
+    for (int i = 7; i >= 0; --i)
+        out += static_cast<char>(static_cast<unsigned char>(bits >> (8 * i)));
+}
+
+static void PutString(std::string& out, String const& str)
+{
+    PutHead(out, kText, str.size());
+    out += str;
+}
+
+static void PutValue(std::string& out, Value const& value)
+{
+    switch (value.type())
+    {
+    case Type::undefined:
+        out += static_cast<char>(kSimple << 5 | kUndefined);
+        break;
+    case Type::null:
+        out += static_cast<char>(kSimple << 5 | kNull);
+        break;
+    case Type::boolean:
+        out += static_cast<char>(kSimple << 5 | (value.get_boolean() ? kTrue : kFalse));
+        break;
+    case Type::number:
+        PutNumber(out, value.get_number());
+        break;
+    case Type::string:
+        PutString(out, value.get_string());
+        break;
+    case Type::array:
+        PutHead(out, kArray, value.get_array().size());
+        for (auto const& v : value.get_array())
+            PutValue(out, v);
+        break;
+    case Type::object:
+        PutHead(out, kMap, value.get_object().size());
+        for (auto const& m : value.get_object())
+        {
+            PutString(out, m.first);
+            PutValue(out, m.second);
+        }
+        break;
+    }
+}
+
+void json::to_cbor(std::string& out, Value const& value)
+{
+    PutValue(out, value);
+}
+
+//==================================================================================================
+// parse_cbor
+//==================================================================================================
+
+static double HalfToDouble(uint16_t half)
+{
+    int const exp = (half >> 10) & 0x1F;
+    int const mantissa = half & 0x3FF;
+
+    double value;
+    if (exp == 0)
+        value = std::ldexp(mantissa, -24);
+    else if (exp != 31)
+        value = std::ldexp(mantissa + 1024, exp - 25);
+    else
+        value = (mantissa == 0) ? HUGE_VAL : NAN;
+
+    return (half & 0x8000) ? -value : value;
+}
+
+// Writes the decimal representation of U into the buffer ending at LAST.
+// Returns a pointer to the first digit.
+static char* FormatDecimal(char* last, uint64_t u)
+{
+    do
+    {
+        *--last = static_cast<char>('0' + u % 10);
+        u /= 10;
+    }
+    while (u != 0);
+
+    return last;
+}
+
+namespace {
+
+struct CborParser
+{
+    static constexpr int kMaxDepth = 500;
+
+    ParseCallbacks& cb;
+    Options         options;
+    char const*     next;
+    char const*     last;
+    char const*     item = nullptr; // Start of the current data item
+    std::string     buffer;         // Indefinite length strings and byte strings
+
+    CborParser(ParseCallbacks& cb_, char const* next_, char const* last_, Options const& options_)
+        : cb(cb_)
+        , options(options_)
+        , next(next_)
+        , last(last_)
+    {
+    }
+
+    ParseStatus ReadHead(unsigned& major, unsigned& info, uint64_t& arg);
+    ParseStatus ReadString(unsigned major, unsigned info, uint64_t arg, char const*& f, char const*& l);
+    ParseStatus ReadText(unsigned info, uint64_t arg, char const*& f, char const*& l);
+    ParseStatus ParseNumber(double d);
+    ParseStatus ParseBytes(unsigned info, uint64_t arg);
+    ParseStatus ParseArray(unsigned info, uint64_t arg, int depth);
+    ParseStatus ParseMap(unsigned info, uint64_t arg, int depth);
+    ParseStatus ParseItem(int depth);
+
+    bool AtBreak() const { return next != last && *next == kBreak; }
+};
+
+} // namespace
+
+ParseStatus CborParser::ReadHead(unsigned& major, unsigned& info, uint64_t& arg)
+{
+    item = next;
+
+    if (next == last)
+        return ParseStatus::unexpected_eof;
+
+    unsigned char const initial = static_cast<unsigned char>(*next++);
+    major = initial >> 5;
+    info = initial & 0x1F;
+
+    if (info < 24)
+    {
+        arg = info;
+        return {};
+    }
+
+    if (info == kIndefinite)
+    {
+        // Not allowed for unsigned and negative integers and tags.
+        // (A break outside of an indefinite length item is an error, too.)
+        if (major == kUnsigned || major == kNegative || major == kTag || major == kSimple)
+            return ParseStatus::invalid_value;
+
+        arg = 0;
+        return {};
+    }
+
+    if (info > 27)
+        return ParseStatus::invalid_value;
+
+    size_t const num_bytes = size_t{1} << (info - 24);
+    if (static_cast<size_t>(last - next) < num_bytes)
+        return ParseStatus::unexpected_eof;
+
+    arg = 0;
+    for (size_t i = 0; i < num_bytes; ++i)
+        arg = (arg << 8) | static_cast<unsigned char>(*next++);
+
+    return {};
+}
+
+ParseStatus CborParser::ReadString(unsigned major, unsigned info, uint64_t arg, char const*& f, char const*& l)
+{
+    if (info != kIndefinite)
+    {
+        if (arg > static_cast<uint64_t>(last - next))
+            return ParseStatus::unexpected_eof;
+
+        f = next;
+        next += arg;
+        l = next;
+        return {};
+    }
+
+    // The chunks of an indefinite length string must be definite length
+    // strings of the same type.
+    buffer.clear();
+    for (;;)
+    {
+        if (next == last)
+            return ParseStatus::unexpected_eof;
+        if (*next == kBreak)
+        {
+            ++next;
+            break;
+        }
+
+        unsigned chunk_major;
+        unsigned chunk_info;
+        uint64_t chunk_arg;
+        auto const ec = ReadHead(chunk_major, chunk_info, chunk_arg);
+        if (ec != ParseStatus::success)
+            return ec;
+
+        if (chunk_major != major || chunk_info == kIndefinite)
+            return ParseStatus::invalid_string;
+        if (chunk_arg > static_cast<uint64_t>(last - next))
+            return ParseStatus::unexpected_eof;
+
+        buffer.append(next, static_cast<size_t>(chunk_arg));
+        next += chunk_arg;
+    }
+
+    f = buffer.data();
+    l = buffer.data() + buffer.size();
+    return {};
+}
+
+ParseStatus CborParser::ReadText(unsigned info, uint64_t arg, char const*& f, char const*& l)
+{
+    auto const ec = ReadString(kText, info, arg, f, l);
+    if (ec != ParseStatus::success)
+        return ec;
+
+    if (unicode::ValidateUTF8(f, l) != l)
+        return ParseStatus::invalid_string;
+
+    return {};
+}
+
+ParseStatus CborParser::ParseNumber(double d)
+{
+    if (std::isnan(d))
+        return cb.HandleNumber("NaN", "NaN" + 3, NumberClass::nan, options);
+    if (d == HUGE_VAL)
+        return cb.HandleNumber("Infinity", "Infinity" + 8, NumberClass::pos_infinity, options);
+    if (d == -HUGE_VAL)
+        return cb.HandleNumber("-Infinity", "-Infinity" + 9, NumberClass::neg_infinity, options);
+
+    char buf[32];
+    char* const end = numbers::NumberToString(buf, buf + 32, d, /*emit_trailing_dot_zero*/ false);
+
+    NumberClass nc = NumberClass::integer;
+    for (char const* p = buf; p != end; ++p)
+    {
+        if (*p == '.' || *p == 'e' || *p == 'E')
+        {
+            nc = NumberClass::floating_point;
+            break;
+        }
+    }
+
+    return cb.HandleNumber(buf, end, nc, options);
+}
+
+ParseStatus CborParser::ParseBytes(unsigned info, uint64_t arg)
+{
+    static constexpr char const kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+    char const* f;
+    char const* l;
+    auto const ec = ReadString(kBytes, info, arg, f, l);
+    if (ec != ParseStatus::success)
+        return ec;
+
+    // Base64url, without padding.
+    std::string str;
+    str.reserve(static_cast<size_t>(l - f) / 3 * 4 + 4);
+
+    for ( ; l - f >= 3; f += 3)
+    {
+        uint32_t const w = static_cast<uint32_t>(static_cast<unsigned char>(f[0])) << 16
+                         | static_cast<uint32_t>(static_cast<unsigned char>(f[1])) << 8
+                         | static_cast<uint32_t>(static_cast<unsigned char>(f[2]));
+        str += kAlphabet[(w >> 18) & 0x3F];
+        str += kAlphabet[(w >> 12) & 0x3F];
+        str += kAlphabet[(w >>  6) & 0x3F];
+        str += kAlphabet[(w      ) & 0x3F];
+    }
+
+    if (l - f == 1)
+    {
+        uint32_t const w = static_cast<uint32_t>(static_cast<unsigned char>(f[0])) << 16;
+        str += kAlphabet[(w >> 18) & 0x3F];
+        str += kAlphabet[(w >> 12) & 0x3F];
+    }
+    else if (l - f == 2)
+    {
+        uint32_t const w = static_cast<uint32_t>(static_cast<unsigned char>(f[0])) << 16
+                         | static_cast<uint32_t>(static_cast<unsigned char>(f[1])) << 8;
+        str += kAlphabet[(w >> 18) & 0x3F];
+        str += kAlphabet[(w >> 12) & 0x3F];
+        str += kAlphabet[(w >>  6) & 0x3F];
+    }
+
+    return cb.HandleString(str.data(), str.data() + str.size(), /*needs_cleaning*/ false, options);
+}
+
+ParseStatus CborParser::ParseArray(unsigned info, uint64_t arg, int depth)
+{
+    if (depth >= kMaxDepth)
+        return ParseStatus::max_depth_reached;
+
+    // Each element requires at least one byte.
+    if (info != kIndefinite && arg > static_cast<uint64_t>(last - next))
+        return ParseStatus::unexpected_eof;
+
+    auto ec = cb.HandleBeginArray(options);
+    if (ec != ParseStatus::success)
+        return ec;
+
+    size_t count = 0;
+    for (uint64_t i = 0; info == kIndefinite || i < arg; ++i)
+    {
+        if (info == kIndefinite && AtBreak())
+        {
+            ++next;
+            break;
+        }
+
+        ec = ParseItem(depth + 1);
+        if (ec != ParseStatus::success)
+            return ec;
+
+        ++count;
+        ec = cb.HandleEndElement(count, options);
+        if (ec != ParseStatus::success)
+            return ec;
+    }
+
+    return cb.HandleEndArray(count, options);
+}
+
+ParseStatus CborParser::ParseMap(unsigned info, uint64_t arg, int depth)
+{
+    if (depth >= kMaxDepth)
+        return ParseStatus::max_depth_reached;
+
+    // Each member requires at least two bytes.
+    if (info != kIndefinite && arg > static_cast<uint64_t>(last - next) / 2)
+        return ParseStatus::unexpected_eof;
+
+    auto ec = cb.HandleBeginObject(options);
+    if (ec != ParseStatus::success)
+        return ec;
+
+    size_t count = 0;
+    for (uint64_t i = 0; info == kIndefinite || i < arg; ++i)
+    {
+        if (info == kIndefinite && AtBreak())
+        {
+            ++next;
+            break;
+        }
+
+        // Keys must be (possibly tagged) text strings.
+        unsigned key_major;
+        unsigned key_info;
+        uint64_t key_arg;
+        do
+        {
+            ec = ReadHead(key_major, key_info, key_arg);
+            if (ec != ParseStatus::success)
+                return ec;
+        }
+        while (key_major == kTag);
+
+        if (key_major != kText)
+            return ParseStatus::invalid_key;
+
+        char const* f;
+        char const* l;
+        ec = ReadText(key_info, key_arg, f, l);
+        if (ec != ParseStatus::success)
+            return ec;
+
+        ec = cb.HandleKey(f, l, /*needs_cleaning*/ false, options);
+        if (ec != ParseStatus::success)
+            return ec;
+
+        ec = ParseItem(depth + 1);
+        if (ec != ParseStatus::success)
+            return ec;
+
+        ++count;
+        ec = cb.HandleEndMember(count, options);
+        if (ec != ParseStatus::success)
+            return ec;
+    }
+
+    return cb.HandleEndObject(count, options);
+}
+
+ParseStatus CborParser::ParseItem(int depth)
+{
+    unsigned major;
+    unsigned info;
+    uint64_t arg;
+
+    // Tags are ignored.
+    do
+    {
+        auto const ec = ReadHead(major, info, arg);
+        if (ec != ParseStatus::success)
+            return ec;
+    }
+    while (major == kTag);
+
+    switch (major)
+    {
+    case kUnsigned:
+        {
+            char buf[32];
+            char* const f = FormatDecimal(buf + 32, arg);
+            return cb.HandleNumber(f, buf + 32, NumberClass::integer, options);
+        }
+
+    case kNegative:
+        {
+            // The value is -1 - ARG.
+            static constexpr char const kMin[] = "-18446744073709551616";
+            if (arg == UINT64_MAX)
+                return cb.HandleNumber(kMin, kMin + sizeof(kMin) - 1, NumberClass::integer, options);
+
+            char buf[32];
+            char* f = FormatDecimal(buf + 32, arg + 1);
+            *--f = '-';
+            return cb.HandleNumber(f, buf + 32, NumberClass::integer, options);
+        }
+
+    case kBytes:
+        return ParseBytes(info, arg);
+
+    case kText:
+        {
+            char const* f;
+            char const* l;
+            auto const ec = ReadText(info, arg, f, l);
+            if (ec != ParseStatus::success)
+                return ec;
+
+            return cb.HandleString(f, l, /*needs_cleaning*/ false, options);
+        }
+
+    case kArray:
+        return ParseArray(info, arg, depth);
+
+    case kMap:
+        return ParseMap(info, arg, depth);
+
+    default:
+        JSON_ASSERT(major == kSimple);
+        switch (info)
+        {
+        case kFalse:
+            return cb.HandleBoolean(false, options);
+        case kTrue:
+            return cb.HandleBoolean(true, options);
+        case kHalf:
+            return ParseNumber(HalfToDouble(static_cast<uint16_t>(arg)));
+        case kSingle:
+            {
+                uint32_t const bits = static_cast<uint32_t>(arg);
+                float f;
+                std::memcpy(&f, &bits, sizeof(float));
+                return ParseNumber(static_cast<double>(f));
+            }
+        case kDouble:
+            {
+                double d;
+                std::memcpy(&d, &arg, sizeof(double));
+                return ParseNumber(d);
+            }
+        default:
+            // null, undefined, and unassigned simple values
+            return cb.HandleNull(options);
+        }
+    }
+}
+
+ParseResult json::parse_cbor(ParseCallbacks& cb, char const* next, char const* last, Options const& options)
+{
+    CborParser parser(cb, next, last, options);
+
+    auto const ec = parser.ParseItem(0);
+    if (ec != ParseStatus::success)
+        return {ec, parser.item, parser.next};
+
+    if (!options.allow_trailing_characters && parser.next != last)
+        return {ParseStatus::expected_eof, parser.next, last};
+
+    return {ec, parser.next, parser.next};
+}
@@ -0,0 +1,89 @@
+// Copyright 2018 Alexander Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "json.h"
+
+#include <string>
+
+//
+// Conversion between Values and CBOR (RFC 8949).
+//
+// Values are mapped to CBOR as follows:
+//
+//      null                simple value 22 (null)
+//      boolean             simple values 20 and 21 (false, true)
+//      number              an integer (major types 0 and 1) if the number is
+//                          integral and in the range [-2^63, 2^64), otherwise
+//                          the shortest floating-point number (half-, single-
+//                          or double-precision) which represents the number
+//                          exactly
+//      string              a text string (major type 3)
+//      array               an array (major type 4)
+//      object              a map (major type 5), with text string keys
+//      undefined           simple value 23 (undefined)
+//
+// When decoding, the following additional CBOR items are accepted:
+//
+//      byte strings        converted to base64url encoded strings (as
+//                          recommended by RFC 8949, section 6.1)
+//      indefinite length   strings, arrays and maps
+//      tags                ignored (the tagged item is converted)
+//      simple values       undefined and unassigned simple values are
+//                          converted to null
+//
+
+namespace json {
+
+//==================================================================================================
+// to_cbor
+//==================================================================================================
+
+// Appends the CBOR encoding of VALUE to OUT.
+void to_cbor(std::string& out, Value const& value);
+
+//==================================================================================================
+// parse_cbor
+//==================================================================================================
+
+// Parse the CBOR data item stored in [NEXT, LAST), calling the callbacks in
+// CB, exactly as json::parse would for the equivalent JSON text.
+//
+// Strings and keys are passed with needs_cleaning = false (i.e. they are not
+// escaped), numbers are passed as JSON numbers (and "NaN", "Infinity",
+// "-Infinity"). Map keys must be text strings.
+//
+// If Options::allow_trailing_characters is set, the data item may be followed
+// by other data, e.g. to parse CBOR sequences (RFC 8742) by repeatedly calling
+// parse_cbor. The other Options are only passed to the callbacks.
+ParseResult parse_cbor(ParseCallbacks& cb, char const* next, char const* last, Options const& options = {});
+
+//==================================================================================================
+// from_cbor
+//==================================================================================================
+
+// Parse the CBOR data item stored in [NEXT, LAST) into VALUE.
+ParseResult from_cbor(Value& value, char const* next, char const* last, Options const& options = {});
+
+// Parse the CBOR data item stored in STR into VALUE.
+ParseStatus from_cbor(Value& value, std::string const& str, Options const& options = {});
+
+} // namespace json
@@ -89,6 +89,12 @@ inline unsigned CharClass(char ch)
     return kMap[static_cast<unsigned char>(ch)];
 }
 
+// UTF-16 code units >= 0x80 are classified like UTF-8 bytes >= 0x80.
+inline unsigned CharClass(char16_t ch)
+{
+    return ch < 0x80 ? CharClass(static_cast<char>(ch)) : unsigned{CC_NeedsCleaning};
+}
+
 inline bool IsWhitespace      (char ch) { return (CharClass(ch) & CC_Whitespace      ) != 0; }
 inline bool IsDigit           (char ch) { return (CharClass(ch) & CC_Digit           ) != 0; }
 inline bool IsIdentifierBody  (char ch) { return (CharClass(ch) & CC_IdentifierBody  ) != 0; }
@@ -96,6 +102,10 @@ inline bool IsValidEscapedChar(char ch) { return (CharClass(ch) & CC_ValidEscape
 inline bool IsStringSpecial   (char ch) { return (CharClass(ch) & CC_StringSpecial   ) != 0; }
 inline bool NeedsCleaning     (char ch) { return (CharClass(ch) & CC_NeedsCleaning   ) != 0; }
 
+inline bool IsWhitespace      (char16_t ch) { return (CharClass(ch) & CC_Whitespace      ) != 0; }
+inline bool IsDigit           (char16_t ch) { return (CharClass(ch) & CC_Digit           ) != 0; }
+inline bool IsIdentifierBody  (char16_t ch) { return (CharClass(ch) & CC_IdentifierBody  ) != 0; }
+
 #if 1
 inline int HexDigitValue(char ch)
 {
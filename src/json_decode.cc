@@ -0,0 +1,178 @@
+// Copyright 2018 Alexander Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "json_decode.h"
+#include "json_strings.h"
+
+using namespace json;
+
+//==================================================================================================
+// DecodeCallbacks
+//==================================================================================================
+
+impl::DecodeTarget DecodeCallbacks::NextTarget()
+{
+    if (stack_.empty())
+    {
+        auto const target = root_;
+        root_ = {};
+        return target;
+    }
+
+    auto const& frame = stack_.back();
+    if (frame.target.ops == nullptr)
+        return {};
+
+    if (frame.is_array)
+        return frame.target.ops->element(frame.target.obj);
+
+    return member_;
+}
+
+bool DecodeCallbacks::Unescape(char const*& first, char const*& last, bool needs_cleaning)
+{
+    if (!needs_cleaning)
+        return true;
+
+    auto const res = strings::UnescapeStringBulk(buffer_, first, last);
+    if (res.status != strings::UnescapeStringStatus::success)
+        return false;
+
+    first = buffer_.data();
+    last = buffer_.data() + buffer_.size();
+    return true;
+}
+
+ParseStatus DecodeCallbacks::HandleNull(Options const& /*options*/)
+{
+    auto const target = NextTarget();
+    if (target.ops == nullptr)
+        return {};
+
+    return target.ops->null(target.obj);
+}
+
+ParseStatus DecodeCallbacks::HandleBoolean(bool value, Options const& /*options*/)
+{
+    auto const target = NextTarget();
+    if (target.ops == nullptr)
+        return {};
+
+    return target.ops->boolean(target.obj, value);
+}
+
+ParseStatus DecodeCallbacks::HandleNumber(char const* first, char const* last, NumberClass nc, Options const& /*options*/)
+{
+    auto const target = NextTarget();
+    if (target.ops == nullptr)
+        return {};
+
+    return target.ops->number(target.obj, first, last, nc);
+}
+
+ParseStatus DecodeCallbacks::HandleString(char const* first, char const* last, bool needs_cleaning, Options const& /*options*/)
+{
+    auto const target = NextTarget();
+    if (target.ops == nullptr)
+    {
+        // Strings in skipped values must still be valid.
+        if (needs_cleaning && strings::ValidateString(first, last).status != strings::UnescapeStringStatus::success)
+            return ParseStatus::invalid_string;
+        return {};
+    }
+
+    if (!Unescape(first, last, needs_cleaning))
+        return ParseStatus::invalid_string;
+
+    return target.ops->string(target.obj, first, last);
+}
+
+ParseStatus DecodeCallbacks::HandleBeginArray(Options const& /*options*/)
+{
+    auto const target = NextTarget();
+    if (target.ops != nullptr)
+    {
+        auto const ec = target.ops->begin_array(target.obj);
+        if (ec != ParseStatus::success)
+            return ec;
+    }
+
+    stack_.push_back({target, /*is_array*/ true});
+    return {};
+}
+
+ParseStatus DecodeCallbacks::HandleEndArray(size_t /*count*/, Options const& /*options*/)
+{
+    JSON_ASSERT(!stack_.empty());
+    JSON_ASSERT(stack_.back().is_array);
+
+    stack_.pop_back();
+    return {};
+}
+
+ParseStatus DecodeCallbacks::HandleEndElement(size_t& /*count*/, Options const& /*options*/)
+{
+    return {};
+}
+
+ParseStatus DecodeCallbacks::HandleBeginObject(Options const& /*options*/)
+{
+    auto const target = NextTarget();
+    if (target.ops != nullptr)
+    {
+        auto const ec = target.ops->begin_object(target.obj);
+        if (ec != ParseStatus::success)
+            return ec;
+    }
+
+    stack_.push_back({target, /*is_array*/ false});
+    return {};
+}
+
+ParseStatus DecodeCallbacks::HandleEndObject(size_t /*count*/, Options const& /*options*/)
+{
+    JSON_ASSERT(!stack_.empty());
+    JSON_ASSERT(!stack_.back().is_array);
+
+    stack_.pop_back();
+    return {};
+}
+
+ParseStatus DecodeCallbacks::HandleEndMember(size_t& /*count*/, Options const& /*options*/)
+{
+    return {};
+}
+
+ParseStatus DecodeCallbacks::HandleKey(char const* first, char const* last, bool needs_cleaning, Options const& /*options*/)
+{
+    JSON_ASSERT(!stack_.empty());
+    JSON_ASSERT(!stack_.back().is_array);
+
+    if (!Unescape(first, last, needs_cleaning))
+        return ParseStatus::invalid_string; // return ParseStatus::invalid_key;
+
+    auto const& frame = stack_.back();
+    if (frame.target.ops == nullptr)
+        member_ = {};
+    else
+        member_ = frame.target.ops->member(frame.target.obj, first, static_cast<size_t>(last - first));
+
+    return {};
+}
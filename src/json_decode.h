@@ -0,0 +1,387 @@
+// Copyright 2018 Alexander Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "json.h"
+#include "json_numbers.h"
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+//
+// Decode JSON directly into C++ objects, without building a json::Value first.
+//
+// Supported types are bool, arithmetic types, std::string, std::vector<T>,
+// std::map<std::string, T>, and structs which have a Schema specialization:
+//
+//      struct Person {
+//          std::string name;
+//          int age = 0;
+//          std::vector<std::string> tags;
+//      };
+//
+//      namespace json {
+//          template <>
+//          struct Schema<Person> {
+//              static constexpr auto fields() {
+//                  return std::make_tuple(
+//                      JSON_FIELD(Person, name),
+//                      JSON_FIELD(Person, age),
+//                      json::field("tag-list", &Person::tags));
+//              }
+//          };
+//      }
+//
+//      Person p;
+//      auto const res = json::decode(p, first, last);
+//
+// Members are dispatched by key, unknown members are skipped, and members
+// which are not present in the JSON keep their current values.
+//
+
+namespace json {
+
+//==================================================================================================
+// Schema
+//==================================================================================================
+
+// Specialize this for your struct types. See above.
+template <typename T>
+struct Schema;
+
+template <typename T, typename M>
+struct Field
+{
+    char const* name;
+    size_t      length;
+    M T::*      member;
+};
+
+// Returns a description of the member MEMBER, which is stored under the key NAME.
+template <typename T, typename M, size_t N>
+constexpr Field<T, M> field(char const (&name)[N], M T::*member)
+{
+    return {name, N - 1, member};
+}
+
+#define JSON_FIELD(T, NAME) ::json::field(#NAME, &T::NAME)
+
+//==================================================================================================
+// DecodeCallbacks
+//==================================================================================================
+
+namespace impl {
+
+struct DecodeOps;
+
+// The object the next value is stored into.
+// If OPS is null, the value is skipped.
+struct DecodeTarget
+{
+    DecodeOps const* ops = nullptr;
+    void* obj = nullptr;
+};
+
+struct DecodeOps
+{
+    ParseStatus  (*null)(void* obj);
+    ParseStatus  (*boolean)(void* obj, bool value);
+    ParseStatus  (*number)(void* obj, char const* first, char const* last, NumberClass nc);
+    // NB: The string is already unescaped.
+    ParseStatus  (*string)(void* obj, char const* first, char const* last);
+    ParseStatus  (*begin_array)(void* obj);
+    DecodeTarget (*element)(void* obj);
+    ParseStatus  (*begin_object)(void* obj);
+    DecodeTarget (*member)(void* obj, char const* key, size_t length);
+};
+
+template <typename T, typename /*Enable*/ = void>
+struct Decoder;
+
+template <typename T>
+JSON_INLINE_VARIABLE constexpr DecodeOps const kDecodeOps = {
+    &Decoder<T>::Null,
+    &Decoder<T>::Boolean,
+    &Decoder<T>::Number,
+    &Decoder<T>::String,
+    &Decoder<T>::BeginArray,
+    &Decoder<T>::Element,
+    &Decoder<T>::BeginObject,
+    &Decoder<T>::Member,
+};
+
+template <typename T>
+DecodeTarget MakeDecodeTarget(T& value)
+{
+    DecodeTarget target;
+    target.ops = &kDecodeOps<T>;
+    target.obj = &value;
+    return target;
+}
+
+// Rejects all values.
+struct DecoderBase
+{
+    static ParseStatus  Null(void*) { return ParseStatus::unexpected_type; }
+    static ParseStatus  Boolean(void*, bool) { return ParseStatus::unexpected_type; }
+    static ParseStatus  Number(void*, char const*, char const*, NumberClass) { return ParseStatus::unexpected_type; }
+    static ParseStatus  String(void*, char const*, char const*) { return ParseStatus::unexpected_type; }
+    static ParseStatus  BeginArray(void*) { return ParseStatus::unexpected_type; }
+    static DecodeTarget Element(void*) { return {}; }
+    static ParseStatus  BeginObject(void*) { return ParseStatus::unexpected_type; }
+    static DecodeTarget Member(void*, char const*, size_t) { return {}; }
+};
+
+template <>
+struct Decoder<bool> : DecoderBase
+{
+    static ParseStatus Boolean(void* obj, bool value)
+    {
+        *static_cast<bool*>(obj) = value;
+        return {};
+    }
+};
+
+// Parses the integer [first, last) into VALUE.
+// Returns false if the number is not representable as a T.
+template <typename T>
+bool DecodeInteger(T& value, char const* first, char const* last)
+{
+    using U = std::make_unsigned_t<T>;
+
+    bool const is_neg = (*first == '-');
+    if (is_neg)
+        ++first;
+
+    // The maximum magnitude: max() for positive numbers, and |min()| for negative numbers.
+    U const max_value = static_cast<U>(static_cast<U>(std::numeric_limits<T>::max()) + (is_neg && std::is_signed<T>::value ? 1u : 0u));
+
+    U u = 0;
+    for ( ; first != last; ++first)
+    {
+        U const digit = static_cast<U>(*first - '0');
+        if (u > static_cast<U>((max_value - digit) / 10))
+            return false;
+        u = static_cast<U>(u * 10 + digit);
+    }
+
+    if (is_neg)
+    {
+        // Negative numbers (but -0) are not representable as unsigned T.
+        if (!std::is_signed<T>::value && u != 0)
+            return false;
+        value = static_cast<T>(0 - u); // NB: Requires two's complement.
+    }
+    else
+        value = static_cast<T>(u);
+
+    return true;
+}
+
+template <typename T>
+struct Decoder<T, std::enable_if_t< std::is_integral<T>::value && !std::is_same<T, bool>::value >> : DecoderBase
+{
+    static ParseStatus Number(void* obj, char const* first, char const* last, NumberClass nc)
+    {
+        if (nc != NumberClass::integer)
+            return ParseStatus::unexpected_type;
+        if (!DecodeInteger(*static_cast<T*>(obj), first, last))
+            return ParseStatus::invalid_number;
+
+        return {};
+    }
+};
+
+template <>
+struct Decoder<float> : DecoderBase
+{
+    static ParseStatus Number(void* obj, char const* first, char const* last, NumberClass nc)
+    {
+        *static_cast<float*>(obj) = numbers::StringToFloat(first, last, nc);
+        return {};
+    }
+};
+
+template <>
+struct Decoder<double> : DecoderBase
+{
+    static ParseStatus Number(void* obj, char const* first, char const* last, NumberClass nc)
+    {
+        *static_cast<double*>(obj) = numbers::StringToNumber(first, last, nc);
+        return {};
+    }
+};
+
+template <>
+struct Decoder<std::string> : DecoderBase
+{
+    static ParseStatus String(void* obj, char const* first, char const* last)
+    {
+        static_cast<std::string*>(obj)->assign(first, last);
+        return {};
+    }
+};
+
+template <typename T, typename Alloc>
+struct Decoder<std::vector<T, Alloc>> : DecoderBase
+{
+    static ParseStatus BeginArray(void* obj)
+    {
+        static_cast<std::vector<T, Alloc>*>(obj)->clear();
+        return {};
+    }
+
+    static DecodeTarget Element(void* obj)
+    {
+        auto& vec = *static_cast<std::vector<T, Alloc>*>(obj);
+        vec.emplace_back();
+        return MakeDecodeTarget(vec.back());
+    }
+};
+
+template <typename T, typename Compare, typename Alloc>
+struct Decoder<std::map<std::string, T, Compare, Alloc>> : DecoderBase
+{
+    static ParseStatus BeginObject(void* obj)
+    {
+        static_cast<std::map<std::string, T, Compare, Alloc>*>(obj)->clear();
+        return {};
+    }
+
+    static DecodeTarget Member(void* obj, char const* key, size_t length)
+    {
+        auto& map = *static_cast<std::map<std::string, T, Compare, Alloc>*>(obj);
+        return MakeDecodeTarget(map[std::string(key, length)]);
+    }
+};
+
+// Structs with a Schema specialization.
+template <typename T, typename /*Enable*/>
+struct Decoder : DecoderBase
+{
+    static ParseStatus BeginObject(void* /*obj*/)
+    {
+        return {};
+    }
+
+    static DecodeTarget Member(void* obj, char const* key, size_t length)
+    {
+        DecodeTarget target;
+        FindField(target, *static_cast<T*>(obj), key, length, Schema<T>::fields());
+        return target;
+    }
+
+private:
+    template <typename M>
+    static void MatchField(DecodeTarget& target, T& value, char const* key, size_t length, Field<T, M> const& f)
+    {
+        if (target.ops == nullptr && f.length == length && std::memcmp(f.name, key, length) == 0)
+            target = MakeDecodeTarget(value.*(f.member));
+    }
+
+    template <typename Fields, size_t... Is>
+    static void FindField(DecodeTarget& target, T& value, char const* key, size_t length, Fields const& fields, std::index_sequence<Is...>)
+    {
+        int const unused[] = {0, (MatchField(target, value, key, length, std::get<Is>(fields)), 0)...};
+        static_cast<void>(unused);
+    }
+
+    template <typename... Fs>
+    static void FindField(DecodeTarget& target, T& value, char const* key, size_t length, std::tuple<Fs...> const& fields)
+    {
+        FindField(target, value, key, length, fields, std::index_sequence_for<Fs...>{});
+    }
+};
+
+} // namespace impl
+
+// Parse callbacks which store the parsed values directly into a C++ object.
+// See above for a list of supported types.
+class DecodeCallbacks final : public ParseCallbacks
+{
+    struct Frame
+    {
+        impl::DecodeTarget target; // Skipped arrays and objects have target.ops == null
+        bool is_array;
+    };
+
+    std::vector<Frame> stack_;
+    impl::DecodeTarget root_;
+    impl::DecodeTarget member_; // Target for the value of the current member
+    std::string buffer_;        // Unescaped strings and keys
+
+public:
+    template <typename T>
+    explicit DecodeCallbacks(T& value)
+        : root_(impl::MakeDecodeTarget(value))
+    {
+    }
+
+    ParseStatus HandleNull(Options const& options) override;
+    ParseStatus HandleBoolean(bool value, Options const& options) override;
+    ParseStatus HandleNumber(char const* first, char const* last, NumberClass nc, Options const& options) override;
+    ParseStatus HandleString(char const* first, char const* last, bool needs_cleaning, Options const& options) override;
+    ParseStatus HandleBeginArray(Options const& options) override;
+    ParseStatus HandleEndArray(size_t count, Options const& options) override;
+    ParseStatus HandleEndElement(size_t& count, Options const& options) override;
+    ParseStatus HandleBeginObject(Options const& options) override;
+    ParseStatus HandleEndObject(size_t count, Options const& options) override;
+    ParseStatus HandleEndMember(size_t& count, Options const& options) override;
+    ParseStatus HandleKey(char const* first, char const* last, bool needs_cleaning, Options const& options) override;
+
+private:
+    impl::DecodeTarget NextTarget();
+    bool Unescape(char const*& first, char const*& last, bool needs_cleaning);
+};
+
+//==================================================================================================
+// decode
+//==================================================================================================
+
+// Parse the JSON value stored in [NEXT, LAST) into VALUE.
+// Returns ParseStatus::unexpected_type if the JSON does not match the type of
+// VALUE, or ParseStatus::invalid_number if a number does not fit into an
+// integral type. On error, VALUE might be partially modified.
+template <typename T>
+ParseResult decode(T& value, char const* next, char const* last, Options const& options = {})
+{
+    DecodeCallbacks cb(value);
+    return json::parse(cb, next, last, options);
+}
+
+// Parse the JSON value stored in STR into VALUE.
+template <typename T>
+ParseStatus decode(T& value, std::string const& str, Options const& options = {})
+{
+    char const* next = str.data();
+    char const* last = str.data() + str.size();
+
+    return json::decode(value, next, last, options).ec;
+}
+
+} // namespace json
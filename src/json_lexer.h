@@ -0,0 +1,748 @@
+// Copyright 2018 Alexander Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "json_charclass.h"
+#include "json_options.h"
+#include "json_parse.h"
+#include "json_strings.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+
+#ifndef JSON_ASSERT
+#define JSON_ASSERT(X) assert(X)
+#endif
+
+//
+// The JSON lexer. Internal, shared by the parser (json_parse.cc) and the
+// on-demand API (json_ondemand.cc).
+//
+
+namespace json {
+namespace lexer {
+
+//--------------------------------------------------------------------------------------------------
+//
+//--------------------------------------------------------------------------------------------------
+
+template <typename It>
+It SkipWhitespace(It f, It l)
+{
+    using namespace json::charclass;
+
+#if 0
+    while (l - f >= 4)
+    {
+        if (!IsWhitespace(f[0])) return f + 0;
+        if (!IsWhitespace(f[1])) return f + 1;
+        if (!IsWhitespace(f[2])) return f + 2;
+        if (!IsWhitespace(f[3])) return f + 3;
+        f += 4;
+    }
+#endif
+
+    for ( ; f != l && IsWhitespace(*f); ++f)
+    {
+    }
+
+    return f;
+}
+
+// Returns whether [f, f + n) equals the ASCII string s.
+inline bool EqualASCII(char const* f, char const* s, size_t n)
+{
+    return std::memcmp(f, s, n) == 0;
+}
+
+inline bool EqualASCII(char16_t const* f, char const* s, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (f[i] != static_cast<char16_t>(s[i]))
+            return false;
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+//
+//--------------------------------------------------------------------------------------------------
+
+template <typename It>
+struct ScanNumberResult
+{
+    It next;
+    NumberClass number_class;
+};
+
+template <typename It>
+ScanNumberResult<It> ScanNumber(It next, It last, Options const& options)
+{
+    using namespace json::charclass;
+
+    if (next == last)
+        return {next, NumberClass::invalid};
+
+    bool is_neg = false;
+    bool is_float = false;
+
+// [-]
+
+    if (*next == '-')
+    {
+        is_neg = true;
+
+        ++next;
+        if (next == last)
+            return {next, NumberClass::invalid};
+    }
+
+// int
+
+    if (*next == '0')
+    {
+        ++next;
+        if (next == last)
+            return {next, NumberClass::integer};
+        if (IsDigit(*next))
+            return {next, NumberClass::invalid};
+    }
+    else if (IsDigit(*next)) // non '0'
+    {
+        for (;;)
+        {
+            ++next;
+            if (next == last)
+                return {next, NumberClass::integer};
+            if (!IsDigit(*next))
+                break;
+        }
+    }
+    else
+    {
+        // NaN/Infinity
+
+        //
+        // XXX:
+        // Requires It = char [const]* or char16_t [const]*
+        //
+        if (options.allow_nan_inf && last - next >= 3 && EqualASCII(next, "NaN", 3))
+        {
+            return {next + 3, NumberClass::nan};
+        }
+        if (options.allow_nan_inf && last - next >= 8 && EqualASCII(next, "Infinity", 8))
+        {
+            return {next + 8, is_neg ? NumberClass::neg_infinity : NumberClass::pos_infinity};
+        }
+
+        return {next, NumberClass::invalid};
+    }
+
+// frac
+
+    if (*next == '.')
+    {
+        is_float = true;
+
+        ++next;
+        if (next == last || !IsDigit(*next))
+            return {next, NumberClass::invalid};
+
+        for (;;)
+        {
+            ++next;
+            if (next == last)
+                return {next, NumberClass::floating_point};
+            if (!IsDigit(*next))
+                break;
+        }
+    }
+
+// exp
+
+    if (*next == 'e' || *next == 'E')
+    {
+        is_float = true;
+
+        ++next;
+        if (next == last)
+            return {next, NumberClass::invalid};
+
+        if (*next == '+' || *next == '-')
+        {
+            ++next;
+            if (next == last)
+                return {next, NumberClass::invalid};
+        }
+
+        if (!IsDigit(*next))
+            return {next, NumberClass::invalid};
+
+        for (;;)
+        {
+            ++next;
+            if (next == last)
+                return {next, NumberClass::floating_point};
+            if (!IsDigit(*next))
+                break;
+        }
+    }
+
+    return {next, is_float ? NumberClass::floating_point : NumberClass::integer};
+}
+
+
+//--------------------------------------------------------------------------------------------------
+//
+//--------------------------------------------------------------------------------------------------
+
+enum class TokenKind : unsigned char {
+    unknown,
+    eof,
+    l_brace,
+    r_brace,
+    l_square,
+    r_square,
+    comma,
+    colon,
+    string,
+    incomplete_string,
+    number,
+    identifier,
+    comment,
+    incomplete_comment,
+};
+
+template <typename CharT>
+struct Token
+{
+    CharT const* ptr = nullptr;
+    CharT const* end = nullptr;
+    TokenKind   kind = TokenKind::unknown;
+    bool        needs_cleaning = false;
+    NumberClass number_class = NumberClass::invalid;
+};
+
+template <typename CharT>
+struct Lexer
+{
+    using Tok = Token<CharT>;
+
+    CharT const* src = nullptr;
+    CharT const* end = nullptr;
+    CharT const* ptr = nullptr; // position in [src, end)
+
+    Lexer();
+    explicit Lexer(CharT const* first, CharT const* last);
+
+    Tok MakeToken(CharT const* p, TokenKind kind, bool needs_cleaning = false, NumberClass number_class = NumberClass::invalid);
+
+    Tok Lex(Options const& options);
+
+    Tok LexString    (CharT const* p);
+    Tok LexNumber    (CharT const* p, Options const& options);
+    Tok LexIdentifier(CharT const* p);
+    Tok LexComment   (CharT const* p);
+};
+
+template <typename CharT>
+Lexer<CharT>::Lexer()
+{
+}
+
+template <typename CharT>
+Lexer<CharT>::Lexer(CharT const* first, CharT const* last)
+    : src(first)
+    , end(last)
+    , ptr(first)
+{
+}
+
+template <typename CharT>
+Token<CharT> Lexer<CharT>::MakeToken(CharT const* p, TokenKind kind, bool needs_cleaning, NumberClass number_class)
+{
+    Tok tok;
+
+    tok.ptr = ptr;
+    tok.end = p;
+    tok.kind = kind;
+    tok.needs_cleaning = needs_cleaning;
+    tok.number_class = number_class;
+
+    ptr = p;
+
+    return tok;
+}
+
+template <typename CharT>
+Token<CharT> Lexer<CharT>::Lex(Options const& options)
+{
+L_again:
+    ptr = SkipWhitespace(ptr, end);
+
+    auto p = ptr;
+
+    if (p == end)
+        return MakeToken(p, TokenKind::eof);
+
+    auto kind = TokenKind::unknown;
+
+    CharT const ch = *p;
+    switch (ch)
+    {
+    case '{':
+        kind = TokenKind::l_brace;
+        break;
+    case '}':
+        kind = TokenKind::r_brace;
+        break;
+    case '[':
+        kind = TokenKind::l_square;
+        break;
+    case ']':
+        kind = TokenKind::r_square;
+        break;
+    case ',':
+        kind = TokenKind::comma;
+        break;
+    case ':':
+        kind = TokenKind::colon;
+        break;
+    case '"':
+        return LexString(p);
+    case '-':
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+        return LexNumber(p, options);
+    case 'a':
+    case 'b':
+    case 'c':
+    case 'd':
+    case 'e':
+    case 'f':
+    case 'g':
+    case 'h':
+    case 'i':
+    case 'j':
+    case 'k':
+    case 'l':
+    case 'm':
+    case 'n':
+    case 'o':
+    case 'p':
+    case 'q':
+    case 'r':
+    case 's':
+    case 't':
+    case 'u':
+    case 'v':
+    case 'w':
+    case 'x':
+    case 'y':
+    case 'z':
+    case 'A':
+    case 'B':
+    case 'C':
+    case 'D':
+    case 'E':
+    case 'F':
+    case 'G':
+    case 'H':
+    case 'I':
+    case 'J':
+    case 'K':
+    case 'L':
+    case 'M':
+    case 'N':
+    case 'O':
+    case 'P':
+    case 'Q':
+    case 'R':
+    case 'S':
+    case 'T':
+    case 'U':
+    case 'V':
+    case 'W':
+    case 'X':
+    case 'Y':
+    case 'Z':
+    case '_':
+        return LexIdentifier(p);
+    case '/':
+        if (options.strip_comments)
+        {
+            auto tok = LexComment(p);
+            if (tok.kind == TokenKind::comment)
+                goto L_again;
+        }
+        break;
+    default:
+        break;
+    }
+
+    ++p;
+    return MakeToken(p, kind);
+}
+
+template <typename CharT>
+Token<CharT> Lexer<CharT>::LexString(CharT const* p)
+{
+    using namespace json::charclass;
+
+    JSON_ASSERT(p != end);
+    JSON_ASSERT(*p == '"');
+
+    ptr = ++p; // skip " or '
+
+    unsigned mask = 0;
+    for (;;)
+    {
+        while (end - p >= 4)
+        {
+            unsigned const m0 = CharClass(p[0]);
+            unsigned const m1 = CharClass(p[1]);
+            unsigned const m2 = CharClass(p[2]);
+            unsigned const m3 = CharClass(p[3]);
+
+            unsigned const mm = m0 | m1 | m2 | m3;
+            if ((mm & CC_StringSpecial) == 0)
+            {
+                mask |= mm;
+                p += 4;
+                continue;
+            }
+
+            mask |= m0;        if ((m0 & CC_StringSpecial) != 0)   { goto L_check; }
+            mask |= m1; ++p;   if ((m1 & CC_StringSpecial) != 0)   { goto L_check; }
+            mask |= m2; ++p;   if ((m2 & CC_StringSpecial) != 0)   { goto L_check; }
+            mask |= m3; ++p; /*if ((m3 & CC_StringSpecial) != 0)*/ { goto L_check; }
+        }
+
+        for (;;)
+        {
+            if (p == end)
+                goto L_incomplete;
+
+            unsigned const m0 = CharClass(*p);
+            mask |= m0;
+            if ((m0 & CC_StringSpecial) != 0)
+                goto L_check;
+
+            ++p;
+        }
+
+L_check:
+        auto const ch = *p;
+
+        if (ch == '"')
+        {
+            auto tok = MakeToken(p, TokenKind::string, (mask & CC_NeedsCleaning) != 0);
+            ptr = ++p; // skip " or '
+            return tok;
+        }
+
+        JSON_ASSERT(ch == '\\');
+        ++p;
+        if (p == end)
+            break;
+        ++p; // Skip the escaped character.
+    }
+
+L_incomplete:
+    return MakeToken(p, TokenKind::incomplete_string, (mask & CC_NeedsCleaning) != 0);
+}
+
+template <typename CharT>
+Token<CharT> Lexer<CharT>::LexNumber(CharT const* p, Options const& options)
+{
+    auto const res = ScanNumber(p, end, options);
+
+    return MakeToken(res.next, TokenKind::number, /*needs_cleaning*/ false, res.number_class);
+}
+
+template <typename CharT>
+Token<CharT> Lexer<CharT>::LexIdentifier(CharT const* p)
+{
+    using namespace json::charclass;
+
+    for ( ; p != end && IsIdentifierBody(*p); ++p)
+    {
+    }
+
+    return MakeToken(p, TokenKind::identifier);
+}
+
+template <typename CharT>
+Token<CharT> Lexer<CharT>::LexComment(CharT const* p)
+{
+    JSON_ASSERT(p != end);
+    JSON_ASSERT(*p == '/');
+
+    ++p;
+    if (p == end)
+        return MakeToken(p, TokenKind::unknown);
+
+    if (*p == '/')
+    {
+        for (;;)
+        {
+            ++p;
+            if (p == end)
+                break;
+            if (*p == '\n' || *p == '\r')
+                break;
+        }
+
+        return MakeToken(p, TokenKind::comment);
+    }
+
+    if (*p == '*')
+    {
+        TokenKind kind = TokenKind::incomplete_comment;
+
+        for (;;)
+        {
+            ++p;
+            if (p == end)
+                break;
+            if (*p == '*')
+            {
+                ++p;
+                if (p == end)
+                    break;
+                if (*p == '/')
+                {
+                    kind = TokenKind::comment;
+                    ++p;
+                    break;
+                }
+            }
+        }
+
+        return MakeToken(p, kind);
+    }
+
+    return MakeToken(p, TokenKind::unknown);
+}
+
+//--------------------------------------------------------------------------------------------------
+//
+//--------------------------------------------------------------------------------------------------
+
+// Validates and skips values, without calling any callbacks.
+struct Skipper
+{
+    static constexpr int kMaxDepth = 500; // Must match Parser::kMaxDepth
+
+    Options     options;
+    Lexer<char> lexer;
+    Token<char> token; // The next token.
+    char const* value_end = nullptr; // The end of the last value which has been skipped.
+
+    explicit Skipper(Options const& options_) : options(options_) {}
+
+    ParseStatus SkipString();
+    ParseStatus SkipPrimitive();
+    ParseStatus SkipValue(size_t depth, size_t& count);
+};
+
+inline ParseStatus Skipper::SkipString()
+{
+    JSON_ASSERT(token.kind == TokenKind::string);
+
+    if (token.needs_cleaning && strings::ValidateString(token.ptr, token.end).status != strings::UnescapeStringStatus::success)
+        return ParseStatus::invalid_string;
+
+    return ParseStatus::success;
+}
+
+inline ParseStatus Skipper::SkipPrimitive()
+{
+    switch (token.kind)
+    {
+    case TokenKind::string:
+        if (SkipString() != ParseStatus::success)
+            return ParseStatus::invalid_string;
+        break;
+    case TokenKind::number:
+        if (token.number_class == NumberClass::invalid)
+            return ParseStatus::invalid_number;
+        break;
+    case TokenKind::identifier:
+        {
+            auto const f = token.ptr;
+            auto const len = token.end - token.ptr;
+            if (!(len == 4 && EqualASCII(f, "null", 4)) &&
+                !(len == 4 && EqualASCII(f, "true", 4)) &&
+                !(len == 5 && EqualASCII(f, "false", 5)) &&
+                !(options.allow_nan_inf && len == 3 && EqualASCII(f, "NaN", 3)) &&
+                !(options.allow_nan_inf && len == 8 && EqualASCII(f, "Infinity", 8)))
+            {
+                return ParseStatus::unrecognized_identifier;
+            }
+        }
+        break;
+    case TokenKind::eof:
+        return ParseStatus::unexpected_eof;
+    default:
+        return ParseStatus::unexpected_token;
+    }
+
+    value_end = lexer.ptr;
+    token = lexer.Lex(options);
+
+    return ParseStatus::success;
+}
+
+// Skips the value starting at TOKEN, which is nested DEPTH levels deep.
+// If the value is an array or object, COUNT is set to the number of its
+// elements resp. members.
+inline ParseStatus Skipper::SkipValue(size_t depth, size_t& count)
+{
+    bool is_object[kMaxDepth];
+    size_t stack_size = 0;
+
+    count = 0;
+
+    if (token.kind == TokenKind::l_brace || token.kind == TokenKind::l_square)
+        goto L_begin_structured;
+
+    return SkipPrimitive();
+
+L_begin_structured:
+    if (depth + stack_size >= kMaxDepth)
+        return ParseStatus::max_depth_reached;
+
+    is_object[stack_size++] = (token.kind == TokenKind::l_brace);
+
+    // skip '{' or '['
+    token = lexer.Lex(options);
+
+    if (is_object[stack_size - 1])
+    {
+        if (token.kind == TokenKind::r_brace)
+            goto L_end_structured;
+
+L_next_member:
+        if (token.kind != TokenKind::string)
+            return ParseStatus::expected_key;
+        {
+            auto const ec = SkipString();
+            if (ec != ParseStatus::success)
+                return ec;
+        }
+
+        // skip 'key'
+        token = lexer.Lex(options);
+
+        if (token.kind != TokenKind::colon)
+            return ParseStatus::expected_colon_after_key;
+
+        // skip ':'
+        token = lexer.Lex(options);
+
+        if (token.kind == TokenKind::l_brace || token.kind == TokenKind::l_square)
+            goto L_begin_structured;
+
+        {
+            auto const ec = SkipPrimitive();
+            if (ec != ParseStatus::success)
+                return ec;
+        }
+
+L_end_member:
+        if (stack_size == 1)
+            count++;
+
+        if (token.kind == TokenKind::comma)
+        {
+            // skip ','
+            token = lexer.Lex(options);
+
+            if (!options.allow_trailing_comma || token.kind != TokenKind::r_brace)
+                goto L_next_member;
+        }
+
+        if (token.kind != TokenKind::r_brace)
+            return ParseStatus::expected_comma_or_closing_brace;
+    }
+    else
+    {
+        if (token.kind == TokenKind::r_square)
+            goto L_end_structured;
+
+L_next_element:
+        if (token.kind == TokenKind::l_brace || token.kind == TokenKind::l_square)
+            goto L_begin_structured;
+
+        {
+            auto const ec = SkipPrimitive();
+            if (ec != ParseStatus::success)
+                return ec;
+        }
+
+L_end_element:
+        if (stack_size == 1)
+            count++;
+
+        if (token.kind == TokenKind::comma)
+        {
+            // skip ','
+            token = lexer.Lex(options);
+
+            if (!options.allow_trailing_comma || token.kind != TokenKind::r_square)
+                goto L_next_element;
+        }
+
+        if (token.kind != TokenKind::r_square)
+            return ParseStatus::expected_comma_or_closing_bracket;
+    }
+
+L_end_structured:
+    // skip '}' or ']'
+    value_end = lexer.ptr;
+    token = lexer.Lex(options);
+
+    JSON_ASSERT(stack_size != 0);
+    stack_size--;
+
+    if (stack_size == 0)
+        return ParseStatus::success;
+
+    if (is_object[stack_size - 1])
+        goto L_end_member;
+    else
+        goto L_end_element;
+}
+
+} // namespace lexer
+} // namespace json
@@ -22,10 +22,17 @@
 
 #include "json_charclass.h"
 
+// Define DTOA_OPTIMIZE_SIZE=0 and/or STRTOD_OPTIMIZE_SIZE=0 to use the full
+// tables of precomputed powers. This is faster, but adds ~9 KB (dtoa) resp.
+// ~5 KB (strtod) of read-only data. (See benchmark/numbers/result_numbers.txt.)
+#ifndef DTOA_OPTIMIZE_SIZE
 #define DTOA_OPTIMIZE_SIZE 1
+#endif
 #include "dtoa.h"
 
+#ifndef STRTOD_OPTIMIZE_SIZE
 #define STRTOD_OPTIMIZE_SIZE 1
+#endif
 #include "strtod.h"
 
 #include <cassert>
@@ -42,6 +49,9 @@
 using namespace json;
 using namespace json::numbers;
 
+int const json::numbers::kDtoaOptimizeSize = DTOA_OPTIMIZE_SIZE;
+int const json::numbers::kStrtodOptimizeSize = STRTOD_OPTIMIZE_SIZE;
+
 //==================================================================================================
 // NumberToString
 //==================================================================================================
@@ -110,16 +120,119 @@ char* json::numbers::NumberToString(char* next, char* last, double value, bool e
     return base_conv::Dtoa(next, last, value, emit_trailing_dot_zero, "NaN", "Infinity");
 }
 
+char* json::numbers::FloatToString(char* next, char* last, float value, bool emit_trailing_dot_zero)
+{
+    constexpr float kMinInteger = -16777216.0f; // -2^24
+    constexpr float kMaxInteger =  16777216.0f; //  2^24
+
+    // Same as above: print integers in the range [-2^24, +2^24] as integers.
+    if (value == 0)
+    {
+        if (std::signbit(value))
+        {
+            std::memcpy(next, "-0.0", 4);
+            return next + 4;
+        }
+        else
+        {
+            next[0] = '0';
+            return next + 1;
+        }
+    }
+    else if (kMinInteger <= value && value <= kMaxInteger)
+    {
+        const int64_t i = static_cast<int64_t>(value);
+        if (static_cast<float>(i) == value)
+        {
+            return I64ToString(next, last, i);
+        }
+    }
+
+    return base_conv::Dtoa(next, last, value, emit_trailing_dot_zero, "NaN", "Infinity");
+}
+
+//==================================================================================================
+// FloatToNumber
+//==================================================================================================
+
+double json::numbers::FloatToNumber(float value)
+{
+    constexpr float kMaxInteger = 16777216.0f; // 2^24
+
+    // Integers in the range [-2^24, +2^24] are printed as integers (see
+    // FloatToString), and so are NaN's, Infinity's and zeros: all of them are
+    // exactly representable as 'double's.
+    float const abs_value = std::abs(value);
+    if (!(abs_value > 0 && abs_value <= std::numeric_limits<float>::max()) ||
+        (abs_value <= kMaxInteger && static_cast<float>(static_cast<int32_t>(abs_value)) == abs_value))
+    {
+        return static_cast<double>(value);
+    }
+
+    char digits[base_conv::kFloatToDecimalMaxLength];
+    int num_digits;
+    int exponent;
+    base_conv::FloatToDecimal(digits, digits + base_conv::kFloatToDecimalMaxLength, num_digits, exponent, abs_value);
+
+    double const result = base_conv::DecimalToDouble(digits, num_digits, exponent);
+    return std::signbit(value) ? -result : result;
+}
+
+float json::numbers::NumberToFloat(double value)
+{
+    // The shortest decimal representation of VALUE lies strictly inside the
+    // rounding interval of VALUE, which contains no other double-precision
+    // number. All midpoints between adjacent single-precision numbers are
+    // exactly representable as doubles, so unless VALUE itself is such a
+    // midpoint, the decimal representation rounds to the same single-precision
+    // number as VALUE. (This includes NaN's, Infinity's and zeros.)
+    float const f = static_cast<float>(value);
+    if (!std::isfinite(value) || static_cast<double>(f) == value)
+    {
+        return f;
+    }
+
+    if (std::isfinite(f))
+    {
+        float const g = std::nextafter(f, value < static_cast<double>(f) ? -std::numeric_limits<float>::infinity() : std::numeric_limits<float>::infinity());
+        if (std::isfinite(g) && value != (static_cast<double>(f) + static_cast<double>(g)) / 2)
+        {
+            return f;
+        }
+    }
+
+    // VALUE is a midpoint (or rounds to +-Infinity). The rounding direction
+    // depends on the decimal digits.
+    char digits[base_conv::kDoubleToDecimalMaxLength];
+    int num_digits;
+    int exponent;
+    base_conv::DoubleToDecimal(digits, digits + base_conv::kDoubleToDecimalMaxLength, num_digits, exponent, std::abs(value));
+
+    float const result = base_conv::DecimalToFloat(digits, num_digits, exponent);
+    return std::signbit(value) ? -result : result;
+}
+
 //==================================================================================================
 // StringToNumber
 //==================================================================================================
 
-static bool StringToDouble(double& result, char const* next, char const* last, Options const& options)
+static void DecimalToBinary(double& result, char const* digits, int num_digits, int exponent, bool nonzero_tail)
+{
+    result = base_conv::DecimalToDouble(digits, num_digits, exponent, nonzero_tail);
+}
+
+static void DecimalToBinary(float& result, char const* digits, int num_digits, int exponent, bool nonzero_tail)
+{
+    result = base_conv::DecimalToFloat(digits, num_digits, exponent, nonzero_tail);
+}
+
+template <typename Float>
+static bool StringToBinary(Float& result, char const* next, char const* last, Options const& options)
 {
 #if 0
     if (next == last)
     {
-        result = 0.0;
+        result = Float{0};
         return true;
     }
 
@@ -133,13 +246,13 @@ static bool StringToDouble(double& result, char const* next, char const* last, O
 
     if (next == last)
     {
-        result = 0.0; // [Recover.]
+        result = Float{0}; // [Recover.]
         return true;
     }
 
     if (last - next >= kMaxInt)
     {
-        result = std::numeric_limits<double>::quiet_NaN();
+        result = std::numeric_limits<Float>::quiet_NaN();
         return false;
     }
 
@@ -158,7 +271,7 @@ static bool StringToDouble(double& result, char const* next, char const* last, O
         ++next;
         if (next == last)
         {
-            result = is_neg ? -0.0 : +0.0; // Recover.
+            result = is_neg ? -Float{0} : +Float{0}; // Recover.
             return false;
         }
     }
@@ -168,7 +281,7 @@ static bool StringToDouble(double& result, char const* next, char const* last, O
         ++next;
         if (next == last)
         {
-            result = is_neg ? -0.0 : +0.0; // Recover.
+            result = is_neg ? -Float{0} : +Float{0}; // Recover.
             return false;
         }
     }
@@ -179,7 +292,7 @@ static bool StringToDouble(double& result, char const* next, char const* last, O
         ++next;
         if (next == last)
         {
-            result = is_neg ? -0.0 : +0.0;
+            result = is_neg ? -Float{0} : +Float{0};
             return true;
         }
     }
@@ -188,6 +301,21 @@ static bool StringToDouble(double& result, char const* next, char const* last, O
         // Copy significant digits of the integer part (if any) to the buffer.
         for (;;)
         {
+            if (last - next >= 8 && num_digits <= kMaxSignificantDigits - 8 && base_conv::strtod_impl::IsEightDigits(next))
+            {
+                std::memcpy(digits + num_digits, next, 8);
+                num_digits += 8;
+                next += 8;
+                if (next == last)
+                {
+                    goto L_parsing_done;
+                }
+                if (!IsDigit(*next))
+                {
+                    break;
+                }
+            }
+
             if (num_digits < kMaxSignificantDigits)
             {
                 digits[num_digits++] = *next;
@@ -217,13 +345,13 @@ static bool StringToDouble(double& result, char const* next, char const* last, O
     {
         if (options.allow_nan_inf && last - next >= 3 && std::memcmp(next, "NaN", 3) == 0)
         {
-            result = std::numeric_limits<double>::quiet_NaN();
+            result = std::numeric_limits<Float>::quiet_NaN();
             return true;
         }
 
         if (options.allow_nan_inf && last - next >= 8 && std::memcmp(next, "Infinity", 8) == 0)
         {
-            result = is_neg ? -std::numeric_limits<double>::infinity() : std::numeric_limits<double>::infinity();
+            result = is_neg ? -std::numeric_limits<Float>::infinity() : std::numeric_limits<Float>::infinity();
             return true;
         }
 
@@ -248,7 +376,7 @@ static bool StringToDouble(double& result, char const* next, char const* last, O
                 ++next;
                 if (next == last)
                 {
-                    result = is_neg ? -0.0 : +0.0;
+                    result = is_neg ? -Float{0} : +Float{0};
                     return true;
                 }
 
@@ -261,6 +389,19 @@ static bool StringToDouble(double& result, char const* next, char const* last, O
         // We don't emit a '.', but adjust the exponent instead.
         while (IsDigit(*next))
         {
+            if (last - next >= 8 && num_digits <= kMaxSignificantDigits - 8 && base_conv::strtod_impl::IsEightDigits(next))
+            {
+                std::memcpy(digits + num_digits, next, 8);
+                num_digits += 8;
+                exponent -= 8;
+                next += 8;
+                if (next == last)
+                {
+                    goto L_parsing_done;
+                }
+                continue;
+            }
+
             if (num_digits < kMaxSignificantDigits)
             {
                 digits[num_digits++] = *next;
@@ -347,7 +488,8 @@ L_parsing_done:
         return false;
     }
 
-    double const value = base_conv::DecimalToDouble(digits, num_digits, exponent, nonzero_tail);
+    Float value;
+    DecimalToBinary(value, digits, num_digits, exponent, nonzero_tail);
     JSON_ASSERT(!std::signbit(value));
 
     result = is_neg ? -value : value;
@@ -425,7 +567,7 @@ double json::numbers::StringToNumber(char const* first, char const* last, Number
     }
 
     double result;
-    if (StringToDouble(result, first, last, Options{}))
+    if (StringToBinary(result, first, last, Options{}))
     {
         return result;
     }
@@ -436,7 +578,7 @@ double json::numbers::StringToNumber(char const* first, char const* last, Number
 
 bool json::numbers::StringToNumber(double& result, char const* first, char const* last, Options const& options)
 {
-    if (StringToDouble(result, first, last, options))
+    if (StringToBinary(result, first, last, options))
     {
         return true;
     }
@@ -444,3 +586,262 @@ bool json::numbers::StringToNumber(double& result, char const* first, char const
     result = std::numeric_limits<double>::quiet_NaN();
     return false;
 }
+
+float json::numbers::StringToFloat(char const* first, char const* last, NumberClass nc)
+{
+    JSON_ASSERT(first != last);
+    JSON_ASSERT(nc != NumberClass::invalid);
+
+    if (nc == NumberClass::nan) {
+        return std::numeric_limits<float>::quiet_NaN();
+    }
+    if (nc == NumberClass::pos_infinity) {
+        return +std::numeric_limits<float>::infinity();
+    }
+    if (nc == NumberClass::neg_infinity) {
+        return -std::numeric_limits<float>::infinity();
+    }
+
+    float result;
+    if (StringToBinary(result, first, last, Options{}))
+    {
+        return result;
+    }
+
+    JSON_ASSERT(false && "unreachable");
+    return std::numeric_limits<float>::quiet_NaN();
+}
+
+bool json::numbers::StringToFloat(float& result, char const* first, char const* last, Options const& options)
+{
+    if (StringToBinary(result, first, last, options))
+    {
+        return true;
+    }
+
+    result = std::numeric_limits<float>::quiet_NaN();
+    return false;
+}
+
+double json::numbers::StringToFloatNumber(char const* first, char const* last, NumberClass nc)
+{
+    JSON_ASSERT(first != last);
+    JSON_ASSERT(nc != NumberClass::invalid);
+
+    // Decimal numbers with at most 6 (FLT_DIG) significant digits round-trip
+    // through normalized single-precision numbers, i.e. such an input is the
+    // shortest decimal representation of the single-precision number closest
+    // to it. Then the result is just the double-precision number closest to the
+    // input.
+    if (nc == NumberClass::integer || nc == NumberClass::floating_point)
+    {
+        char const* p = first;
+        if (*p == '-')
+            ++p;
+        while (p != last && (*p == '0' || *p == '.'))
+            ++p;
+
+        int num_digits = 0;
+        for ( ; p != last && *p != 'e' && *p != 'E'; ++p)
+        {
+            if (*p != '.')
+                ++num_digits;
+        }
+
+        if (num_digits <= 6)
+        {
+            double const value = StringToNumber(first, last, nc);
+            double const abs_value = std::abs(value);
+            if (abs_value == 0 || (abs_value >= static_cast<double>(std::numeric_limits<float>::min()) &&
+                                   abs_value <= static_cast<double>(std::numeric_limits<float>::max())))
+            {
+                return value;
+            }
+        }
+    }
+
+    return FloatToNumber(StringToFloat(first, last, nc));
+}
+
+//==================================================================================================
+// StringsToNumbers
+//==================================================================================================
+
+// Reads a sequence of decimal digits into w.
+// Returns the number of digits read (including leading zeros). If this is larger
+// than 19, w might have overflowed.
+static int ReadDigits(uint64_t& w, char const*& next, char const* last)
+{
+    using namespace json::charclass;
+
+    char const* const first = next;
+
+    for (;;)
+    {
+        if (last - next < 8)
+            break;
+
+        uint64_t const chars = base_conv::strtod_impl::LoadEightChars(next);
+        if (!base_conv::strtod_impl::IsEightDigits(chars))
+            break;
+
+        w = 100000000 * w + base_conv::strtod_impl::ParseEightDigits(chars);
+        next += 8;
+    }
+
+    for ( ; next != last && IsDigit(*next); ++next)
+    {
+        w = 10 * w + static_cast<uint32_t>(HexDigitValue(*next));
+    }
+
+    return static_cast<int>(next - first);
+}
+
+// Converts numbers of the form '-?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?'
+// with at most 19 digits (excluding the exponent) directly, without copying the
+// digits into a buffer first.
+// Returns false if the input is not of this form, or if the fast algorithms
+// fail to determine the correctly rounded result.
+static bool TryShortStringToDouble(double& result, char const* next, char const* last)
+{
+    using namespace json::charclass;
+
+    constexpr int kMaxDigits = 19; // 10^19 - 1 < 2^64
+    constexpr int kMaxExponentDigits = 4;
+
+    if (next == last)
+        return false;
+
+    bool const is_neg = (*next == '-');
+    if (is_neg)
+    {
+        ++next;
+        if (next == last)
+            return false;
+    }
+
+    uint64_t w = 0;
+    int num_digits = 0;
+    int exponent = 0;
+
+    if (*next == '0')
+    {
+        ++next;
+    }
+    else if (IsDigit(*next))
+    {
+        num_digits = ReadDigits(w, next, last);
+    }
+    else
+    {
+        return false;
+    }
+
+    if (next != last && *next == '.')
+    {
+        ++next;
+
+        int const num_fraction_digits = ReadDigits(w, next, last);
+        if (num_fraction_digits == 0)
+            return false;
+
+        num_digits += num_fraction_digits;
+        exponent = -num_fraction_digits;
+    }
+
+    if (num_digits > kMaxDigits)
+        return false;
+
+    if (next != last && (*next == 'e' || *next == 'E'))
+    {
+        ++next;
+        if (next == last)
+            return false;
+
+        bool const exp_is_neg = (*next == '-');
+        if (*next == '+' || exp_is_neg)
+            ++next;
+
+        uint64_t e = 0;
+        int const num_exponent_digits = ReadDigits(e, next, last);
+        if (num_exponent_digits == 0 || num_exponent_digits > kMaxExponentDigits)
+            return false;
+
+        exponent += exp_is_neg ? -static_cast<int>(e) : static_cast<int>(e);
+    }
+
+    if (next != last)
+        return false;
+
+    double value;
+    if (w == 0)
+    {
+        value = 0.0;
+    }
+    else if (num_digits <= base_conv::strtod_impl::kMaxExactDoubleIntegerDecimalDigits
+             && base_conv::strtod_impl::FastPath(value, w, num_digits, exponent))
+    {
+    }
+#if STRTOD_EISEL_LEMIRE
+    else if (base_conv::strtod_impl::EiselLemire(value, w, exponent))
+    {
+    }
+#endif
+    else
+    {
+        return false;
+    }
+
+    result = is_neg ? -value : value;
+    return true;
+}
+
+bool json::numbers::StringsToNumbers(double* values, NumberString const* strings, size_t count, Options const& options)
+{
+    bool success = true;
+
+    for (size_t i = 0; i != count; ++i)
+    {
+        auto const& s = strings[i];
+
+        if (TryShortStringToDouble(values[i], s.first, s.last))
+            continue;
+
+        if (!StringToBinary(values[i], s.first, s.last, options))
+        {
+            values[i] = std::numeric_limits<double>::quiet_NaN();
+            success = false;
+        }
+    }
+
+    return success;
+}
+
+//==================================================================================================
+// NumbersToString
+//==================================================================================================
+
+void json::numbers::NumbersToString(std::string& str, double const* values, size_t count, char separator, bool emit_trailing_dot_zero)
+{
+    constexpr size_t kMaxLength = 32;
+
+    if (count == 0)
+        return;
+
+    // Reserve enough memory for the worst case. This allows to write the numbers
+    // directly into the string.
+    size_t const pos = str.size();
+    str.resize(pos + count * (kMaxLength + 1));
+
+    char* const first = &str[pos];
+    char* next = first;
+
+    next = NumberToString(next, next + kMaxLength, values[0], emit_trailing_dot_zero);
+    for (size_t i = 1; i != count; ++i)
+    {
+        *next++ = separator;
+        next = NumberToString(next, next + kMaxLength, values[i], emit_trailing_dot_zero);
+    }
+
+    str.resize(pos + static_cast<size_t>(next - first));
+}
@@ -23,14 +23,27 @@
 #include "json_options.h"
 #include "json_parse.h" // XXX: For NumberClass
 
+#include <cstddef>
+#include <string>
+
 namespace json {
 namespace numbers {
 
+// The values of DTOA_OPTIMIZE_SIZE and STRTOD_OPTIMIZE_SIZE which were used to
+// compile the number conversion routines.
+extern int const kDtoaOptimizeSize;
+extern int const kStrtodOptimizeSize;
+
 // Convert the double-precision number `value` to a decimal floating-point
 // number.
 // The buffer must be large enough! (size >= 32 is sufficient.)
 char* NumberToString(char* next, char* last, double value, bool emit_trailing_dot_zero = true);
 
+// Convert the single-precision number `value` to the shortest decimal
+// floating-point number which round-trips as a single-precision number.
+// The buffer must be large enough! (size >= 32 is sufficient.)
+char* FloatToString(char* next, char* last, float value, bool emit_trailing_dot_zero = true);
+
 // Convert the string `[first, last)` to a double-precision value.
 // The string must be valid according to the JSON grammar and match the number
 // class defined by `nc` (which must not be `NumberClass::invalid`).
@@ -41,5 +54,54 @@ double StringToNumber(char const* first, char const* last, NumberClass nc);
 // Otherwise returns false and stores 'NaN' in `result`.
 bool StringToNumber(double& result, char const* first, char const* last, Options const& options = {});
 
+// Convert the string `[first, last)` to a single-precision value.
+// The result is correctly rounded (i.e. not the result of rounding the
+// double-precision value to single-precision).
+// The string must be valid according to the JSON grammar and match the number
+// class defined by `nc` (which must not be `NumberClass::invalid`).
+float StringToFloat(char const* first, char const* last, NumberClass nc);
+
+// Convert the string `[first, last)` to a single-precision value.
+// Returns true if the string is a valid number according to the JSON grammar.
+// Otherwise returns false and stores 'NaN' in `result`.
+bool StringToFloat(float& result, char const* first, char const* last, Options const& options = {});
+
+// Returns the double-precision number closest to the shortest decimal
+// representation of `value`, i.e. StringToNumber(FloatToString(value)).
+// (Computed directly from the decimal digits, without formatting a string.)
+double FloatToNumber(float value);
+
+// Returns the single-precision number closest to the shortest decimal
+// representation of `value`, i.e. StringToFloat(NumberToString(value)).
+// (Computed directly from the decimal digits, without formatting a string.)
+float NumberToFloat(double value);
+
+// Convert the string `[first, last)` to a single-precision value and return the
+// double-precision number closest to its shortest decimal representation,
+// i.e. FloatToNumber(StringToFloat(first, last, nc)).
+// The string must be valid according to the JSON grammar and match the number
+// class defined by `nc` (which must not be `NumberClass::invalid`).
+double StringToFloatNumber(char const* first, char const* last, NumberClass nc);
+
+// A string [first, last) containing a number.
+// (As passed to ParseCallbacks::HandleNumber.)
+struct NumberString
+{
+    char const* first;
+    char const* last;
+};
+
+// Convert the strings `strings[0...count)` to double-precision values.
+// Returns true if all strings are valid numbers according to the JSON grammar.
+// Otherwise returns false and stores 'NaN' for the invalid strings.
+// This is faster than calling StringToNumber for each string: Common short
+// numbers are converted without copying the digits into a buffer.
+bool StringsToNumbers(double* values, NumberString const* strings, size_t count, Options const& options = {});
+
+// Appends the numbers `values[0...count)` to `str`, separated by `separator`.
+// This is faster than calling NumberToString for each number, since the output
+// is written directly into `str`.
+void NumbersToString(std::string& str, double const* values, size_t count, char separator = ',', bool emit_trailing_dot_zero = true);
+
 } // namespace numbers
 } // namespace json
@@ -0,0 +1,676 @@
+// Copyright 2018 Alexander Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "json_ondemand.h"
+#include "json_decode.h"
+#include "json_lexer.h"
+#include "json_numbers.h"
+#include "json_strings.h"
+
+#include <cstring>
+
+using namespace json;
+using namespace json::lexer;
+
+//==================================================================================================
+// Cursor
+//==================================================================================================
+
+struct ondemand::Document::Cursor
+{
+    // Lexes the token at the cursor.
+    static void Begin(Document const& doc, Skipper& sk)
+    {
+        sk.lexer = Lexer<char>(doc.first_, doc.last_);
+        sk.lexer.ptr = doc.pos_;
+        sk.token = sk.lexer.Lex(doc.options_);
+    }
+
+    static void Fail(Document& doc, ParseStatus ec, char const* ptr)
+    {
+        doc.status_ = ec;
+        doc.error_ptr_ = ptr;
+    }
+
+    // Returns whether the cursor is still at the value POS.
+    static bool IsCurrent(Document const& doc, char const* pos)
+    {
+        return doc.status_ == ParseStatus::success && doc.state_ == State::value && doc.pos_ == pos;
+    }
+
+    static int  Advance(Document& doc, bool consume_close);
+    static bool Unwind(Document& doc, size_t depth, char const* start);
+    static bool Enter(Document& doc, char const* pos, bool is_object);
+    static bool Peek(Document& doc, char const* pos, Token<char>& token);
+    template <typename Fn>
+    static bool Read(Document& doc, char const* pos, Fn fn);
+    static bool KeyEquals(Document& doc, char const* key, size_t length);
+};
+
+// Moves the cursor to the next member resp. element of the innermost object
+// resp. array, skipping the current value if it has not been consumed.
+// Returns 1 if there is a next member resp. element, 0 at the end of the
+// object resp. array, and -1 on error.
+// If CONSUME_CLOSE is true, the closing bracket is consumed, and the cursor
+// moves to the enclosing object or array. Otherwise, the cursor stays in front
+// of the closing bracket.
+int ondemand::Document::Cursor::Advance(Document& doc, bool consume_close)
+{
+    JSON_ASSERT(!doc.stack_.empty());
+
+    if (doc.status_ != ParseStatus::success)
+        return -1;
+
+    Skipper sk(doc.options_);
+    Begin(doc, sk);
+
+    bool const is_object = doc.stack_.back().is_object;
+    TokenKind const close = is_object ? TokenKind::r_brace : TokenKind::r_square;
+
+    if (doc.state_ == State::value)
+    {
+        size_t count;
+        auto const ec = sk.SkipValue(doc.stack_.size(), count);
+        if (ec != ParseStatus::success)
+        {
+            Fail(doc, ec, sk.token.ptr);
+            return -1;
+        }
+
+        doc.pos_ = sk.value_end;
+        doc.state_ = State::next;
+    }
+
+    char const* element_pos = doc.pos_;
+    if (doc.state_ == State::next)
+    {
+        if (sk.token.kind == TokenKind::comma)
+        {
+            // skip ','
+            element_pos = sk.lexer.ptr;
+            sk.token = sk.lexer.Lex(doc.options_);
+
+            if (doc.options_.allow_trailing_comma && sk.token.kind == close)
+                goto L_close;
+        }
+        else if (sk.token.kind == close)
+        {
+            goto L_close;
+        }
+        else
+        {
+            Fail(doc, is_object ? ParseStatus::expected_comma_or_closing_brace : ParseStatus::expected_comma_or_closing_bracket, sk.token.ptr);
+            return -1;
+        }
+    }
+    else
+    {
+        JSON_ASSERT(doc.state_ == State::first);
+
+        if (sk.token.kind == close)
+            goto L_close;
+    }
+
+    if (is_object)
+    {
+        if (sk.token.kind != TokenKind::string)
+        {
+            Fail(doc, ParseStatus::expected_key, sk.token.ptr);
+            return -1;
+        }
+        if (sk.SkipString() != ParseStatus::success)
+        {
+            Fail(doc, ParseStatus::invalid_string, sk.token.ptr);
+            return -1;
+        }
+
+        doc.key_first_ = sk.token.ptr;
+        doc.key_last_ = sk.token.end;
+        doc.key_needs_cleaning_ = sk.token.needs_cleaning;
+
+        // skip 'key'
+        sk.token = sk.lexer.Lex(doc.options_);
+
+        if (sk.token.kind != TokenKind::colon)
+        {
+            Fail(doc, ParseStatus::expected_colon_after_key, sk.token.ptr);
+            return -1;
+        }
+
+        // The value starts after the ':'
+        element_pos = sk.lexer.ptr;
+    }
+
+    doc.pos_ = element_pos;
+    doc.state_ = State::value;
+    return 1;
+
+L_close:
+    if (consume_close)
+    {
+        doc.pos_ = sk.lexer.ptr;
+        doc.state_ = State::next;
+        doc.stack_.pop_back();
+    }
+    return 0;
+}
+
+// Moves the cursor back into the object or array which has been entered at
+// START, at nesting level DEPTH, by skipping the rest of all nested objects and
+// arrays. Returns false if that object or array has already been left.
+bool ondemand::Document::Cursor::Unwind(Document& doc, size_t depth, char const* start)
+{
+    JSON_ASSERT(depth > 0);
+
+    if (doc.status_ != ParseStatus::success)
+        return false;
+    if (doc.stack_.size() < depth || doc.stack_[depth - 1].start != start)
+        return false;
+
+    while (doc.stack_.size() > depth)
+    {
+        if (Advance(doc, /*consume_close*/ true) < 0)
+            return false;
+    }
+
+    return true;
+}
+
+bool ondemand::Document::Cursor::Enter(Document& doc, char const* pos, bool is_object)
+{
+    if (!IsCurrent(doc, pos))
+        return false;
+
+    Skipper sk(doc.options_);
+    Begin(doc, sk);
+
+    if (sk.token.kind != (is_object ? TokenKind::l_brace : TokenKind::l_square))
+    {
+        size_t count;
+        auto const ec = sk.SkipValue(doc.stack_.size(), count);
+        if (ec != ParseStatus::success)
+        {
+            Fail(doc, ec, sk.token.ptr);
+            return false;
+        }
+
+        doc.pos_ = sk.value_end;
+        doc.state_ = State::next;
+        return false;
+    }
+
+    if (doc.stack_.size() >= static_cast<size_t>(Skipper::kMaxDepth))
+    {
+        Fail(doc, ParseStatus::max_depth_reached, sk.token.ptr);
+        return false;
+    }
+
+    // skip '{' or '['
+    doc.pos_ = sk.lexer.ptr;
+    doc.state_ = State::first;
+    doc.stack_.push_back({doc.pos_, is_object});
+    return true;
+}
+
+// Returns the first token of the value POS, without consuming the value.
+bool ondemand::Document::Cursor::Peek(Document& doc, char const* pos, Token<char>& token)
+{
+    if (!IsCurrent(doc, pos))
+        return false;
+
+    Skipper sk(doc.options_);
+    Begin(doc, sk);
+
+    token = sk.token;
+    return true;
+}
+
+// Consumes the value POS, and calls FN with its first token and its end.
+template <typename Fn>
+bool ondemand::Document::Cursor::Read(Document& doc, char const* pos, Fn fn)
+{
+    if (!IsCurrent(doc, pos))
+        return false;
+
+    Skipper sk(doc.options_);
+    Begin(doc, sk);
+
+    auto const token = sk.token;
+
+    size_t count;
+    auto const ec = sk.SkipValue(doc.stack_.size(), count);
+    if (ec != ParseStatus::success)
+    {
+        Fail(doc, ec, sk.token.ptr);
+        return false;
+    }
+
+    doc.pos_ = sk.value_end;
+    doc.state_ = State::next;
+
+    return fn(token, sk.value_end);
+}
+
+bool ondemand::Document::Cursor::KeyEquals(Document& doc, char const* key, size_t length)
+{
+    char const* first = doc.key_first_;
+    char const* last = doc.key_last_;
+
+    if (doc.key_needs_cleaning_)
+    {
+        strings::UnescapeStringBulk(doc.key_buffer_, first, last);
+        first = doc.key_buffer_.data();
+        last = doc.key_buffer_.data() + doc.key_buffer_.size();
+    }
+
+    return static_cast<size_t>(last - first) == length && std::memcmp(first, key, length) == 0;
+}
+
+//==================================================================================================
+// Value
+//==================================================================================================
+
+Type ondemand::Value::type()
+{
+    Token<char> token;
+    if (doc_ == nullptr || !Document::Cursor::Peek(*doc_, pos_, token))
+        return Type::undefined;
+
+    switch (token.kind)
+    {
+    case TokenKind::l_brace:
+        return Type::object;
+    case TokenKind::l_square:
+        return Type::array;
+    case TokenKind::string:
+        return Type::string;
+    case TokenKind::number:
+        return Type::number;
+    case TokenKind::identifier:
+        {
+            auto const f = token.ptr;
+            auto const len = token.end - token.ptr;
+            if (len == 4 && EqualASCII(f, "null", 4))
+                return Type::null;
+            if ((len == 4 && EqualASCII(f, "true", 4)) || (len == 5 && EqualASCII(f, "false", 5)))
+                return Type::boolean;
+            if (doc_->options_.allow_nan_inf && ((len == 3 && EqualASCII(f, "NaN", 3)) || (len == 8 && EqualASCII(f, "Infinity", 8))))
+                return Type::number;
+        }
+        return Type::undefined;
+    default:
+        return Type::undefined;
+    }
+}
+
+bool ondemand::Value::is_null()
+{
+    if (type() != Type::null)
+        return false;
+
+    return skip();
+}
+
+bool ondemand::Value::get(bool& value)
+{
+    if (doc_ == nullptr)
+        return false;
+
+    return Document::Cursor::Read(*doc_, pos_, [&](Token<char> const& token, char const* /*end*/) {
+        if (token.kind != TokenKind::identifier)
+            return false;
+        // The identifier has been validated.
+        value = (*token.ptr == 't');
+        return *token.ptr == 't' || *token.ptr == 'f';
+    });
+}
+
+bool ondemand::Value::get(double& value)
+{
+    if (doc_ == nullptr)
+        return false;
+
+    return Document::Cursor::Read(*doc_, pos_, [&](Token<char> const& token, char const* /*end*/) {
+        if (token.kind == TokenKind::number)
+        {
+            value = numbers::StringToNumber(token.ptr, token.end, token.number_class);
+            return true;
+        }
+        if (token.kind == TokenKind::identifier && *token.ptr == 'N')
+        {
+            value = numbers::StringToNumber("NaN", "NaN" + 3, NumberClass::nan);
+            return true;
+        }
+        if (token.kind == TokenKind::identifier && *token.ptr == 'I')
+        {
+            value = numbers::StringToNumber("Infinity", "Infinity" + 8, NumberClass::pos_infinity);
+            return true;
+        }
+        return false;
+    });
+}
+
+bool ondemand::Value::get(int64_t& value)
+{
+    if (doc_ == nullptr)
+        return false;
+
+    return Document::Cursor::Read(*doc_, pos_, [&](Token<char> const& token, char const* /*end*/) {
+        if (token.kind != TokenKind::number || token.number_class != NumberClass::integer)
+            return false;
+        return impl::DecodeInteger(value, token.ptr, token.end);
+    });
+}
+
+bool ondemand::Value::get(uint64_t& value)
+{
+    if (doc_ == nullptr)
+        return false;
+
+    return Document::Cursor::Read(*doc_, pos_, [&](Token<char> const& token, char const* /*end*/) {
+        if (token.kind != TokenKind::number || token.number_class != NumberClass::integer)
+            return false;
+        return impl::DecodeInteger(value, token.ptr, token.end);
+    });
+}
+
+bool ondemand::Value::get(std::string& value)
+{
+    if (doc_ == nullptr)
+        return false;
+
+    return Document::Cursor::Read(*doc_, pos_, [&](Token<char> const& token, char const* /*end*/) {
+        if (token.kind != TokenKind::string)
+            return false;
+
+        if (token.needs_cleaning)
+            strings::UnescapeStringBulk(value, token.ptr, token.end);
+        else
+            value.assign(token.ptr, token.end);
+        return true;
+    });
+}
+
+bool ondemand::Value::get_boolean(bool default_value)
+{
+    bool value;
+    return get(value) ? value : default_value;
+}
+
+double ondemand::Value::get_number(double default_value)
+{
+    double value;
+    return get(value) ? value : default_value;
+}
+
+int64_t ondemand::Value::get_int64(int64_t default_value)
+{
+    int64_t value;
+    return get(value) ? value : default_value;
+}
+
+uint64_t ondemand::Value::get_uint64(uint64_t default_value)
+{
+    uint64_t value;
+    return get(value) ? value : default_value;
+}
+
+std::string ondemand::Value::get_string(std::string default_value)
+{
+    std::string value;
+    return get(value) ? value : default_value;
+}
+
+ondemand::Array ondemand::Value::get_array()
+{
+    if (doc_ == nullptr || !Document::Cursor::Enter(*doc_, pos_, /*is_object*/ false))
+        return {};
+
+    return Array(doc_, doc_->stack_.size(), doc_->pos_);
+}
+
+ondemand::Object ondemand::Value::get_object()
+{
+    if (doc_ == nullptr || !Document::Cursor::Enter(*doc_, pos_, /*is_object*/ true))
+        return {};
+
+    return Object(doc_, doc_->stack_.size(), doc_->pos_);
+}
+
+ondemand::Value ondemand::Value::operator[](char const* key)
+{
+    return get_object()[key];
+}
+
+ondemand::Value ondemand::Value::operator[](std::string const& key)
+{
+    return get_object()[key];
+}
+
+bool ondemand::Value::skip()
+{
+    if (doc_ == nullptr)
+        return false;
+
+    return Document::Cursor::Read(*doc_, pos_, [](Token<char> const& /*token*/, char const* /*end*/) {
+        return true;
+    });
+}
+
+bool ondemand::Value::raw_json(char const*& first, char const*& last)
+{
+    if (doc_ == nullptr)
+        return false;
+
+    return Document::Cursor::Read(*doc_, pos_, [&](Token<char> const& token, char const* end) {
+        // Strings start at the opening quote.
+        first = (token.kind == TokenKind::string) ? token.ptr - 1 : token.ptr;
+        last = end;
+        return true;
+    });
+}
+
+//==================================================================================================
+// Array
+//==================================================================================================
+
+ondemand::Value ondemand::Array::next()
+{
+    if (doc_ == nullptr || !Document::Cursor::Unwind(*doc_, depth_, start_))
+        return {};
+
+    if (Document::Cursor::Advance(*doc_, /*consume_close*/ true) <= 0)
+        return {};
+
+    return Value(doc_, doc_->pos_);
+}
+
+//==================================================================================================
+// Object
+//==================================================================================================
+
+ondemand::Value ondemand::Object::next(std::string& key)
+{
+    if (doc_ == nullptr || !Document::Cursor::Unwind(*doc_, depth_, start_))
+        return {};
+
+    if (Document::Cursor::Advance(*doc_, /*consume_close*/ true) <= 0)
+        return {};
+
+    if (doc_->key_needs_cleaning_)
+        strings::UnescapeStringBulk(key, doc_->key_first_, doc_->key_last_);
+    else
+        key.assign(doc_->key_first_, doc_->key_last_);
+
+    return Value(doc_, doc_->pos_);
+}
+
+ondemand::Value ondemand::Object::find(char const* key, size_t length)
+{
+    if (doc_ == nullptr || !Document::Cursor::Unwind(*doc_, depth_, start_))
+        return {};
+
+    auto& doc = *doc_;
+
+    // Search up to the end of the object, then from the start of the object up
+    // to the original position.
+    char const* const orig_pos = doc.pos_;
+    auto const orig_state = doc.state_;
+
+    bool wrapped = false;
+    for (;;)
+    {
+        int const res = Document::Cursor::Advance(doc, /*consume_close*/ false);
+        if (res < 0)
+            return {};
+
+        if (res == 0)
+        {
+            if (wrapped)
+                return {};
+
+            wrapped = true;
+            doc.pos_ = start_;
+            doc.state_ = Document::State::first;
+
+            if (orig_state == Document::State::first)
+                return {}; // Already searched the whole object.
+            continue;
+        }
+
+        if (wrapped)
+        {
+            if (doc.pos_ > orig_pos)
+                return {};
+            if (doc.pos_ == orig_pos && orig_state != Document::State::value)
+                return {};
+        }
+
+        if (Document::Cursor::KeyEquals(doc, key, length))
+            return Value(doc_, doc.pos_);
+
+        if (wrapped && doc.pos_ == orig_pos)
+            return {};
+    }
+}
+
+ondemand::Value ondemand::Object::operator[](char const* key)
+{
+    return find(key, std::strlen(key));
+}
+
+ondemand::Value ondemand::Object::operator[](std::string const& key)
+{
+    return find(key.data(), key.size());
+}
+
+//==================================================================================================
+// Document
+//==================================================================================================
+
+static char const* SkipBOM(char const* next, char const* last)
+{
+    if (last - next >= 3)
+    {
+        if (static_cast<unsigned char>(next[0]) == 0xEF &&
+            static_cast<unsigned char>(next[1]) == 0xBB &&
+            static_cast<unsigned char>(next[2]) == 0xBF)
+        {
+            next += 3;
+        }
+    }
+
+    return next;
+}
+
+ondemand::Document::Document(char const* first, char const* last, Options const& options)
+    : first_(first)
+    , last_(last)
+    , root_(options.skip_bom ? SkipBOM(first, last) : first)
+    , pos_(root_)
+    , options_(options)
+{
+}
+
+ondemand::Document::Document(std::string const& str, Options const& options)
+    : Document(str.data(), str.data() + str.size(), options)
+{
+}
+
+ondemand::Value ondemand::Document::root()
+{
+    return Value(this, root_);
+}
+
+ondemand::Object ondemand::Document::RootObject()
+{
+    if (stack_.empty())
+        return root().get_object();
+
+    if (!stack_[0].is_object)
+        return {};
+
+    return Object(this, 1, stack_[0].start);
+}
+
+ondemand::Value ondemand::Document::operator[](char const* key)
+{
+    return RootObject()[key];
+}
+
+ondemand::Value ondemand::Document::operator[](std::string const& key)
+{
+    return RootObject()[key];
+}
+
+ParseStatus ondemand::Document::finish()
+{
+    while (status_ == ParseStatus::success && !stack_.empty())
+    {
+        Cursor::Advance(*this, /*consume_close*/ true);
+    }
+
+    if (status_ != ParseStatus::success)
+        return status_;
+
+    Skipper sk(options_);
+    Cursor::Begin(*this, sk);
+
+    if (state_ == State::value)
+    {
+        size_t count;
+        auto const ec = sk.SkipValue(0, count);
+        if (ec != ParseStatus::success)
+        {
+            Cursor::Fail(*this, ec, sk.token.ptr);
+            return status_;
+        }
+
+        pos_ = sk.value_end;
+        state_ = State::next;
+    }
+
+    if (!options_.allow_trailing_characters && sk.token.kind != TokenKind::eof)
+    {
+        Cursor::Fail(*this, ParseStatus::expected_eof, sk.token.ptr);
+    }
+
+    return status_;
+}
@@ -0,0 +1,265 @@
+// Copyright 2018 Alexander Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "json.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//
+// On-demand parsing.
+//
+// A Document keeps a reference to the input and a cursor. Values are parsed
+// when they are accessed, and objects and arrays are iterated forward-only,
+// directly over the JSON text. No json::Value is ever created.
+//
+//      json::ondemand::Document doc(str);
+//      int64_t const id = doc["user"]["id"].get_int64();
+//
+//      auto items = doc["items"].get_array();
+//      while (auto item = items.next()) {
+//          auto obj = item.get_object();
+//          std::string const name = obj["name"].get_string();
+//          ...
+//      }
+//
+// Handles (Value, Array, Object) are positions in the input: A Value may be
+// consumed only once, and only while the cursor is still at the value. Moving
+// on in an enclosing object or array skips the rest of all nested objects and
+// arrays. Skipped values are still validated.
+//
+// Syntax errors are sticky: once an error has been detected, all subsequent
+// operations fail, and status() returns the error.
+//
+
+namespace json {
+namespace ondemand {
+
+class Array;
+class Document;
+class Object;
+
+//==================================================================================================
+// Value
+//==================================================================================================
+
+class Value final
+{
+    friend class Array;
+    friend class Document;
+    friend class Object;
+
+    Document* doc_ = nullptr;
+    char const* pos_ = nullptr; // Position of the cursor at the value
+
+    Value(Document* doc, char const* pos) : doc_(doc), pos_(pos) {}
+
+public:
+    // Creates an invalid value.
+    Value() = default;
+
+    // Returns false for missing members, and after the last element of an array.
+    bool is_valid() const noexcept { return doc_ != nullptr; }
+    explicit operator bool() const noexcept { return is_valid(); }
+
+    // Returns the type of the value, without consuming the value.
+    // Returns Type::undefined if the value is invalid or has already been
+    // consumed, or on error.
+    Type type();
+
+    // Consumes the value if it is null.
+    bool is_null();
+
+    // Consume the value. Returns false if the value does not have the requested
+    // type (the value is skipped in this case) or on error.
+    // get(int64_t&) and get(uint64_t&) also fail if the number is not an
+    // integer or not representable.
+    bool get(bool& value);
+    bool get(double& value);
+    bool get(int64_t& value);
+    bool get(uint64_t& value);
+    bool get(std::string& value);
+
+    // Consume the value. Return DEFAULT_VALUE if the value does not have the
+    // requested type or on error.
+    bool        get_boolean(bool default_value = false);
+    double      get_number (double default_value = 0.0);
+    int64_t     get_int64  (int64_t default_value = 0);
+    uint64_t    get_uint64 (uint64_t default_value = 0);
+    std::string get_string (std::string default_value = {});
+
+    // Start iterating over the elements resp. members of the value.
+    // Returns an invalid Array resp. Object if the value is not an array resp.
+    // an object (the value is skipped in this case).
+    Array  get_array();
+    Object get_object();
+
+    // Equivalent to get_object()[key]. See Object::find.
+    Value operator[](char const* key);
+    Value operator[](std::string const& key);
+
+    // Skips the value.
+    bool skip();
+
+    // Skips the value and returns its JSON text in [FIRST, LAST).
+    bool raw_json(char const*& first, char const*& last);
+};
+
+//==================================================================================================
+// Array
+//==================================================================================================
+
+class Array final
+{
+    friend class Value;
+
+    Document* doc_ = nullptr;
+    size_t depth_ = 0;
+    char const* start_ = nullptr; // Position after the '['
+
+    Array(Document* doc, size_t depth, char const* start) : doc_(doc), depth_(depth), start_(start) {}
+
+public:
+    // Creates an invalid array.
+    Array() = default;
+
+    bool is_valid() const noexcept { return doc_ != nullptr; }
+    explicit operator bool() const noexcept { return is_valid(); }
+
+    // Returns the next element.
+    // Returns an invalid value after the last element.
+    Value next();
+};
+
+//==================================================================================================
+// Object
+//==================================================================================================
+
+class Object final
+{
+    friend class Document;
+    friend class Value;
+
+    Document* doc_ = nullptr;
+    size_t depth_ = 0;
+    char const* start_ = nullptr; // Position after the '{'
+
+    Object(Document* doc, size_t depth, char const* start) : doc_(doc), depth_(depth), start_(start) {}
+
+public:
+    // Creates an invalid object.
+    Object() = default;
+
+    bool is_valid() const noexcept { return doc_ != nullptr; }
+    explicit operator bool() const noexcept { return is_valid(); }
+
+    // Returns the next member. KEY is set to the (unescaped) key of the member.
+    // Returns an invalid value after the last member.
+    Value next(std::string& key);
+
+    // Returns the value of the member KEY, or an invalid value if there is no
+    // such member.
+    // The search starts at the current position and wraps around at the end
+    // of the object, so members may be looked up in any order. Looking up
+    // members in the order in which they appear in the input is fastest.
+    Value find(char const* key, size_t length);
+    Value operator[](char const* key);
+    Value operator[](std::string const& key);
+};
+
+//==================================================================================================
+// Document
+//==================================================================================================
+
+class Document final
+{
+    friend class Array;
+    friend class Object;
+    friend class Value;
+
+    enum class State : unsigned char {
+        value, // Before a value (which has not yet been consumed)
+        first, // Before the first member resp. element
+        next,  // After a value
+    };
+
+    struct Frame
+    {
+        char const* start; // Position after the '{' or '['
+        bool is_object;
+    };
+
+    struct Cursor;
+
+    char const* first_;
+    char const* last_;
+    char const* root_; // The root value, after the BOM
+    char const* pos_;  // Position of the cursor
+    Options options_;
+    State state_ = State::value;
+    std::vector<Frame> stack_; // The objects and arrays which have been entered
+    ParseStatus status_ = ParseStatus::success;
+    char const* error_ptr_ = nullptr;
+    // The key of the current member
+    char const* key_first_ = nullptr;
+    char const* key_last_ = nullptr;
+    bool key_needs_cleaning_ = false;
+    std::string key_buffer_;
+
+public:
+    // Creates a document for the JSON text [FIRST, LAST).
+    // NB: The input must outlive the document.
+    Document(char const* first, char const* last, Options const& options = {});
+
+    // Creates a document for the JSON text STR.
+    // NB: STR must outlive the document.
+    explicit Document(std::string const& str, Options const& options = {});
+    Document(std::string&& str, Options const& options = {}) = delete;
+
+    Document(Document const&) = delete;
+    Document& operator=(Document const&) = delete;
+
+    // Returns the error status.
+    ParseStatus status() const noexcept { return status_; }
+
+    // If status() != success, returns the position of the invalid token.
+    char const* error_ptr() const noexcept { return error_ptr_; }
+
+    // Returns the root value.
+    Value root();
+
+    // Looks up a member of the root object. See Object::find.
+    Value operator[](char const* key);
+    Value operator[](std::string const& key);
+
+    // Skips (and validates) the rest of the document, and checks that there
+    // are no trailing characters (unless Options::allow_trailing_characters).
+    ParseStatus finish();
+
+private:
+    Object RootObject();
+};
+
+} // namespace ondemand
+} // namespace json
@@ -47,12 +47,35 @@ struct Options
     // Default is false.
     bool parse_numbers_as_strings = false;
 
+    // If true, parse numbers as single-precision numbers (using
+    // numbers::StringToFloat). The numbers are stored as if converted using
+    // Traits<float>.
+    // Default is false.
+    bool parse_numbers_as_float = false;
+
+    // If true, strings which need to be unescaped are stored in their escaped
+    // form and unescaped on first access through Value::get_string. Strings
+    // which are never accessed are written back as-is by stringify.
+    // NB: The first call to get_string modifies the value, even through a
+    // const reference (and so does everything which reads the string, like
+    // comparisons or conversions). Values which still hold escaped strings must
+    // not be read concurrently from multiple threads without synchronization.
+    // Object keys are always unescaped.
+    // Default is false.
+    bool lazy_string_unescaping = false;
+
     // If true, allow characters after value.
     // Might be used to parse strings like "[1,2,3]{"hello":"world"}" into
     // different values by repeatedly calling parse.
     // Default is false.
     bool allow_trailing_characters = false;
 
+    // If true, stringify escapes all non-ASCII characters as "\uXXXX" (using
+    // surrogate pairs for characters outside the BMP), so that the output
+    // consists of ASCII characters only.
+    // Default is false.
+    bool ascii_only = false;
+
     // If >= 0, pretty-print the JSON.
     // Default is < 0, that is the JSON is rendered as the shortest string possible.
     int8_t indent_width = -1;
@@ -20,175 +20,20 @@
 
 #include "json_parse.h"
 
-#include "json_charclass.h"
+#include "json_lexer.h"
+#include "json_unicode.h"
 
 #include <cassert>
 #include <cstdint>
 #include <cstring>
+#include <string>
 
 #ifndef JSON_ASSERT
 #define JSON_ASSERT(X) assert(X)
 #endif
 
 using namespace json;
-
-//--------------------------------------------------------------------------------------------------
-//
-//--------------------------------------------------------------------------------------------------
-
-template <typename It>
-static It SkipWhitespace(It f, It l)
-{
-    using namespace json::charclass;
-
-#if 0
-    while (l - f >= 4)
-    {
-        if (!IsWhitespace(f[0])) return f + 0;
-        if (!IsWhitespace(f[1])) return f + 1;
-        if (!IsWhitespace(f[2])) return f + 2;
-        if (!IsWhitespace(f[3])) return f + 3;
-        f += 4;
-    }
-#endif
-
-    for ( ; f != l && IsWhitespace(*f); ++f)
-    {
-    }
-
-    return f;
-}
-
-//--------------------------------------------------------------------------------------------------
-//
-//--------------------------------------------------------------------------------------------------
-
-namespace {
-
-template <typename It>
-struct ScanNumberResult
-{
-    It next;
-    NumberClass number_class;
-};
-
-template <typename It>
-static ScanNumberResult<It> ScanNumber(It next, It last, Options const& options)
-{
-    using namespace json::charclass;
-
-    if (next == last)
-        return {next, NumberClass::invalid};
-
-    bool is_neg = false;
-    bool is_float = false;
-
-// [-]
-
-    if (*next == '-')
-    {
-        is_neg = true;
-
-        ++next;
-        if (next == last)
-            return {next, NumberClass::invalid};
-    }
-
-// int
-
-    if (*next == '0')
-    {
-        ++next;
-        if (next == last)
-            return {next, NumberClass::integer};
-        if (IsDigit(*next))
-            return {next, NumberClass::invalid};
-    }
-    else if (IsDigit(*next)) // non '0'
-    {
-        for (;;)
-        {
-            ++next;
-            if (next == last)
-                return {next, NumberClass::integer};
-            if (!IsDigit(*next))
-                break;
-        }
-    }
-    else
-    {
-        // NaN/Infinity
-
-        //
-        // XXX:
-        // Requires It = char [const]*
-        //
-        if (options.allow_nan_inf && last - next >= 3 && std::memcmp(next, "NaN", 3) == 0)
-        {
-            return {next + 3, NumberClass::nan};
-        }
-        if (options.allow_nan_inf && last - next >= 8 && std::memcmp(next, "Infinity", 8) == 0)
-        {
-            return {next + 8, is_neg ? NumberClass::neg_infinity : NumberClass::pos_infinity};
-        }
-
-        return {next, NumberClass::invalid};
-    }
-
-// frac
-
-    if (*next == '.')
-    {
-        is_float = true;
-
-        ++next;
-        if (next == last || !IsDigit(*next))
-            return {next, NumberClass::invalid};
-
-        for (;;)
-        {
-            ++next;
-            if (next == last)
-                return {next, NumberClass::floating_point};
-            if (!IsDigit(*next))
-                break;
-        }
-    }
-
-// exp
-
-    if (*next == 'e' || *next == 'E')
-    {
-        is_float = true;
-
-        ++next;
-        if (next == last)
-            return {next, NumberClass::invalid};
-
-        if (*next == '+' || *next == '-')
-        {
-            ++next;
-            if (next == last)
-                return {next, NumberClass::invalid};
-        }
-
-        if (!IsDigit(*next))
-            return {next, NumberClass::invalid};
-
-        for (;;)
-        {
-            ++next;
-            if (next == last)
-                return {next, NumberClass::floating_point};
-            if (!IsDigit(*next))
-                break;
-        }
-    }
-
-    return {next, is_float ? NumberClass::floating_point : NumberClass::integer};
-}
-
-} // namespace
+using namespace json::lexer;
 
 //--------------------------------------------------------------------------------------------------
 //
@@ -196,358 +41,62 @@ static ScanNumberResult<It> ScanNumber(It next, It last, Options const& options)
 
 namespace {
 
-enum class TokenKind : unsigned char {
-    unknown,
-    eof,
-    l_brace,
-    r_brace,
-    l_square,
-    r_square,
-    comma,
-    colon,
-    string,
-    incomplete_string,
-    number,
-    identifier,
-    comment,
-    incomplete_comment,
-};
-
-struct Token
-{
-    char const* ptr = nullptr;
-    char const* end = nullptr;
-    TokenKind   kind = TokenKind::unknown;
-    bool        needs_cleaning = false;
-    NumberClass number_class = NumberClass::invalid;
-};
-
-struct Lexer
+struct Failed
 {
-    char const* src = nullptr;
-    char const* end = nullptr;
-    char const* ptr = nullptr; // position in [src, end)
-
-    Lexer();
-    explicit Lexer(char const* first, char const* last);
-
-    Token MakeToken(char const* p, TokenKind kind, bool needs_cleaning = false, NumberClass number_class = NumberClass::invalid);
+    ParseStatus ec;
 
-    Token Lex(Options const& options);
+    Failed(ParseStatus ec_) : ec(ec_) {}
+    operator ParseStatus() const noexcept { return ec; }
 
-    Token LexString    (char const* p);
-    Token LexNumber    (char const* p, Options const& options);
-    Token LexIdentifier(char const* p);
-    Token LexComment   (char const* p);
+    // Test for failure.
+    explicit operator bool() const noexcept { return ec != ParseStatus::success; }
 };
 
-Lexer::Lexer()
-{
-}
-
-Lexer::Lexer(char const* first, char const* last)
-    : src(first)
-    , end(last)
-    , ptr(first)
-{
-}
-
-Token Lexer::MakeToken(char const* p, TokenKind kind, bool needs_cleaning, NumberClass number_class)
-{
-    Token tok;
-
-    tok.ptr = ptr;
-    tok.end = p;
-    tok.kind = kind;
-    tok.needs_cleaning = needs_cleaning;
-    tok.number_class = number_class;
-
-    ptr = p;
-
-    return tok;
-}
-
-Token Lexer::Lex(Options const& options)
-{
-L_again:
-    ptr = SkipWhitespace(ptr, end);
-
-    auto p = ptr;
-
-    if (p == end)
-        return MakeToken(p, TokenKind::eof);
-
-    auto kind = TokenKind::unknown;
-
-    char const ch = *p;
-    switch (ch)
-    {
-    case '{':
-        kind = TokenKind::l_brace;
-        break;
-    case '}':
-        kind = TokenKind::r_brace;
-        break;
-    case '[':
-        kind = TokenKind::l_square;
-        break;
-    case ']':
-        kind = TokenKind::r_square;
-        break;
-    case ',':
-        kind = TokenKind::comma;
-        break;
-    case ':':
-        kind = TokenKind::colon;
-        break;
-    case '"':
-        return LexString(p);
-    case '-':
-    case '0':
-    case '1':
-    case '2':
-    case '3':
-    case '4':
-    case '5':
-    case '6':
-    case '7':
-    case '8':
-    case '9':
-        return LexNumber(p, options);
-    case 'a':
-    case 'b':
-    case 'c':
-    case 'd':
-    case 'e':
-    case 'f':
-    case 'g':
-    case 'h':
-    case 'i':
-    case 'j':
-    case 'k':
-    case 'l':
-    case 'm':
-    case 'n':
-    case 'o':
-    case 'p':
-    case 'q':
-    case 'r':
-    case 's':
-    case 't':
-    case 'u':
-    case 'v':
-    case 'w':
-    case 'x':
-    case 'y':
-    case 'z':
-    case 'A':
-    case 'B':
-    case 'C':
-    case 'D':
-    case 'E':
-    case 'F':
-    case 'G':
-    case 'H':
-    case 'I':
-    case 'J':
-    case 'K':
-    case 'L':
-    case 'M':
-    case 'N':
-    case 'O':
-    case 'P':
-    case 'Q':
-    case 'R':
-    case 'S':
-    case 'T':
-    case 'U':
-    case 'V':
-    case 'W':
-    case 'X':
-    case 'Y':
-    case 'Z':
-    case '_':
-        return LexIdentifier(p);
-    case '/':
-        if (options.strip_comments)
-        {
-            auto tok = LexComment(p);
-            if (tok.kind == TokenKind::comment)
-                goto L_again;
-        }
-        break;
-    default:
-        break;
-    }
-
-    ++p;
-    return MakeToken(p, kind);
-}
-
-Token Lexer::LexString(char const* p)
-{
-    using namespace json::charclass;
-
-    JSON_ASSERT(p != end);
-    JSON_ASSERT(*p == '"');
-
-    ptr = ++p; // skip " or '
-
-    unsigned mask = 0;
-    for (;;)
-    {
-        while (end - p >= 4)
-        {
-            unsigned const m0 = CharClass(p[0]);
-            unsigned const m1 = CharClass(p[1]);
-            unsigned const m2 = CharClass(p[2]);
-            unsigned const m3 = CharClass(p[3]);
-
-            unsigned const mm = m0 | m1 | m2 | m3;
-            if ((mm & CC_StringSpecial) == 0)
-            {
-                mask |= mm;
-                p += 4;
-                continue;
-            }
-
-            mask |= m0;        if ((m0 & CC_StringSpecial) != 0)   { goto L_check; }
-            mask |= m1; ++p;   if ((m1 & CC_StringSpecial) != 0)   { goto L_check; }
-            mask |= m2; ++p;   if ((m2 & CC_StringSpecial) != 0)   { goto L_check; }
-            mask |= m3; ++p; /*if ((m3 & CC_StringSpecial) != 0)*/ { goto L_check; }
-        }
-
-        for (;;)
-        {
-            if (p == end)
-                goto L_incomplete;
-
-            unsigned const m0 = CharClass(*p);
-            mask |= m0;
-            if ((m0 & CC_StringSpecial) != 0)
-                goto L_check;
-
-            ++p;
-        }
-
-L_check:
-        auto const ch = *p;
-
-        if (ch == '"')
-        {
-            auto tok = MakeToken(p, TokenKind::string, (mask & CC_NeedsCleaning) != 0);
-            ptr = ++p; // skip " or '
-            return tok;
-        }
-
-        JSON_ASSERT(ch == '\\');
-        ++p;
-        if (p == end)
-            break;
-        ++p; // Skip the escaped character.
-    }
-
-L_incomplete:
-    return MakeToken(p, TokenKind::incomplete_string, (mask & CC_NeedsCleaning) != 0);
-}
-
-Token Lexer::LexNumber(char const* p, Options const& options)
+// Returns the token [f, l) as a UTF-8 encoded string [first, last).
+// Returns false if the token is not a valid UTF-16 encoded string.
+static bool ToUTF8(std::string& /*buffer*/, char const* f, char const* l, char const*& first, char const*& last)
 {
-    auto const res = ScanNumber(p, end, options);
-
-    return MakeToken(res.next, TokenKind::number, /*needs_cleaning*/ false, res.number_class);
+    first = f;
+    last = l;
+    return true;
 }
 
-Token Lexer::LexIdentifier(char const* p)
+static bool ToUTF8(std::string& buffer, char16_t const* f, char16_t const* l, char const*& first, char const*& last)
 {
-    using namespace json::charclass;
-
-    for ( ; p != end && IsIdentifierBody(*p); ++p)
-    {
-    }
-
-    return MakeToken(p, TokenKind::identifier);
-}
-
-Token Lexer::LexComment(char const* p)
-{
-    JSON_ASSERT(p != end);
-    JSON_ASSERT(*p == '/');
-
-    ++p;
-    if (p == end)
-        return MakeToken(p, TokenKind::unknown);
+    buffer.clear();
 
-    if (*p == '/')
+    while (f != l)
     {
-        for (;;)
+        if (*f < 0x80)
         {
-            ++p;
-            if (p == end)
-                break;
-            if (*p == '\n' || *p == '\r')
-                break;
+            buffer += static_cast<char>(*f);
+            ++f;
+            continue;
         }
 
-        return MakeToken(p, TokenKind::comment);
-    }
-
-    if (*p == '*')
-    {
-        TokenKind kind = TokenKind::incomplete_comment;
-
-        for (;;)
-        {
-            ++p;
-            if (p == end)
-                break;
-            if (*p == '*')
-            {
-                ++p;
-                if (p == end)
-                    break;
-                if (*p == '/')
-                {
-                    kind = TokenKind::comment;
-                    ++p;
-                    break;
-                }
-            }
-        }
+        uint32_t U = 0;
+        f = json::unicode::DecodeUTF16Sequence(f, l, U);
+        if (U == json::unicode::kInvalidCodepoint)
+            return false;
 
-        return MakeToken(p, kind);
+        json::unicode::EncodeUTF8(U, [&](uint8_t code_unit) { buffer += static_cast<char>(code_unit); });
     }
 
-    return MakeToken(p, TokenKind::unknown);
+    first = buffer.data();
+    last  = buffer.data() + buffer.size();
+    return true;
 }
 
-} // namespace
-
-//--------------------------------------------------------------------------------------------------
-//
-//--------------------------------------------------------------------------------------------------
-
-namespace {
-
-struct Failed
-{
-    ParseStatus ec;
-
-    Failed(ParseStatus ec_) : ec(ec_) {}
-    operator ParseStatus() const noexcept { return ec; }
-
-    // Test for failure.
-    explicit operator bool() const noexcept { return ec != ParseStatus::success; }
-};
-
+template <typename CharT>
 struct Parser
 {
     static constexpr int kMaxDepth = 500;
 
     ParseCallbacks& cb;
     Options         options;
-    Lexer           lexer;
-    Token           token; // The next token.
+    Lexer<CharT>    lexer;
+    Token<CharT>    token; // The next token.
+    std::string     buffer; // UTF-8 encoded tokens for CharT != char
 
     Parser(ParseCallbacks& cb_, Options const& options_);
 
@@ -558,17 +107,24 @@ struct Parser
     ParseStatus ParseValue();
 };
 
-Parser::Parser(ParseCallbacks& cb_, Options const& options_)
+template <typename CharT>
+Parser<CharT>::Parser(ParseCallbacks& cb_, Options const& options_)
     : cb(cb_)
     , options(options_)
 {
 }
 
-ParseStatus Parser::ParseString()
+template <typename CharT>
+ParseStatus Parser<CharT>::ParseString()
 {
     JSON_ASSERT(token.kind == TokenKind::string);
 
-    if (Failed ec = cb.HandleString(token.ptr, token.end, token.needs_cleaning, options))
+    char const* f;
+    char const* l;
+    if (!ToUTF8(buffer, token.ptr, token.end, f, l))
+        return ParseStatus::invalid_string;
+
+    if (Failed ec = cb.HandleString(f, l, token.needs_cleaning, options))
         return ec;
 
     // skip string
@@ -577,14 +133,19 @@ ParseStatus Parser::ParseString()
     return ParseStatus::success;
 }
 
-ParseStatus Parser::ParseNumber()
+template <typename CharT>
+ParseStatus Parser<CharT>::ParseNumber()
 {
     JSON_ASSERT(token.kind == TokenKind::number);
 
     if (token.number_class == NumberClass::invalid)
         return ParseStatus::invalid_number;
 
-    if (Failed ec = cb.HandleNumber(token.ptr, token.end, token.number_class, options))
+    char const* f;
+    char const* l;
+    ToUTF8(buffer, token.ptr, token.end, f, l); // Numbers are ASCII only.
+
+    if (Failed ec = cb.HandleNumber(f, l, token.number_class, options))
         return ec;
 
     // skip number
@@ -593,7 +154,8 @@ ParseStatus Parser::ParseNumber()
     return ParseStatus::success;
 }
 
-ParseStatus Parser::ParseIdentifier()
+template <typename CharT>
+ParseStatus Parser<CharT>::ParseIdentifier()
 {
     JSON_ASSERT(token.kind == TokenKind::identifier);
     JSON_ASSERT(token.end - token.ptr > 0 && "internal error");
@@ -603,25 +165,25 @@ ParseStatus Parser::ParseIdentifier()
     auto const len = l - f;
 
     ParseStatus ec;
-    if (len == 4 && /**f == 'n' &&*/ std::memcmp(f, "null", 4) == 0)
+    if (len == 4 && /**f == 'n' &&*/ EqualASCII(f, "null", 4))
     {
         ec = cb.HandleNull(options);
     }
-    else if (len == 4 && /**f == 't' &&*/ std::memcmp(f, "true", 4) == 0)
+    else if (len == 4 && /**f == 't' &&*/ EqualASCII(f, "true", 4))
     {
         ec = cb.HandleBoolean(true, options);
     }
-    else if (len == 5 && /**f == 'f' &&*/ std::memcmp(f, "false", 5) == 0)
+    else if (len == 5 && /**f == 'f' &&*/ EqualASCII(f, "false", 5))
     {
         ec = cb.HandleBoolean(false, options);
     }
-    else if (options.allow_nan_inf && len == 3 && std::memcmp(f, "NaN", 3) == 0)
+    else if (options.allow_nan_inf && len == 3 && EqualASCII(f, "NaN", 3))
     {
-        ec = cb.HandleNumber(f, l, NumberClass::nan, options);
+        ec = cb.HandleNumber("NaN", "NaN" + 3, NumberClass::nan, options);
     }
-    else if (options.allow_nan_inf && len == 8 && std::memcmp(f, "Infinity", 8) == 0)
+    else if (options.allow_nan_inf && len == 8 && EqualASCII(f, "Infinity", 8))
     {
-        ec = cb.HandleNumber(f, l, NumberClass::pos_infinity, options);
+        ec = cb.HandleNumber("Infinity", "Infinity" + 8, NumberClass::pos_infinity, options);
     }
     else
     {
@@ -637,7 +199,8 @@ ParseStatus Parser::ParseIdentifier()
     return ParseStatus::success;
 }
 
-ParseStatus Parser::ParsePrimitive()
+template <typename CharT>
+ParseStatus Parser<CharT>::ParsePrimitive()
 {
     switch (token.kind)
     {
@@ -654,7 +217,8 @@ ParseStatus Parser::ParsePrimitive()
     }
 }
 
-ParseStatus Parser::ParseValue()
+template <typename CharT>
+ParseStatus Parser<CharT>::ParseValue()
 {
     enum class Structure {
         object,
@@ -712,7 +276,12 @@ L_begin_object:
             if (token.kind != TokenKind::string)
                 return ParseStatus::expected_key;
 
-            if (Failed ec = cb.HandleKey(token.ptr, token.end, token.needs_cleaning, options))
+            char const* f;
+            char const* l;
+            if (!ToUTF8(buffer, token.ptr, token.end, f, l))
+                return ParseStatus::invalid_string; // return ParseStatus::invalid_key;
+
+            if (Failed ec = cb.HandleKey(f, l, token.needs_cleaning, options))
                 return ec;
 
             // skip 'key'
@@ -845,12 +414,182 @@ L_end_structured:
 //
 //--------------------------------------------------------------------------------------------------
 
-ParseResult json::parse(ParseCallbacks& cb, char const* next, char const* last, Options const& options)
+namespace {
+
+struct Scanner : Skipper
 {
-    JSON_ASSERT(next != nullptr);
-    JSON_ASSERT(last != nullptr);
+    ScanCallbacks& cb;
+
+    Scanner(ScanCallbacks& cb_, Options const& options_);
+
+    ParseStatus ScanValue();
+};
+
+Scanner::Scanner(ScanCallbacks& cb_, Options const& options_)
+    : Skipper(options_)
+    , cb(cb_)
+{
+}
+
+ParseStatus Scanner::ScanValue()
+{
+    struct StackElement
+    {
+        bool is_object;
+        size_t index; // index of the current member resp. element
+        char const* select_first; // If not null, the start of the value, which has to be passed to HandleSelect
+    };
+
+    StackElement stack[kMaxDepth];
+    size_t stack_size = 0;
+
+    unsigned flags = cb.HandleValue(nullptr, nullptr, false, 0, options);
+
+L_value:
+    {
+        // Strings start at the opening quote.
+        char const* const first = (token.kind == TokenKind::string) ? token.ptr - 1 : token.ptr;
+
+        bool const is_structured = (token.kind == TokenKind::l_brace || token.kind == TokenKind::l_square);
+        if (!is_structured || (flags & scan_descend) == 0)
+        {
+            size_t count;
+            if (Failed ec = SkipValue(stack_size, count))
+                return ec;
+
+            if ((flags & scan_select) != 0)
+            {
+                if (Failed ec = cb.HandleSelect(first, value_end, options))
+                    return ec;
+            }
+
+            goto L_end_value;
+        }
+
+        if (stack_size >= kMaxDepth)
+            return ParseStatus::max_depth_reached;
+
+        size_t count = SIZE_MAX;
+        if (token.kind == TokenKind::l_square && (flags & scan_count) != 0)
+        {
+            auto const saved_lexer = lexer;
+            auto const saved_token = token;
+
+            if (Failed ec = SkipValue(stack_size, count))
+                return ec;
+
+            lexer = saved_lexer;
+            token = saved_token;
+        }
+
+        if (Failed ec = cb.HandleEnter(count, options))
+            return ec;
+
+        stack[stack_size++] = {token.kind == TokenKind::l_brace, 0, (flags & scan_select) != 0 ? first : nullptr};
+
+        // skip '{' or '['
+        token = lexer.Lex(options);
+    }
+
+    if (stack[stack_size - 1].is_object)
+    {
+        if (token.kind == TokenKind::r_brace)
+            goto L_end_structured;
+
+L_next_member:
+        if (token.kind != TokenKind::string)
+            return ParseStatus::expected_key;
+        if (Failed ec = SkipString())
+            return ec;
+
+        flags = cb.HandleValue(token.ptr, token.end, token.needs_cleaning, stack[stack_size - 1].index, options);
+
+        // skip 'key'
+        token = lexer.Lex(options);
+
+        if (token.kind != TokenKind::colon)
+            return ParseStatus::expected_colon_after_key;
+
+        // skip ':'
+        token = lexer.Lex(options);
+        goto L_value;
+
+L_end_member:
+        stack[stack_size - 1].index++;
+
+        if (token.kind == TokenKind::comma)
+        {
+            // skip ','
+            token = lexer.Lex(options);
+
+            if (!options.allow_trailing_comma || token.kind != TokenKind::r_brace)
+                goto L_next_member;
+        }
+
+        if (token.kind != TokenKind::r_brace)
+            return ParseStatus::expected_comma_or_closing_brace;
+    }
+    else
+    {
+        if (token.kind == TokenKind::r_square)
+            goto L_end_structured;
+
+L_next_element:
+        flags = cb.HandleValue(nullptr, nullptr, false, stack[stack_size - 1].index, options);
+        goto L_value;
+
+L_end_element:
+        stack[stack_size - 1].index++;
+
+        if (token.kind == TokenKind::comma)
+        {
+            // skip ','
+            token = lexer.Lex(options);
+
+            if (!options.allow_trailing_comma || token.kind != TokenKind::r_square)
+                goto L_next_element;
+        }
+
+        if (token.kind != TokenKind::r_square)
+            return ParseStatus::expected_comma_or_closing_bracket;
+    }
+
+L_end_structured:
+    // skip '}' or ']'
+    value_end = lexer.ptr;
+    token = lexer.Lex(options);
+
+    JSON_ASSERT(stack_size != 0);
+    stack_size--;
+
+    if (Failed ec = cb.HandleLeave(options))
+        return ec;
+
+    if (stack[stack_size].select_first != nullptr)
+    {
+        if (Failed ec = cb.HandleSelect(stack[stack_size].select_first, value_end, options))
+            return ec;
+    }
 
-    if (options.skip_bom && last - next >= 3)
+L_end_value:
+    if (stack_size == 0)
+        return ParseStatus::success;
+
+    if (stack[stack_size - 1].is_object)
+        goto L_end_member;
+    else
+        goto L_end_element;
+}
+
+} // namespace
+
+//--------------------------------------------------------------------------------------------------
+//
+//--------------------------------------------------------------------------------------------------
+
+static char const* SkipBOM(char const* next, char const* last)
+{
+    if (last - next >= 3)
     {
         if (static_cast<unsigned char>(next[0]) == 0xEF &&
             static_cast<unsigned char>(next[1]) == 0xBB &&
@@ -860,9 +599,33 @@ ParseResult json::parse(ParseCallbacks& cb, char const* next, char const* last,
         }
     }
 
-    Parser parser(cb, options);
+    return next;
+}
+
+static char16_t const* SkipBOM(char16_t const* next, char16_t const* last)
+{
+    if (next != last && *next == 0xFEFF)
+    {
+        ++next;
+    }
 
-    parser.lexer = Lexer(next, last);
+    return next;
+}
+
+template <typename CharT>
+static BasicParseResult<CharT> ParseImpl(ParseCallbacks& cb, CharT const* next, CharT const* last, Options const& options)
+{
+    JSON_ASSERT(next != nullptr);
+    JSON_ASSERT(last != nullptr);
+
+    if (options.skip_bom)
+    {
+        next = SkipBOM(next, last);
+    }
+
+    Parser<CharT> parser(cb, options);
+
+    parser.lexer = Lexer<CharT>(next, last);
     parser.token = parser.lexer.Lex(options); // Get the first token
 
     auto /*const*/ ec = parser.ParseValue();
@@ -890,3 +653,41 @@ ParseResult json::parse(ParseCallbacks& cb, char const* next, char const* last,
 
     return {ec, parser.token.ptr, parser.token.end};
 }
+
+ParseResult json::parse(ParseCallbacks& cb, char const* next, char const* last, Options const& options)
+{
+    return ParseImpl(cb, next, last, options);
+}
+
+ParseResult16 json::parse(ParseCallbacks& cb, char16_t const* next, char16_t const* last, Options const& options)
+{
+    return ParseImpl(cb, next, last, options);
+}
+
+ParseResult json::scan(ScanCallbacks& cb, char const* next, char const* last, Options const& options)
+{
+    JSON_ASSERT(next != nullptr);
+    JSON_ASSERT(last != nullptr);
+
+    if (options.skip_bom)
+    {
+        next = SkipBOM(next, last);
+    }
+
+    Scanner scanner(cb, options);
+
+    scanner.lexer = Lexer<char>(next, last);
+    scanner.token = scanner.lexer.Lex(options); // Get the first token
+
+    auto /*const*/ ec = scanner.ScanValue();
+
+    if (ec == ParseStatus::success)
+    {
+        if (!options.allow_trailing_characters && scanner.token.kind != TokenKind::eof)
+        {
+            ec = ParseStatus::expected_eof;
+        }
+    }
+
+    return {ec, scanner.token.ptr, scanner.token.end};
+}
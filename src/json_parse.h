@@ -41,6 +41,7 @@ enum class ParseStatus {
     max_depth_reached,
     unexpected_eof,
     unexpected_token,
+    unexpected_type,
     unrecognized_identifier,
 };
 
@@ -70,18 +71,65 @@ struct ParseCallbacks
     virtual ParseStatus HandleKey(char const* first, char const* last, bool needs_cleaning, Options const& options) = 0;
 };
 
-struct ParseResult
+template <typename CharT>
+struct BasicParseResult
 {
     ParseStatus ec;
     // On return, PTR denotes the position after the parsed value, or if an
     // error occurred, denotes the position of the invalid token.
-    char const* ptr;
+    CharT const* ptr;
     // If an error occurred, END denotes the position after the invalid token.
     // This field is unused on success.
-    char const* end;
+    CharT const* end;
 };
 
+using ParseResult   = BasicParseResult<char>;
+using ParseResult16 = BasicParseResult<char16_t>;
+
 // Parse the JSON stored in the string [first, last).
 ParseResult parse(ParseCallbacks& cb, char const* first, char const* last, Options const& options = {});
 
+// Parse the UTF-16 encoded JSON stored in the string [first, last).
+// Strings and numbers are converted to UTF-8 before they are passed to the
+// callbacks. Unpaired surrogates are reported as ParseStatus::invalid_string.
+ParseResult16 parse(ParseCallbacks& cb, char16_t const* first, char16_t const* last, Options const& options = {});
+
+// Flags returned from ScanCallbacks::HandleValue.
+enum ScanFlags : unsigned {
+    scan_skip    = 0,      // Skip the value (it is still validated).
+    scan_select  = 1 << 0, // Pass the JSON text of the value to HandleSelect.
+    scan_descend = 1 << 1, // Call HandleValue for the members resp. elements of the value.
+    scan_count   = 1 << 2, // Pass the number of elements of an array to HandleEnter.
+};
+
+// Callbacks for json::scan.
+//
+// The scanner drives the lexer directly: Values for which HandleValue does not
+// return scan_descend are skipped without calling any other callbacks.
+struct ScanCallbacks
+{
+    virtual ~ScanCallbacks() {}
+
+    // Called for the root value and for each member resp. element of a value
+    // which has been descended into. For members, [KEY_FIRST, KEY_LAST) is the
+    // (still escaped) key. For elements and the root value, both are null.
+    // INDEX is the index of the member resp. element.
+    // Returns a combination of ScanFlags.
+    virtual unsigned HandleValue(char const* key_first, char const* key_last, bool needs_cleaning, size_t index, Options const& options) = 0;
+    // Called before the members resp. elements of an object or array with
+    // scan_descend are visited. COUNT is the number of elements if the array
+    // has scan_count, and SIZE_MAX otherwise.
+    virtual ParseStatus HandleEnter(size_t count, Options const& options) = 0;
+    // Called after the last member resp. element has been visited.
+    virtual ParseStatus HandleLeave(Options const& options) = 0;
+    // Called for values with scan_select, after the value has been scanned
+    // (and left, if it has been descended into).
+    // [FIRST, LAST) is the JSON text of the value.
+    virtual ParseStatus HandleSelect(char const* first, char const* last, Options const& options) = 0;
+};
+
+// Scan the JSON stored in the string [first, last), visiting only the parts
+// selected by CB.
+ParseResult scan(ScanCallbacks& cb, char const* first, char const* last, Options const& options = {});
+
 } // namespace json
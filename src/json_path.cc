@@ -0,0 +1,1102 @@
+// Copyright 2018 Alexander Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "json_path.h"
+#include "json_numbers.h"
+#include "json_strings.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace json;
+
+//==================================================================================================
+// Path
+//==================================================================================================
+
+namespace {
+
+// A member name or an array index.
+struct Selector
+{
+    Key name;
+    int64_t index;
+    bool is_index;
+};
+
+enum class CompareOp {
+    exists,
+    eq,
+    ne,
+    lt,
+    le,
+    gt,
+    ge,
+};
+
+// @.path OP literal
+struct Condition
+{
+    std::vector<Selector> path;
+    CompareOp op = CompareOp::exists;
+    Value literal;
+};
+
+enum class StepKind {
+    list,        // [name, index, ...]
+    wildcard,    // [*]
+    slice,       // [start:end:step]
+    filter,      // [?(...)]
+    descendants, // ..
+};
+
+struct Step
+{
+    StepKind kind;
+    // list:
+    std::vector<Selector> selectors;
+    // slice:
+    bool has_start = false;
+    bool has_end = false;
+    int64_t start = 0;
+    int64_t end = 0;
+    int64_t step = 1;
+    // filter: a disjunction of conjunctions
+    std::vector<std::vector<Condition>> filter;
+
+    explicit Step(StepKind kind_) : kind(kind_) {}
+};
+
+class PathParser
+{
+    char const* p;
+    char const* end;
+
+public:
+    PathParser(char const* first, char const* last) : p(first), end(last) {}
+
+    bool Parse(std::vector<Step>& steps);
+
+private:
+    bool At(char ch) const { return p != end && *p == ch; }
+    bool AtString(char const* s) const;
+    bool Consume(char ch);
+    bool ConsumeString(char const* s);
+    void SkipWhitespace();
+    bool ParseName(String& name);
+    bool ParseQuoted(String& str);
+    bool ParseInteger(int64_t& value);
+    bool ParseBracket(std::vector<Step>& steps);
+    bool ParseSlice(Step& step);
+    bool ParseFilter(Step& step);
+    bool ParseCondition(Condition& cond);
+    bool ParseLiteral(Value& value);
+};
+
+bool PathParser::AtString(char const* s) const
+{
+    size_t const len = std::strlen(s);
+    return static_cast<size_t>(end - p) >= len && std::memcmp(p, s, len) == 0;
+}
+
+bool PathParser::Consume(char ch)
+{
+    if (!At(ch))
+        return false;
+
+    ++p;
+    return true;
+}
+
+bool PathParser::ConsumeString(char const* s)
+{
+    if (!AtString(s))
+        return false;
+
+    p += std::strlen(s);
+    return true;
+}
+
+void PathParser::SkipWhitespace()
+{
+    while (p != end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+        ++p;
+}
+
+static bool IsNameChar(char ch)
+{
+    return (ch >= 'a' && ch <= 'z')
+        || (ch >= 'A' && ch <= 'Z')
+        || (ch >= '0' && ch <= '9')
+        || ch == '_' || ch == '$' || ch == '-'
+        || static_cast<unsigned char>(ch) >= 0x80;
+}
+
+bool PathParser::ParseName(String& name)
+{
+    auto const first = p;
+    while (p != end && IsNameChar(*p))
+        ++p;
+
+    name.assign(first, p);
+    return first != p;
+}
+
+// Single- or double-quoted string, using the JSON escape sequences (plus \').
+bool PathParser::ParseQuoted(String& str)
+{
+    JSON_ASSERT(At('\'') || At('"'));
+
+    char const quote = *p++;
+
+    String escaped;
+    for (;;)
+    {
+        if (p == end)
+            return false;
+        if (*p == quote)
+            break;
+
+        if (*p == '\\')
+        {
+            if (end - p < 2)
+                return false;
+            if (p[1] == '\'')
+            {
+                escaped += '\'';
+            }
+            else
+            {
+                escaped += p[0];
+                escaped += p[1];
+            }
+            p += 2;
+        }
+        else
+        {
+            escaped += *p++;
+        }
+    }
+    ++p; // skip quote
+
+    auto const res = strings::UnescapeStringBulk(str, escaped.data(), escaped.data() + escaped.size());
+    return res.status == strings::UnescapeStringStatus::success;
+}
+
+bool PathParser::ParseInteger(int64_t& value)
+{
+    bool const is_neg = Consume('-');
+    if (p == end || *p < '0' || *p > '9')
+        return false;
+
+    int64_t v = 0;
+    for ( ; p != end && *p >= '0' && *p <= '9'; ++p)
+    {
+        if (v > (INT64_MAX - 9) / 10)
+            return false;
+        v = v * 10 + (*p - '0');
+    }
+
+    value = is_neg ? -v : v;
+    return true;
+}
+
+bool PathParser::Parse(std::vector<Step>& steps)
+{
+    if (!Consume('$'))
+        return false;
+
+    while (p != end)
+    {
+        if (ConsumeString(".."))
+        {
+            steps.emplace_back(StepKind::descendants);
+            if (At('['))
+            {
+                if (!ParseBracket(steps))
+                    return false;
+                continue;
+            }
+        }
+        else if (Consume('.'))
+        {
+        }
+        else if (At('['))
+        {
+            if (!ParseBracket(steps))
+                return false;
+            continue;
+        }
+        else
+        {
+            return false;
+        }
+
+        // .name or .*
+        if (Consume('*'))
+        {
+            steps.emplace_back(StepKind::wildcard);
+        }
+        else
+        {
+            String name;
+            if (!ParseName(name))
+                return false;
+
+            steps.emplace_back(StepKind::list);
+            steps.back().selectors.push_back({Key(std::move(name)), 0, false});
+        }
+    }
+
+    return true;
+}
+
+bool PathParser::ParseBracket(std::vector<Step>& steps)
+{
+    JSON_ASSERT(At('['));
+    ++p;
+
+    SkipWhitespace();
+
+    if (Consume('*'))
+    {
+        steps.emplace_back(StepKind::wildcard);
+    }
+    else if (Consume('?'))
+    {
+        steps.emplace_back(StepKind::filter);
+        if (!ParseFilter(steps.back()))
+            return false;
+    }
+    else
+    {
+        steps.emplace_back(StepKind::list);
+
+        auto& step = steps.back();
+        for (;;)
+        {
+            SkipWhitespace();
+
+            if (At('\'') || At('"'))
+            {
+                String name;
+                if (!ParseQuoted(name))
+                    return false;
+                step.selectors.push_back({Key(std::move(name)), 0, false});
+            }
+            else
+            {
+                int64_t index = 0;
+                bool const has_index = !At(':');
+                if (has_index && !ParseInteger(index))
+                    return false;
+
+                SkipWhitespace();
+                if (At(':'))
+                {
+                    // Slices cannot be part of a union.
+                    if (!step.selectors.empty())
+                        return false;
+
+                    step.kind = StepKind::slice;
+                    step.has_start = has_index;
+                    step.start = index;
+                    if (!ParseSlice(step))
+                        return false;
+                    break;
+                }
+
+                step.selectors.push_back({Key(String()), index, true});
+            }
+
+            SkipWhitespace();
+            if (!Consume(','))
+                break;
+        }
+    }
+
+    SkipWhitespace();
+    return Consume(']');
+}
+
+// :end:step
+bool PathParser::ParseSlice(Step& step)
+{
+    JSON_ASSERT(At(':'));
+    ++p;
+
+    SkipWhitespace();
+    if (!At(':') && !At(']'))
+    {
+        step.has_end = true;
+        if (!ParseInteger(step.end))
+            return false;
+        SkipWhitespace();
+    }
+
+    if (Consume(':'))
+    {
+        SkipWhitespace();
+        if (!At(']'))
+        {
+            if (!ParseInteger(step.step))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+bool PathParser::ParseFilter(Step& step)
+{
+    SkipWhitespace();
+    bool const has_parens = Consume('(');
+
+    step.filter.emplace_back();
+    for (;;)
+    {
+        SkipWhitespace();
+
+        step.filter.back().emplace_back();
+        if (!ParseCondition(step.filter.back().back()))
+            return false;
+
+        SkipWhitespace();
+        if (ConsumeString("&&"))
+            continue;
+        if (ConsumeString("||"))
+        {
+            step.filter.emplace_back();
+            continue;
+        }
+        break;
+    }
+
+    if (has_parens && !Consume(')'))
+        return false;
+
+    return true;
+}
+
+bool PathParser::ParseCondition(Condition& cond)
+{
+    if (!Consume('@'))
+        return false;
+
+    for (;;)
+    {
+        if (Consume('.'))
+        {
+            String name;
+            if (!ParseName(name))
+                return false;
+            cond.path.push_back({Key(std::move(name)), 0, false});
+        }
+        else if (Consume('['))
+        {
+            SkipWhitespace();
+            if (At('\'') || At('"'))
+            {
+                String name;
+                if (!ParseQuoted(name))
+                    return false;
+                cond.path.push_back({Key(std::move(name)), 0, false});
+            }
+            else
+            {
+                int64_t index = 0;
+                if (!ParseInteger(index))
+                    return false;
+                cond.path.push_back({Key(String()), index, true});
+            }
+            SkipWhitespace();
+            if (!Consume(']'))
+                return false;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    SkipWhitespace();
+
+    if (ConsumeString("=="))
+        cond.op = CompareOp::eq;
+    else if (ConsumeString("!="))
+        cond.op = CompareOp::ne;
+    else if (ConsumeString("<="))
+        cond.op = CompareOp::le;
+    else if (ConsumeString(">="))
+        cond.op = CompareOp::ge;
+    else if (Consume('<'))
+        cond.op = CompareOp::lt;
+    else if (Consume('>'))
+        cond.op = CompareOp::gt;
+    else
+        return true; // exists
+
+    SkipWhitespace();
+    return ParseLiteral(cond.literal);
+}
+
+bool PathParser::ParseLiteral(Value& value)
+{
+    if (At('\'') || At('"'))
+    {
+        String str;
+        if (!ParseQuoted(str))
+            return false;
+        value = std::move(str);
+        return true;
+    }
+
+    if (ConsumeString("true"))
+    {
+        value = true;
+        return true;
+    }
+    if (ConsumeString("false"))
+    {
+        value = false;
+        return true;
+    }
+    if (ConsumeString("null"))
+    {
+        value = nullptr;
+        return true;
+    }
+
+    auto const first = p;
+    while (p != end && ((*p >= '0' && *p <= '9') || *p == '-' || *p == '+' || *p == '.' || *p == 'e' || *p == 'E'))
+        ++p;
+
+    double number = 0;
+    if (first == p || !numbers::StringToNumber(number, first, p))
+        return false;
+
+    value = number;
+    return true;
+}
+
+} // namespace
+
+struct Path::Impl
+{
+    std::vector<Step> steps;
+};
+
+Path::Path()
+{
+}
+
+Path::Path(std::string const& expr)
+{
+    std::unique_ptr<Impl> impl(new Impl);
+
+    PathParser parser(expr.data(), expr.data() + expr.size());
+    if (parser.Parse(impl->steps))
+        impl_ = std::move(impl);
+}
+
+//==================================================================================================
+// PathMatches
+//==================================================================================================
+
+static Value const* Select(Value const& value, Selector const& sel)
+{
+    if (sel.is_index)
+    {
+        if (!value.is_array())
+            return nullptr;
+
+        auto const& arr = value.get_array();
+        int64_t const size = static_cast<int64_t>(arr.size());
+        int64_t const index = (sel.index < 0) ? size + sel.index : sel.index;
+        if (index < 0 || index >= size)
+            return nullptr;
+
+        return &arr[static_cast<size_t>(index)];
+    }
+
+    if (!value.is_object())
+        return nullptr;
+
+    return value.get_ptr(sel.name);
+}
+
+static bool Compare(Value const& lhs, Value const& rhs, CompareOp op)
+{
+    if (lhs.is_number() && rhs.is_number())
+    {
+        double const x = lhs.get_number();
+        double const y = rhs.get_number();
+        switch (op)
+        {
+        case CompareOp::lt: return x < y;
+        case CompareOp::le: return x <= y;
+        case CompareOp::gt: return x > y;
+        case CompareOp::ge: return x >= y;
+        default:
+            break;
+        }
+    }
+    else if (lhs.is_string() && rhs.is_string())
+    {
+        int const c = lhs.get_string().compare(rhs.get_string());
+        switch (op)
+        {
+        case CompareOp::lt: return c < 0;
+        case CompareOp::le: return c <= 0;
+        case CompareOp::gt: return c > 0;
+        case CompareOp::ge: return c >= 0;
+        default:
+            break;
+        }
+    }
+
+    return false;
+}
+
+static bool Evaluate(Value const& value, Condition const& cond)
+{
+    // The paths in filters contain only names and indices, so they can be
+    // resolved without recursion.
+    Value const* v = &value;
+    for (auto const& sel : cond.path)
+    {
+        v = Select(*v, sel);
+        if (v == nullptr)
+            break;
+    }
+
+    switch (cond.op)
+    {
+    case CompareOp::exists:
+        return v != nullptr;
+    case CompareOp::eq:
+        return v != nullptr && *v == cond.literal;
+    case CompareOp::ne:
+        return v == nullptr || *v != cond.literal;
+    default:
+        return v != nullptr && Compare(*v, cond.literal, cond.op);
+    }
+}
+
+static bool Evaluate(Value const& value, std::vector<std::vector<Condition>> const& filter)
+{
+    for (auto const& conjunction : filter)
+    {
+        bool result = true;
+        for (auto const& cond : conjunction)
+        {
+            if (!Evaluate(value, cond))
+            {
+                result = false;
+                break;
+            }
+        }
+
+        if (result)
+            return true;
+    }
+
+    return false;
+}
+
+// Computes the range of array indices selected by the slice STEP, for an
+// array of size LEN. See RFC 9535, Section 2.3.4.2.
+static void SliceBounds(int64_t& lower, int64_t& upper, Step const& step, int64_t len)
+{
+    auto const normalize = [&](int64_t i) { return i >= 0 ? i : len + i; };
+
+    if (step.step > 0)
+    {
+        int64_t const start = step.has_start ? normalize(step.start) : 0;
+        int64_t const end = step.has_end ? normalize(step.end) : len;
+        lower = std::min(std::max(start, int64_t{0}), len);
+        upper = std::min(std::max(end, int64_t{0}), len);
+    }
+    else
+    {
+        int64_t const start = step.has_start ? normalize(step.start) : len - 1;
+        int64_t const end = step.has_end ? normalize(step.end) : -len - 1;
+        upper = std::min(std::max(start, int64_t{-1}), len - 1);
+        lower = std::min(std::max(end, int64_t{-1}), len - 1);
+    }
+}
+
+PathMatches::PathMatches(Path const& path, Value const& root)
+    : path_(path.impl_)
+{
+    if (path_ != nullptr)
+    {
+        Frame frame;
+        frame.value = &root;
+        frame.step = 0;
+        stack_.push_back(frame);
+    }
+}
+
+Value const* PathMatches::NextChild(Frame& frame)
+{
+    if (frame.value->is_array())
+    {
+        auto const& arr = frame.value->get_array();
+        if (static_cast<size_t>(frame.index) < arr.size())
+            return &arr[static_cast<size_t>(frame.index++)];
+    }
+    else if (frame.value->is_object())
+    {
+        auto const& obj = frame.value->get_object();
+        if (!frame.started)
+        {
+            frame.started = true;
+            frame.member = obj.begin();
+        }
+        if (frame.member != obj.end())
+            return &(frame.member++)->second;
+    }
+
+    return nullptr;
+}
+
+Value const* PathMatches::next()
+{
+    if (path_ == nullptr)
+        return nullptr;
+
+    auto const& steps = path_->steps;
+
+    while (!stack_.empty())
+    {
+        auto& frame = stack_.back();
+
+        if (frame.step == steps.size())
+        {
+            Value const* match = frame.value;
+            stack_.pop_back();
+            return match;
+        }
+
+        auto const& step = steps[frame.step];
+
+        Value const* child = nullptr;
+        size_t child_step = frame.step + 1;
+
+        switch (step.kind)
+        {
+        case StepKind::list:
+            while (child == nullptr && frame.pos < step.selectors.size())
+            {
+                child = Select(*frame.value, step.selectors[frame.pos++]);
+            }
+            break;
+
+        case StepKind::wildcard:
+            child = NextChild(frame);
+            break;
+
+        case StepKind::slice:
+            if (frame.value->is_array() && step.step != 0)
+            {
+                auto const& arr = frame.value->get_array();
+
+                int64_t lower;
+                int64_t upper;
+                SliceBounds(lower, upper, step, static_cast<int64_t>(arr.size()));
+
+                if (!frame.started)
+                {
+                    frame.started = true;
+                    frame.index = (step.step > 0) ? lower : upper;
+                }
+
+                if (step.step > 0 ? frame.index < upper : frame.index > lower)
+                {
+                    child = &arr[static_cast<size_t>(frame.index)];
+                    frame.index += step.step;
+                }
+            }
+            break;
+
+        case StepKind::filter:
+            do
+            {
+                child = NextChild(frame);
+            }
+            while (child != nullptr && !Evaluate(*child, step.filter));
+            break;
+
+        case StepKind::descendants:
+            // First the value itself, then all of its descendants.
+            if (frame.pos == 0)
+            {
+                frame.pos = 1;
+                child = frame.value;
+            }
+            else
+            {
+                child = NextChild(frame);
+                child_step = frame.step;
+            }
+            break;
+        }
+
+        if (child == nullptr)
+        {
+            stack_.pop_back();
+            continue;
+        }
+
+        Frame child_frame;
+        child_frame.value = child;
+        child_frame.step = child_step;
+        stack_.push_back(child_frame); // NB: Invalidates FRAME.
+    }
+
+    return nullptr;
+}
+
+//==================================================================================================
+// query
+//==================================================================================================
+
+namespace {
+
+// Evaluates a path while scanning the JSON text.
+//
+// The state of a value is the set of steps which still have to be applied to
+// the value, each with the number of ways in which the value has been reached
+// (e.g. through unions which select the value more than once). Steps with
+// kFilterBit set denote that the value is a candidate for the filter step with
+// that index. The states of the values on the path to the current value are
+// stored in a single vector, followed by the state of the current value.
+class QueryScanner final : public ScanCallbacks
+{
+    static constexpr size_t kFilterBit = ~(SIZE_MAX >> 1);
+
+    struct Frame
+    {
+        size_t first; // Start of the state in states_
+        size_t count; // Number of elements if requested, SIZE_MAX otherwise
+    };
+
+    struct State
+    {
+        size_t step;
+        size_t multiplicity; // The number of times the value is selected by STEP - 1
+    };
+
+    QueryCallbacks& cb_;
+    std::vector<Step> const* steps_; // Null if the path is invalid
+    size_t start_step_;
+    size_t start_multiplicity_;
+    std::vector<State> states_;
+    std::vector<Frame> frames_;
+    size_t current_ = 0; // Start of the state of the current value in states_
+    String key_; // Unescaped key
+
+public:
+    QueryScanner(QueryCallbacks& cb, std::vector<Step> const* steps, size_t start_step, size_t start_multiplicity = 1)
+        : cb_(cb)
+        , steps_(steps)
+        , start_step_(start_step)
+        , start_multiplicity_(start_multiplicity)
+    {
+    }
+
+    unsigned HandleValue(char const* key_first, char const* key_last, bool needs_cleaning, size_t index, Options const& options) override;
+    ParseStatus HandleEnter(size_t count, Options const& options) override;
+    ParseStatus HandleLeave(Options const& options) override;
+    ParseStatus HandleSelect(char const* first, char const* last, Options const& options) override;
+
+private:
+    void AddState(size_t s, size_t multiplicity);
+};
+
+static bool NeedsCount(Step const& step)
+{
+    switch (step.kind)
+    {
+    case StepKind::list:
+        for (auto const& sel : step.selectors)
+        {
+            if (sel.is_index && sel.index < 0)
+                return true;
+        }
+        return false;
+    case StepKind::slice:
+        return step.step < 0 || (step.has_start && step.start < 0) || (step.has_end && step.end < 0);
+    default:
+        return false;
+    }
+}
+
+// Returns whether SEL selects the element INDEX of an array with COUNT
+// elements (or SIZE_MAX if unknown).
+static bool MatchIndex(Selector const& sel, size_t index, size_t count)
+{
+    if (sel.index >= 0)
+        return static_cast<size_t>(sel.index) == index;
+
+    return count != SIZE_MAX && static_cast<int64_t>(count) + sel.index == static_cast<int64_t>(index);
+}
+
+static bool MatchSlice(Step const& step, size_t index, size_t count)
+{
+    if (step.step == 0)
+        return false;
+
+    // Without a count, NeedsCount(step) is false, and the upper bound is not needed.
+    int64_t const len = (count != SIZE_MAX) ? static_cast<int64_t>(count) : INT64_MAX;
+
+    int64_t lower;
+    int64_t upper;
+    SliceBounds(lower, upper, step, len);
+
+    int64_t const i = static_cast<int64_t>(index);
+    if (step.step > 0)
+        return lower <= i && i < upper && (i - lower) % step.step == 0;
+    else
+        return lower < i && i <= upper && (upper - i) % step.step == 0;
+}
+
+void QueryScanner::AddState(size_t s, size_t multiplicity)
+{
+    size_t i = current_;
+    for ( ; i < states_.size(); ++i)
+    {
+        if (states_[i].step == s)
+        {
+            states_[i].multiplicity += multiplicity;
+            break;
+        }
+    }
+
+    if (i == states_.size())
+        states_.push_back({s, multiplicity});
+
+    // Descendants include the value itself.
+    if (s < steps_->size() && (*steps_)[s].kind == StepKind::descendants)
+        AddState(s + 1, multiplicity);
+}
+
+unsigned QueryScanner::HandleValue(char const* key_first, char const* key_last, bool needs_cleaning, size_t index, Options const& /*options*/)
+{
+    if (steps_ == nullptr)
+        return scan_skip;
+
+    auto const& steps = *steps_;
+    auto const num_steps = steps.size();
+
+    states_.resize(current_);
+
+    if (frames_.empty())
+    {
+        AddState(start_step_, start_multiplicity_);
+    }
+    else
+    {
+        bool const is_member = (key_first != nullptr);
+        bool key_ready = !needs_cleaning;
+
+        auto const& parent = frames_.back();
+        for (size_t i = parent.first; i < current_; ++i)
+        {
+            size_t const s = states_[i].step;
+            size_t const m = states_[i].multiplicity;
+            if ((s & kFilterBit) != 0 || s == num_steps)
+                continue;
+
+            auto const& step = steps[s];
+            switch (step.kind)
+            {
+            case StepKind::list:
+                {
+                    // Each selector which matches selects the value once more.
+                    size_t num_matches = 0;
+                    for (auto const& sel : step.selectors)
+                    {
+                        bool matches = false;
+                        if (sel.is_index)
+                        {
+                            matches = !is_member && MatchIndex(sel, index, parent.count);
+                        }
+                        else if (is_member)
+                        {
+                            if (!key_ready)
+                            {
+                                // The scanner has already validated the key.
+                                key_.resize(static_cast<size_t>(key_last - key_first));
+                                char* out = &key_[0];
+                                strings::UnescapeStringBulk(key_first, key_last, out);
+                                key_.resize(static_cast<size_t>(out - key_.data()));
+                                key_first = key_.data();
+                                key_last = key_.data() + key_.size();
+                                key_ready = true;
+                            }
+
+                            auto const& name = sel.name.str();
+                            matches = name.size() == static_cast<size_t>(key_last - key_first) && std::memcmp(name.data(), key_first, name.size()) == 0;
+                        }
+
+                        if (matches)
+                            ++num_matches;
+                    }
+                    if (num_matches != 0)
+                        AddState(s + 1, m * num_matches);
+                }
+                break;
+
+            case StepKind::wildcard:
+                AddState(s + 1, m);
+                break;
+
+            case StepKind::slice:
+                if (!is_member && MatchSlice(step, index, parent.count))
+                    AddState(s + 1, m);
+                break;
+
+            case StepKind::filter:
+                AddState(s | kFilterBit, m);
+                break;
+
+            case StepKind::descendants:
+                AddState(s, m);
+                break;
+            }
+        }
+    }
+
+    unsigned flags = scan_skip;
+    for (size_t i = current_; i < states_.size(); ++i)
+    {
+        size_t const s = states_[i].step;
+        if ((s & kFilterBit) != 0 || s == num_steps)
+        {
+            flags |= scan_select;
+        }
+        else
+        {
+            flags |= scan_descend;
+            if (NeedsCount(steps[s]))
+                flags |= scan_count;
+        }
+    }
+
+    return flags;
+}
+
+ParseStatus QueryScanner::HandleEnter(size_t count, Options const& /*options*/)
+{
+    frames_.push_back({current_, count});
+    current_ = states_.size();
+
+    return ParseStatus::success;
+}
+
+ParseStatus QueryScanner::HandleLeave(Options const& /*options*/)
+{
+    JSON_ASSERT(!frames_.empty());
+
+    // Drop the state of the last member resp. element.
+    states_.resize(current_);
+
+    current_ = frames_.back().first;
+    frames_.pop_back();
+
+    return ParseStatus::success;
+}
+
+ParseStatus QueryScanner::HandleSelect(char const* first, char const* last, Options const& options)
+{
+    auto const& steps = *steps_;
+
+    for (size_t i = current_; i < states_.size(); ++i)
+    {
+        size_t const s = states_[i].step;
+        size_t const m = states_[i].multiplicity;
+        if (s == steps.size())
+        {
+            for (size_t k = 0; k < m; ++k)
+            {
+                auto const ec = cb_.HandleMatch(first, last, options);
+                if (ec != ParseStatus::success)
+                    return ec;
+            }
+        }
+        else if ((s & kFilterBit) != 0)
+        {
+            size_t const f = s & ~kFilterBit;
+
+            Value value;
+            auto const res = json::parse(value, first, last, options);
+            if (res.ec != ParseStatus::success)
+                return res.ec;
+
+            if (Evaluate(value, steps[f].filter))
+            {
+                // Apply the remaining steps to the candidate.
+                QueryScanner scanner(cb_, steps_, f + 1, m);
+
+                auto const ec = json::scan(scanner, first, last, options).ec;
+                if (ec != ParseStatus::success)
+                    return ec;
+            }
+        }
+    }
+
+    return ParseStatus::success;
+}
+
+struct CollectMatches final : QueryCallbacks
+{
+    std::vector<Value>& matches;
+
+    explicit CollectMatches(std::vector<Value>& matches_) : matches(matches_) {}
+
+    ParseStatus HandleMatch(char const* first, char const* last, Options const& options) override
+    {
+        matches.emplace_back();
+        return json::parse(matches.back(), first, last, options).ec;
+    }
+};
+
+} // namespace
+
+ParseResult json::query(QueryCallbacks& cb, Path const& path, char const* next, char const* last, Options const& options)
+{
+    QueryScanner scanner(cb, path.impl_ != nullptr ? &path.impl_->steps : nullptr, 0);
+
+    return json::scan(scanner, next, last, options);
+}
+
+ParseStatus json::query(std::vector<Value>& matches, Path const& path, std::string const& str, Options const& options)
+{
+    matches.clear();
+
+    CollectMatches cb(matches);
+
+    char const* next = str.data();
+    char const* last = str.data() + str.size();
+
+    return json::query(cb, path, next, last, options).ec;
+}
@@ -0,0 +1,147 @@
+// Copyright 2018 Alexander Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "json.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace json {
+
+//==================================================================================================
+// Path
+//==================================================================================================
+
+// A compiled JSONPath expression.
+//
+// Supported are
+//      $                   the root value
+//      .name  ['name']     object members (names may be single- or double-quoted)
+//      [0]  [-1]           array elements (negative indices count from the end)
+//      .*  [*]             all elements resp. members
+//      [1,'a',-1]          unions of the above
+//      [start:end:step]    array slices (all parts optional)
+//      ..name  ..[...]     recursive descent
+//      [?(@.a.b < 2 && @.c == 'x' || @.d)]
+//                          filters: comparisons (==, !=, <, <=, >, >=) of a
+//                          member of the current value with a literal (number,
+//                          string, true, false, null), existence tests, and
+//                          combinations of these using && and ||
+//
+// As in RFC 9535, a value which is selected more than once is also matched
+// more than once: e.g. "$[0,-1]" matches the only element of [6] twice, and
+// "$..a..b" matches the "b" in {"a": {"a": {"b": 1}}} twice.
+//
+// A Path is immutable and may be used to query any number of values (also
+// concurrently).
+struct QueryCallbacks;
+
+class Path final
+{
+    friend class PathMatches;
+    friend ParseResult query(QueryCallbacks& cb, Path const& path, char const* next, char const* last, Options const& options);
+
+    struct Impl;
+    std::shared_ptr<Impl const> impl_;
+
+public:
+    // Creates an invalid path.
+    Path();
+
+    // Compiles the expression EXPR.
+    // If EXPR is not a valid expression, is_valid() returns false and the
+    // path does not match any value.
+    explicit Path(std::string const& expr);
+
+    bool is_valid() const noexcept { return impl_ != nullptr; }
+};
+
+// The values matched by a Path, produced lazily, in document order.
+//
+//      json::Path const path("$.store.book[?(@.price < 10)].title");
+//      ...
+//      json::PathMatches matches(path, value);
+//      while (auto const* v = matches.next()) {
+//          ...
+//      }
+//
+// NB: The queried value must not be modified while iterating over the matches.
+class PathMatches final
+{
+    struct Frame
+    {
+        Value const* value;
+        size_t step;                         // Index of the next step to apply to VALUE
+        size_t pos = 0;                      // Position in a list of names or indices
+        int64_t index = 0;                   // The next array element
+        Object::const_iterator member;       // The next object member
+        bool started = false;                // Iteration has started
+    };
+
+    std::shared_ptr<Path::Impl const> path_;
+    std::vector<Frame> stack_;
+
+public:
+    PathMatches(Path const& path, Value const& root);
+
+    // Returns the next match, or nullptr if there are no more matches.
+    Value const* next();
+
+private:
+    Value const* NextChild(Frame& frame);
+};
+
+//==================================================================================================
+// query
+//==================================================================================================
+
+struct QueryCallbacks
+{
+    virtual ~QueryCallbacks() {}
+
+    // Called for each value matched by the path.
+    // [FIRST, LAST) is the JSON text of the matched value.
+    virtual ParseStatus HandleMatch(char const* first, char const* last, Options const& options) = 0;
+};
+
+// Evaluates PATH directly against the JSON text [NEXT, LAST), without building
+// a Value. Values which cannot contain a match are skipped (but the input is
+// still fully validated).
+//
+// Matches are reported as soon as their end has been reached, i.e. in the
+// order in which they appear in the input, and a match which is nested inside
+// another match is reported before the outer match. (PathMatches visits
+// object members sorted by key, and slices with negative steps backwards.)
+//
+// Duplicate keys are not merged: if an object contains a key more than once,
+// query matches each of these members, whereas a Value keeps only the last one
+// (so PathMatches on the parsed Value matches only the last member). For such
+// input the two may return different matches.
+// Candidates for filters are parsed into a Value to evaluate the filter.
+ParseResult query(QueryCallbacks& cb, Path const& path, char const* next, char const* last, Options const& options = {});
+
+// Parses the values matched by PATH in STR into MATCHES.
+ParseStatus query(std::vector<Value>& matches, Path const& path, std::string const& str, Options const& options = {});
+
+} // namespace json
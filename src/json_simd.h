@@ -0,0 +1,86 @@
+// Copyright 2018 Alexander Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+
+#ifndef JSON_ASSERT
+#define JSON_ASSERT(X) assert(X)
+#endif
+
+// Set JSON_USE_SSE2 to 0 to disable the vectorized code paths.
+#ifndef JSON_USE_SSE2
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JSON_USE_SSE2 1
+#else
+#define JSON_USE_SSE2 0
+#endif
+#endif
+
+// Set JSON_USE_SSSE3 to 0 to disable the code paths which require SSSE3 (PSHUFB).
+// MSVC doesn't define __SSSE3__, but /arch:AVX implies SSSE3.
+#ifndef JSON_USE_SSSE3
+#if JSON_USE_SSE2 && (defined(__SSSE3__) || defined(__AVX__))
+#define JSON_USE_SSSE3 1
+#else
+#define JSON_USE_SSSE3 0
+#endif
+#endif
+
+#if JSON_USE_SSE2
+#include <emmintrin.h>
+#endif
+#if JSON_USE_SSSE3
+#include <tmmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace json {
+namespace simd {
+
+// Returns the number of trailing 0-bits in x, starting at the least significant bit position.
+// PRE: x != 0
+inline int CountTrailingZeros32(uint32_t x)
+{
+    JSON_ASSERT(x != 0);
+
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, x);
+    return static_cast<int>(index);
+#elif defined(__GNUC__)
+    return __builtin_ctz(x);
+#else
+    int tz = 0;
+    while ((x & 1) == 0) {
+        x >>= 1;
+        ++tz;
+    }
+    return tz;
+#endif
+}
+
+} // namespace simd
+} // namespace json
@@ -0,0 +1,537 @@
+// Copyright 2018 Alexander Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "json_snapshot.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <unordered_map>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define JSON_SNAPSHOT_USE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define JSON_SNAPSHOT_USE_MMAP 0
+#endif
+
+using namespace json;
+
+static constexpr char const kMagic[4] = {'J', 'S', 'N', 'P'};
+static constexpr uint32_t kVersion = 1;
+static constexpr uint32_t kByteOrderMark = 0x01020304;
+static constexpr size_t kHeaderSize = 32;
+
+//==================================================================================================
+// write_snapshot
+//==================================================================================================
+
+namespace {
+
+struct SnapshotWriter
+{
+    std::string& out;
+    size_t const base;                              // Start of the snapshot in OUT
+    std::unordered_map<String, uint64_t> keys;      // Offsets of the keys written so far
+
+    explicit SnapshotWriter(std::string& out_) : out(out_), base(out_.size()) {}
+
+    uint64_t Offset() const { return static_cast<uint64_t>(out.size() - base); }
+
+    void Align()
+    {
+        size_t const pad = (8 - (out.size() - base) % 8) % 8;
+        out.append(pad, '\0');
+    }
+
+    void Put(uint64_t v)
+    {
+        char buf[8];
+        std::memcpy(buf, &v, sizeof(uint64_t));
+        out.append(buf, 8);
+    }
+
+    static uint64_t MakeRef(char tag, uint64_t offset)
+    {
+        return (uint64_t{static_cast<unsigned char>(tag)} << 56) | offset;
+    }
+
+    uint64_t WriteString(String const& str)
+    {
+        Align();
+
+        uint64_t const offset = Offset();
+        Put(str.size());
+        out.append(str.data(), str.size());
+        out.push_back('\0');
+
+        return MakeRef('s', offset);
+    }
+
+    uint64_t WriteKey(String const& key)
+    {
+        auto const it = keys.find(key);
+        if (it != keys.end())
+            return it->second;
+
+        uint64_t const ref = WriteString(key);
+        keys.emplace(key, ref);
+        return ref;
+    }
+
+    bool Write(uint64_t& ref, Value const& value)
+    {
+        switch (value.type())
+        {
+        case Type::undefined:
+            return false;
+
+        case Type::null:
+            ref = MakeRef('n', 0);
+            return true;
+
+        case Type::boolean:
+            ref = MakeRef(value.get_boolean() ? 't' : 'f', 0);
+            return true;
+
+        case Type::number:
+            {
+                Align();
+
+                double const d = value.get_number();
+                uint64_t bits;
+                std::memcpy(&bits, &d, sizeof(double));
+
+                ref = MakeRef('d', Offset());
+                Put(bits);
+            }
+            return true;
+
+        case Type::string:
+            ref = WriteString(value.get_string());
+            return true;
+
+        case Type::array:
+            {
+                // Write the elements first, then the table of references.
+                auto const& arr = value.get_array();
+
+                std::vector<uint64_t> refs(arr.size());
+                for (size_t i = 0; i < arr.size(); ++i)
+                {
+                    if (!Write(refs[i], arr[i]))
+                        return false;
+                }
+
+                Align();
+
+                ref = MakeRef('[', Offset());
+                Put(refs.size());
+                for (auto const r : refs)
+                    Put(r);
+            }
+            return true;
+
+        case Type::object:
+            {
+                // The members of a Value are already sorted by key.
+                auto const& obj = value.get_object();
+
+                std::vector<std::pair<uint64_t, uint64_t>> refs;
+                refs.reserve(obj.size());
+                for (auto const& m : obj)
+                {
+                    uint64_t const key_ref = WriteKey(m.first);
+                    uint64_t value_ref = 0;
+                    if (!Write(value_ref, m.second))
+                        return false;
+                    refs.emplace_back(key_ref, value_ref);
+                }
+
+                Align();
+
+                ref = MakeRef('{', Offset());
+                Put(refs.size());
+                for (auto const& r : refs)
+                {
+                    Put(r.first);
+                    Put(r.second);
+                }
+            }
+            return true;
+        }
+
+        return false;
+    }
+};
+
+} // namespace
+
+bool json::write_snapshot(std::string& out, Value const& value)
+{
+    size_t const start = out.size();
+
+    SnapshotWriter writer(out);
+
+    // Header. The size and the root are patched below.
+    out.append(kMagic, 4);
+    {
+        char buf[8] = {};
+        std::memcpy(buf, &kVersion, sizeof(uint32_t));
+        std::memcpy(buf + 4, &kByteOrderMark, sizeof(uint32_t));
+        out.append(buf, 8);
+    }
+    out.append(4, '\0'); // Reserved
+    writer.Put(0);
+    writer.Put(0);
+
+    uint64_t root = 0;
+    if (!writer.Write(root, value))
+    {
+        out.resize(start);
+        return false;
+    }
+
+    writer.Align();
+
+    uint64_t const size = writer.Offset();
+    std::memcpy(&out[start + 16], &size, sizeof(uint64_t));
+    std::memcpy(&out[start + 24], &root, sizeof(uint64_t));
+
+    return true;
+}
+
+bool json::write_snapshot_file(char const* filename, Value const& value)
+{
+    std::string buf;
+    if (!json::write_snapshot(buf, value))
+        return false;
+
+    std::FILE* file = std::fopen(filename, "wb");
+    if (file == nullptr)
+        return false;
+
+    bool const ok = std::fwrite(buf.data(), 1, buf.size(), file) == buf.size();
+    return std::fclose(file) == 0 && ok;
+}
+
+//==================================================================================================
+// Snapshot
+//==================================================================================================
+
+Snapshot::~Snapshot()
+{
+    close();
+}
+
+bool Snapshot::open(char const* filename, bool verify)
+{
+    close();
+
+#if JSON_SNAPSHOT_USE_MMAP
+    int const fd = ::open(filename, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    size_t const size = static_cast<size_t>(st.st_size);
+    void* const mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps the file open.
+    if (mapping == MAP_FAILED)
+        return false;
+
+    mapping_ = mapping;
+    mapping_size_ = size;
+
+    if (!Attach(static_cast<char const*>(mapping), size, verify))
+    {
+        close();
+        return false;
+    }
+#else
+    std::FILE* file = std::fopen(filename, "rb");
+    if (file == nullptr)
+        return false;
+
+    std::fseek(file, 0, SEEK_END);
+    long const length = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+
+    size_t const size = length > 0 ? static_cast<size_t>(length) : 0;
+    std::vector<uint64_t> buffer((size + 7) / 8);
+
+    bool const ok = size > 0 && std::fread(buffer.data(), 1, size, file) == size;
+    std::fclose(file);
+    if (!ok)
+        return false;
+
+    if (!Attach(reinterpret_cast<char const*>(buffer.data()), size, verify))
+        return false;
+
+    // NB: Moving the vector does not move the data.
+    buffer_ = std::move(buffer);
+#endif
+
+    return true;
+}
+
+bool Snapshot::open(char const* data, size_t size, bool verify)
+{
+    close();
+    return Attach(data, size, verify);
+}
+
+bool Snapshot::Attach(char const* data, size_t size, bool verify)
+{
+    if (size < kHeaderSize || std::memcmp(data, kMagic, 4) != 0)
+        return false;
+
+    uint32_t version;
+    std::memcpy(&version, data + 4, sizeof(uint32_t));
+    uint32_t byte_order;
+    std::memcpy(&byte_order, data + 8, sizeof(uint32_t));
+    if (version != kVersion || byte_order != kByteOrderMark)
+        return false;
+
+    uint64_t stored_size;
+    std::memcpy(&stored_size, data + 16, sizeof(uint64_t));
+    if (stored_size > size || stored_size % 8 != 0)
+        return false;
+
+    uint64_t root;
+    std::memcpy(&root, data + 24, sizeof(uint64_t));
+    if (verify && !Verify(data, static_cast<size_t>(stored_size), root))
+        return false;
+
+    data_ = data;
+    return true;
+}
+
+// Checks that all values reachable from ROOT lie inside [DATA, DATA + SIZE),
+// so that a corrupted snapshot is rejected instead of being read out of
+// bounds, and that the keys of each object are sorted (which find relies on).
+// Each item is checked only once (per tag).
+// Values are written before the arrays and objects which contain them, so the
+// elements and members must be stored at smaller offsets. This rules out
+// cycles.
+bool Snapshot::Verify(char const* data, size_t size, uint64_t root)
+{
+    static constexpr uint64_t kOffsetMask = (uint64_t{1} << 56) - 1;
+
+    auto const load = [&](uint64_t offset) {
+        uint64_t v;
+        std::memcpy(&v, data + offset, sizeof(uint64_t));
+        return v;
+    };
+
+    // Returns whether the string at OFFSET lies inside the snapshot.
+    auto const is_valid_string = [&](uint64_t offset) {
+        if (offset < kHeaderSize || offset % 8 != 0 || offset + 8 > size)
+            return false;
+        uint64_t const length = load(offset);
+        return length < size - offset - 8 && data[offset + 8 + length] == '\0';
+    };
+
+    // Compares the strings at LHS and RHS like std::string's.
+    auto const string_less = [&](uint64_t lhs, uint64_t rhs) {
+        uint64_t const lhs_length = load(lhs);
+        uint64_t const rhs_length = load(rhs);
+        int const c = std::memcmp(data + lhs + 8, data + rhs + 8, static_cast<size_t>(std::min(lhs_length, rhs_length)));
+        return c < 0 || (c == 0 && lhs_length < rhs_length);
+    };
+
+    std::vector<unsigned char> visited(size / 8); // The tags each item has been checked for
+    std::vector<uint64_t> stack;
+    stack.push_back(root);
+
+    while (!stack.empty())
+    {
+        uint64_t const ref = stack.back();
+        stack.pop_back();
+
+        char const tag = static_cast<char>(ref >> 56);
+        uint64_t const offset = ref & kOffsetMask;
+
+        if (tag == 'n' || tag == 't' || tag == 'f')
+        {
+            if (offset != 0)
+                return false;
+            continue;
+        }
+
+        if (offset < kHeaderSize || offset % 8 != 0 || offset + 8 > size)
+            return false;
+
+        // (A corrupted reference might refer to an item with a different tag.)
+        unsigned const tag_bit = tag == 'd' ? 1u : tag == 's' ? 2u : tag == '[' ? 4u : tag == '{' ? 8u : 0u;
+        if (tag_bit == 0)
+            return false;
+        if ((visited[offset / 8] & tag_bit) != 0)
+            continue;
+        visited[offset / 8] = static_cast<unsigned char>(visited[offset / 8] | tag_bit);
+
+        uint64_t const avail = size - offset - 8; // Bytes after the first word
+        switch (tag)
+        {
+        case 'd':
+            break;
+        case 's':
+            if (!is_valid_string(offset))
+                return false;
+            break;
+        case '[':
+            {
+                uint64_t const count = load(offset);
+                if (count > avail / 8)
+                    return false;
+                for (uint64_t i = 0; i < count; ++i)
+                {
+                    uint64_t const element = load(offset + 8 + 8 * i);
+                    if ((element & kOffsetMask) >= offset)
+                        return false;
+                    stack.push_back(element);
+                }
+            }
+            break;
+        case '{':
+            {
+                uint64_t const count = load(offset);
+                if (count > avail / 16)
+                    return false;
+                uint64_t prev_key = 0;
+                for (uint64_t i = 0; i < count; ++i)
+                {
+                    uint64_t const key = load(offset + 8 + 16 * i);
+                    uint64_t const value = load(offset + 8 + 16 * i + 8);
+                    if (static_cast<char>(key >> 56) != 's' || (key & kOffsetMask) >= offset || (value & kOffsetMask) >= offset)
+                        return false;
+                    if (!is_valid_string(key & kOffsetMask))
+                        return false;
+                    if (i > 0 && !string_less(prev_key, key & kOffsetMask))
+                        return false;
+                    prev_key = key & kOffsetMask;
+                    stack.push_back(key);
+                    stack.push_back(value);
+                }
+            }
+            break;
+        default:
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void Snapshot::close() noexcept
+{
+#if JSON_SNAPSHOT_USE_MMAP
+    if (mapping_ != nullptr)
+        ::munmap(mapping_, mapping_size_);
+#endif
+
+    data_ = nullptr;
+    mapping_ = nullptr;
+    mapping_size_ = 0;
+    buffer_.clear();
+    buffer_.shrink_to_fit();
+}
+
+//==================================================================================================
+// SnapshotValue
+//==================================================================================================
+
+SnapshotValue SnapshotValue::find(char const* key, size_t length) const noexcept
+{
+    if (!is_object())
+        return {};
+
+    // Binary search for the first member whose key is not less than KEY.
+    // Keys are compared like std::string's.
+    char const* const first = data() + 8;
+
+    size_t lo = 0;
+    size_t hi = static_cast<size_t>(Count());
+    while (lo < hi)
+    {
+        size_t const mid = lo + (hi - lo) / 2;
+
+        SnapshotValue const k(base_, Load(first + 16 * mid));
+        size_t const k_length = k.string_size();
+
+        int cmp = std::memcmp(k.string_data(), key, std::min(k_length, length));
+        if (cmp == 0)
+            cmp = (k_length < length) ? -1 : (k_length > length ? 1 : 0);
+
+        if (cmp == 0)
+            return SnapshotValue(base_, Load(first + 16 * mid + 8));
+
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return {};
+}
+
+Value SnapshotValue::to_value() const
+{
+    switch (type())
+    {
+    case Type::undefined:
+        return {};
+    case Type::null:
+        return nullptr;
+    case Type::boolean:
+        return get_boolean();
+    case Type::number:
+        return get_number();
+    case Type::string:
+        return get_string();
+    case Type::array:
+        {
+            Value arr(json::array_tag);
+            arr.get_array().reserve(size());
+            for (auto const v : elements())
+                arr.get_array().push_back(v.to_value());
+            return arr;
+        }
+    case Type::object:
+        {
+            Value obj(json::object_tag);
+            auto& o = obj.get_object();
+            for (auto const m : items())
+                o.emplace_hint(o.end(), m.key.get_string(), m.value.to_value());
+            return obj;
+        }
+    }
+
+    return {};
+}
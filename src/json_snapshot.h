@@ -0,0 +1,398 @@
+// Copyright 2018 Alexander Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "json.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+//
+// A binary snapshot of a Value, which can be read without deserializing.
+//
+//      json::write_snapshot_file("catalog.snap", value);
+//      ...
+//      json::Snapshot snap;
+//      if (snap.open("catalog.snap")) {
+//          auto const price = snap.root()["items"][42]["price"].get_number();
+//      }
+//
+// The snapshot is a single block of memory, which contains offsets instead of
+// pointers, so that it can be mapped into memory and used directly. All items
+// are aligned at 8-byte boundaries. The byte order is the native byte order of
+// the machine which wrote the snapshot; snapshots with a different byte order
+// are rejected.
+//
+// Layout:
+//
+//      header          "JSNP", version (4 bytes), byte order mark (4 bytes),
+//                      reserved (4 bytes), size (8 bytes), root (8 bytes)
+//
+// A value is referenced by a 64-bit word: a tag in the upper 8 bits, and the
+// offset of the data in the lower 56 bits:
+//
+//      'n' 't' 'f'     null, true, false (no data)
+//      'd'             the double
+//      's'             the length (8 bytes), the characters, and a '\0'
+//      '['             the number of elements (8 bytes), and a reference for
+//                      each element
+//      '{'             the number of members (8 bytes), and a pair of
+//                      references (key, value) for each member, sorted by key
+//
+// Keys are stored only once per snapshot.
+//
+
+namespace json {
+
+class SnapshotValue;
+
+//==================================================================================================
+// write_snapshot
+//==================================================================================================
+
+// Appends a snapshot of VALUE to OUT.
+// Returns false if VALUE contains an undefined value.
+bool write_snapshot(std::string& out, Value const& value);
+
+// Writes a snapshot of VALUE into the file FILENAME.
+bool write_snapshot_file(char const* filename, Value const& value);
+
+//==================================================================================================
+// Snapshot
+//==================================================================================================
+
+// A read-only view of a snapshot, either mapped from a file, or stored in
+// memory owned by the caller.
+//
+// By default, opening a snapshot only checks the header, which takes constant
+// time and does not touch the rest of the file. Reading a corrupted snapshot is
+// then undefined behavior, and lookups in objects whose keys are not sorted
+// return wrong results.
+//
+// If a snapshot comes from an untrusted source, open it with VERIFY = true:
+// Then all references, lengths and counts are checked against the size of the
+// snapshot, and the keys of each object must be sorted, so that reading a
+// corrupted snapshot cannot access memory outside of it. This reads the whole
+// snapshot once (which pages in the whole mapping) and needs an additional
+// size/8 bytes of memory. Corrupted snapshots might still contain wrong values,
+// though.
+class Snapshot final
+{
+    char const* data_ = nullptr;
+    void* mapping_ = nullptr;       // The mapped file, if any
+    size_t mapping_size_ = 0;
+    std::vector<uint64_t> buffer_;  // The contents of the file, if mapping is not supported
+
+public:
+    Snapshot() = default;
+    ~Snapshot();
+
+    Snapshot(Snapshot const&) = delete;
+    Snapshot& operator=(Snapshot const&) = delete;
+
+    // Maps the file FILENAME into memory.
+    // Returns false if the file could not be mapped, or is not a valid snapshot.
+    // If VERIFY is true, checks the contents of the snapshot (see above).
+    bool open(char const* filename, bool verify = false);
+
+    // Uses the snapshot stored in [DATA, DATA + SIZE). The memory must remain
+    // valid until the snapshot is closed.
+    // Returns false if the memory does not contain a valid snapshot.
+    // If VERIFY is true, checks the contents of the snapshot (see above).
+    bool open(char const* data, size_t size, bool verify = false);
+
+    void close() noexcept;
+
+    bool is_open() const noexcept { return data_ != nullptr; }
+
+    // Returns the root value, or an undefined value if the snapshot is not open.
+    SnapshotValue root() const noexcept;
+
+private:
+    bool Attach(char const* data, size_t size, bool verify);
+    static bool Verify(char const* data, size_t size, uint64_t root);
+};
+
+//==================================================================================================
+// SnapshotValue
+//==================================================================================================
+
+// A reference to a value stored in a Snapshot.
+// Provides (mostly) the same read API as Value.
+class SnapshotValue final
+{
+    friend class Snapshot;
+
+    static constexpr uint64_t kOffsetMask = (uint64_t{1} << 56) - 1;
+
+    char const* base_ = nullptr;
+    uint64_t ref_ = 0;
+
+    SnapshotValue(char const* base, uint64_t ref) : base_(base), ref_(ref) {}
+
+    char tag() const noexcept { return base_ != nullptr ? static_cast<char>(ref_ >> 56) : '\0'; }
+    char const* data() const noexcept { return base_ + (ref_ & kOffsetMask); }
+
+    static uint64_t Load(char const* p) noexcept
+    {
+        uint64_t v;
+        std::memcpy(&v, p, sizeof(uint64_t));
+        return v;
+    }
+
+    // Returns the number of elements resp. members, or the length of a string.
+    uint64_t Count() const noexcept { return Load(data()); }
+
+public:
+    // Creates an undefined value.
+    SnapshotValue() = default;
+
+    Type type() const noexcept
+    {
+        switch (tag())
+        {
+        case 'n':
+            return Type::null;
+        case 't':
+        case 'f':
+            return Type::boolean;
+        case 'd':
+            return Type::number;
+        case 's':
+            return Type::string;
+        case '[':
+            return Type::array;
+        case '{':
+            return Type::object;
+        default:
+            return Type::undefined;
+        }
+    }
+
+    bool is_undefined()  const noexcept { return type() == Type::undefined; }
+    bool is_null()       const noexcept { return type() == Type::null;      }
+    bool is_boolean()    const noexcept { return type() == Type::boolean;   }
+    bool is_number()     const noexcept { return type() == Type::number;    }
+    bool is_string()     const noexcept { return type() == Type::string;    }
+    bool is_array()      const noexcept { return type() == Type::array;     }
+    bool is_object()     const noexcept { return type() == Type::object;    }
+    bool is_primitive()  const noexcept { return Type::null <= type() && type() <= Type::string; }
+    bool is_structured() const noexcept { return is_array() || is_object(); }
+
+    bool is(Type t) const noexcept { return type() == t; }
+
+    // PRE: is_boolean()
+    bool get_boolean() const noexcept
+    {
+        JSON_ASSERT(is_boolean());
+        return tag() == 't';
+    }
+
+    // PRE: is_number()
+    double get_number() const noexcept
+    {
+        JSON_ASSERT(is_number());
+
+        double value;
+        std::memcpy(&value, data(), sizeof(double));
+        return value;
+    }
+
+    // Returns the (null-terminated) characters of the string.
+    // PRE: is_string()
+    char const* string_data() const noexcept
+    {
+        JSON_ASSERT(is_string());
+        return data() + 8;
+    }
+
+    // PRE: is_string()
+    size_t string_size() const noexcept
+    {
+        JSON_ASSERT(is_string());
+        return static_cast<size_t>(Count());
+    }
+
+    // PRE: is_string()
+    String get_string() const { return String(string_data(), string_size()); }
+
+    // Returns the length of a string, or the number of elements resp. members
+    // of an array resp. object.
+    // PRE: is_string() or is_array() or is_object()
+    size_t size() const noexcept
+    {
+        JSON_ASSERT(is_string() || is_array() || is_object());
+        return static_cast<size_t>(Count());
+    }
+
+    // PRE: is_string() or is_array() or is_object()
+    bool empty() const noexcept { return size() == 0; }
+
+    // Returns the element at INDEX, or an undefined value if INDEX is out of
+    // bounds.
+    // PRE: is_array()
+    SnapshotValue operator[](size_t index) const noexcept
+    {
+        JSON_ASSERT(is_array());
+
+        if (index >= Count())
+            return {};
+
+        return SnapshotValue(base_, Load(data() + 8 + 8 * index));
+    }
+
+    // Returns the value of the member KEY, or an undefined value if this value
+    // is not an object or if no such member exists.
+    // This is a binary search.
+    SnapshotValue find(char const* key, size_t length) const noexcept;
+
+    // (A template, so that v[0] selects the array overload.)
+    template <typename T, std::enable_if_t<std::is_convertible<T, char const*>::value, int> = 0>
+    SnapshotValue operator[](T key) const noexcept { return find(key, std::strlen(key)); }
+    SnapshotValue operator[](String const& key) const noexcept { return find(key.data(), key.size()); }
+
+    bool has_member(char const* key) const noexcept { return !(*this)[key].is_undefined(); }
+    bool has_member(String const& key) const noexcept { return !(*this)[key].is_undefined(); }
+
+    // Converts this value into a Value.
+    Value to_value() const;
+
+    //--------------------------------------------------------------------------
+    // Iteration
+    //
+
+    class element_iterator;
+    class item_iterator;
+    struct Member;
+
+    template <typename It>
+    struct ItRange {
+        It begin_;
+        It end_;
+        It begin() const { return begin_; }
+        It end() const { return end_; }
+    };
+
+    // PRE: is_array()
+    ItRange<element_iterator> elements() const;
+
+    // Members are visited in sorted order (as in Value).
+    // PRE: is_object()
+    ItRange<item_iterator> items() const;
+};
+
+class SnapshotValue::element_iterator
+{
+    char const* base_ = nullptr;
+    char const* ptr_ = nullptr; // The reference to the element
+
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type        = SnapshotValue;
+    using reference         = SnapshotValue;
+    using pointer           = void;
+    using difference_type   = std::ptrdiff_t;
+
+    element_iterator() = default;
+    element_iterator(char const* base, char const* ptr) : base_(base), ptr_(ptr) {}
+
+    reference operator*() const { return SnapshotValue(base_, Load(ptr_)); }
+    reference operator[](difference_type n) const { return SnapshotValue(base_, Load(ptr_ + 8 * n)); }
+
+    element_iterator& operator++() { ptr_ += 8; return *this; }
+    element_iterator& operator--() { ptr_ -= 8; return *this; }
+    element_iterator operator++(int) { auto I = *this; ++*this; return I; }
+    element_iterator operator--(int) { auto I = *this; --*this; return I; }
+    element_iterator& operator+=(difference_type n) { ptr_ += 8 * n; return *this; }
+    element_iterator& operator-=(difference_type n) { ptr_ -= 8 * n; return *this; }
+
+    friend element_iterator operator+(element_iterator it, difference_type n) { return it += n; }
+    friend element_iterator operator+(difference_type n, element_iterator it) { return it += n; }
+    friend element_iterator operator-(element_iterator it, difference_type n) { return it -= n; }
+    friend difference_type operator-(element_iterator lhs, element_iterator rhs) { return (lhs.ptr_ - rhs.ptr_) / 8; }
+
+    friend bool operator==(element_iterator lhs, element_iterator rhs) { return lhs.ptr_ == rhs.ptr_; }
+    friend bool operator!=(element_iterator lhs, element_iterator rhs) { return lhs.ptr_ != rhs.ptr_; }
+    friend bool operator< (element_iterator lhs, element_iterator rhs) { return lhs.ptr_ <  rhs.ptr_; }
+    friend bool operator<=(element_iterator lhs, element_iterator rhs) { return lhs.ptr_ <= rhs.ptr_; }
+    friend bool operator> (element_iterator lhs, element_iterator rhs) { return lhs.ptr_ >  rhs.ptr_; }
+    friend bool operator>=(element_iterator lhs, element_iterator rhs) { return lhs.ptr_ >= rhs.ptr_; }
+};
+
+struct SnapshotValue::Member
+{
+    SnapshotValue key; // A string
+    SnapshotValue value;
+};
+
+class SnapshotValue::item_iterator
+{
+    char const* base_ = nullptr;
+    char const* ptr_ = nullptr; // The references to the key and the value
+
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = Member;
+    using reference         = Member;
+    using pointer           = void;
+    using difference_type   = std::ptrdiff_t;
+
+    item_iterator() = default;
+    item_iterator(char const* base, char const* ptr) : base_(base), ptr_(ptr) {}
+
+    reference operator*() const { return {SnapshotValue(base_, Load(ptr_)), SnapshotValue(base_, Load(ptr_ + 8))}; }
+    item_iterator& operator++() { ptr_ += 16; return *this; }
+    item_iterator operator++(int) { auto I = *this; ++*this; return I; }
+
+    friend bool operator==(item_iterator lhs, item_iterator rhs) { return lhs.ptr_ == rhs.ptr_; }
+    friend bool operator!=(item_iterator lhs, item_iterator rhs) { return lhs.ptr_ != rhs.ptr_; }
+};
+
+inline SnapshotValue::ItRange<SnapshotValue::element_iterator> SnapshotValue::elements() const
+{
+    JSON_ASSERT(is_array());
+
+    char const* const first = data() + 8;
+    return {element_iterator(base_, first), element_iterator(base_, first + 8 * Count())};
+}
+
+inline SnapshotValue::ItRange<SnapshotValue::item_iterator> SnapshotValue::items() const
+{
+    JSON_ASSERT(is_object());
+
+    char const* const first = data() + 8;
+    return {item_iterator(base_, first), item_iterator(base_, first + 16 * Count())};
+}
+
+inline SnapshotValue Snapshot::root() const noexcept
+{
+    if (data_ == nullptr)
+        return {};
+
+    return SnapshotValue(data_, SnapshotValue::Load(data_ + 24));
+}
+
+} // namespace json
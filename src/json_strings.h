@@ -22,11 +22,14 @@
 
 #include "json_charclass.h"
 #include "json_options.h"
+#include "json_simd.h"
 #include "json_unicode.h"
 
 #include <cassert>
 #include <cstdint>
+#include <cstring>
 #include <iterator>
+#include <string>
 #include <type_traits>
 
 namespace json {
@@ -76,6 +79,164 @@ It SkipNonSpecial(It p, It end)
     }
 }
 
+#if JSON_USE_SSE2
+inline char const* SkipNonSpecial(char const* p, char const* end)
+{
+    __m128i const kSpace     = _mm_set1_epi8(0x20);
+    __m128i const kQuote     = _mm_set1_epi8('"');
+    __m128i const kBackslash = _mm_set1_epi8('\\');
+
+    while (end - p >= 16)
+    {
+        __m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+
+        // NB: Signed comparison. Matches control characters and bytes >= 0x80.
+        __m128i m = _mm_cmplt_epi8(v, kSpace);
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(v, kQuote));
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(v, kBackslash));
+
+        auto const mask = static_cast<uint32_t>(_mm_movemask_epi8(m));
+        if (mask != 0)
+            return p + json::simd::CountTrailingZeros32(mask);
+
+        p += 16;
+    }
+
+    return SkipNonSpecial<char const*>(p, end);
+}
+#endif
+
+// Returns whether the character ch might need to be escaped by EscapeString.
+inline bool MightNeedEscaping(char ch)
+{
+    auto const uc = static_cast<unsigned char>(ch);
+
+    return uc < 0x20 || uc >= 0x80 || ch == '"' || ch == '\\' || ch == '/';
+}
+
+// Returns a pointer to the first character in [p, end) which might need to be
+// escaped by EscapeString.
+inline char const* SkipSafeChars(char const* p, char const* end)
+{
+#if JSON_USE_SSE2
+    __m128i const kSpace     = _mm_set1_epi8(0x20);
+    __m128i const kQuote     = _mm_set1_epi8('"');
+    __m128i const kBackslash = _mm_set1_epi8('\\');
+    __m128i const kSlash     = _mm_set1_epi8('/');
+
+    while (end - p >= 16)
+    {
+        __m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+
+        // NB: Signed comparison. Matches control characters and bytes >= 0x80.
+        __m128i m = _mm_cmplt_epi8(v, kSpace);
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(v, kQuote));
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(v, kBackslash));
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(v, kSlash));
+
+        auto const mask = static_cast<uint32_t>(_mm_movemask_epi8(m));
+        if (mask != 0)
+            return p + json::simd::CountTrailingZeros32(mask);
+
+        p += 16;
+    }
+#endif
+
+    while (end - p >= 4)
+    {
+        if (MightNeedEscaping(p[0])) return p + 0;
+        if (MightNeedEscaping(p[1])) return p + 1;
+        if (MightNeedEscaping(p[2])) return p + 2;
+        if (MightNeedEscaping(p[3])) return p + 3;
+        p += 4;
+    }
+
+    for ( ; p != end && !MightNeedEscaping(*p); ++p)
+    {
+    }
+
+    return p;
+}
+
+// Returns a pointer to the first ASCII character in [p, end) which might need
+// to be escaped by EscapeString. Unlike SkipSafeChars, doesn't stop at bytes >= 0x80.
+inline char const* SkipSafeCharsUTF8(char const* p, char const* end)
+{
+#if JSON_USE_SSE2
+    __m128i const kSpace     = _mm_set1_epi8(0x20);
+    __m128i const kMinusOne  = _mm_set1_epi8(-1);
+    __m128i const kQuote     = _mm_set1_epi8('"');
+    __m128i const kBackslash = _mm_set1_epi8('\\');
+    __m128i const kSlash     = _mm_set1_epi8('/');
+
+    while (end - p >= 16)
+    {
+        __m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+
+        // NB: Signed comparisons. Matches control characters only.
+        __m128i m = _mm_and_si128(_mm_cmplt_epi8(v, kSpace), _mm_cmpgt_epi8(v, kMinusOne));
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(v, kQuote));
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(v, kBackslash));
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(v, kSlash));
+
+        auto const mask = static_cast<uint32_t>(_mm_movemask_epi8(m));
+        if (mask != 0)
+            return p + json::simd::CountTrailingZeros32(mask);
+
+        p += 16;
+    }
+#endif
+
+    for ( ; p != end; ++p)
+    {
+        auto const uc = static_cast<unsigned char>(*p);
+        if (uc < 0x80 && MightNeedEscaping(*p))
+            break;
+    }
+
+    return p;
+}
+
+// Returns an iterator to the first '\\' or control character in [p, end).
+template <typename It>
+It SkipUnescapedChars(It p, It end)
+{
+    for ( ; p != end; ++p)
+    {
+        auto const uc = static_cast<unsigned char>(*p);
+        if (uc < 0x20 || uc == '\\')
+            break;
+    }
+
+    return p;
+}
+
+#if JSON_USE_SSE2
+inline char const* SkipUnescapedChars(char const* p, char const* end)
+{
+    __m128i const kSpace     = _mm_set1_epi8(0x20);
+    __m128i const kMinusOne  = _mm_set1_epi8(-1);
+    __m128i const kBackslash = _mm_set1_epi8('\\');
+
+    while (end - p >= 16)
+    {
+        __m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+
+        // NB: Signed comparisons. Matches control characters only.
+        __m128i m = _mm_and_si128(_mm_cmplt_epi8(v, kSpace), _mm_cmpgt_epi8(v, kMinusOne));
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(v, kBackslash));
+
+        auto const mask = static_cast<uint32_t>(_mm_movemask_epi8(m));
+        if (mask != 0)
+            return p + json::simd::CountTrailingZeros32(mask);
+
+        p += 16;
+    }
+
+    return SkipUnescapedChars<char const*>(p, end);
+}
+#endif
+
 //==================================================================================================
 //
 //==================================================================================================
@@ -204,28 +365,266 @@ UnescapeStringResult<It> UnescapeString(It next, It last, /*char quote_char,*/ F
         }
         else // (possibly) the start of a UTF-8 sequence.
         {
-            auto f = next; // The start of the UTF-8 sequence
+            // Validate all characters up to the next escape sequence (or
+            // control character) at once. The run always ends at a sequence
+            // boundary, since UTF-8 sequences never contain ASCII characters.
+            auto const run_end = SkipUnescapedChars(next, last);
+            auto const valid_end = json::unicode::ValidateUTF8(next, run_end);
+
+            // The range [next, valid_end) is already valid UTF-8.
+            for ( ; next != valid_end; ++next)
+            {
+                yield(*next);
+            }
 
-            uint32_t U = 0;
-            next = json::unicode::DecodeUTF8Sequence(next, last, U);
-            JSON_ASSERT(next != f);
+            if (valid_end != run_end)
+            {
+                return {valid_end, UnescapeStringStatus::invalid_utf8_sequence};
+            }
+        }
+    }
 
-            if (U == json::unicode::kInvalidCodepoint)
+    return {next, UnescapeStringStatus::success};
+}
+
+namespace impl {
+
+struct UnescapeToBuffer
+{
+    char* out;
+
+    void Append(char const* first, char const* last)
+    {
+        // NB: memmove. Allows unescaping in place.
+        auto const len = static_cast<size_t>(last - first);
+        std::memmove(out, first, len);
+        out += len;
+    }
+
+    void Put(char ch)
+    {
+        *out++ = ch;
+    }
+};
+
+struct UnescapeToNothing
+{
+    void Append(char const* /*first*/, char const* /*last*/) {}
+    void Put(char /*ch*/) {}
+};
+
+template <typename Output>
+UnescapeStringResult<char const*> UnescapeStringBulk(char const* next, char const* last, Output& output)
+{
+    while (next != last)
+    {
+        // Copy ASCII characters up to the next special character.
+        auto const run_end = SkipNonSpecial(next, last);
+        if (run_end != next)
+        {
+            output.Append(next, run_end);
+
+            next = run_end;
+            if (next == last)
+                break;
+        }
+
+        auto const uc = static_cast<unsigned char>(*next);
+
+        if (uc >= 0x80) // (possibly) the start of a UTF-8 sequence.
+        {
+            // Validate all characters up to the next escape sequence (or
+            // control character) at once. UTF-8 sequences never contain ASCII
+            // characters, so the run always ends at a sequence boundary.
+            auto const utf8_end = SkipUnescapedChars(next, last);
+            auto const valid_end = json::unicode::ValidateUTF8(next, utf8_end);
+
+            output.Append(next, valid_end);
+
+            if (valid_end != utf8_end)
             {
-                return {f, UnescapeStringStatus::invalid_utf8_sequence};
+                return {valid_end, UnescapeStringStatus::invalid_utf8_sequence};
             }
 
-            // The range [f, next) already contains a valid UTF-8 encoding of U.
-            for ( ; f != next; ++f)
+            next = utf8_end;
+            continue;
+        }
+
+        if (uc < 0x20) // unescaped control character
+        {
+            return {next, UnescapeStringStatus::unescaped_control_character};
+        }
+
+        if (uc == '"')
+        {
+            output.Put('"');
+            ++next;
+            continue;
+        }
+
+        JSON_ASSERT(uc == '\\');
+
+        auto const f = next; // The start of the UCN sequence
+
+        ++next; // skip '\'
+        if (next == last)
+        {
+            return {next, UnescapeStringStatus::incomplete};
+        }
+
+        switch (*next)
+        {
+        case '"':
+        case '\\':
+        case '/':
+            output.Put(*next);
+            break;
+        case 'b':
+            output.Put('\b');
+            break;
+        case 'f':
+            output.Put('\f');
+            break;
+        case 'n':
+            output.Put('\n');
+            break;
+        case 'r':
+            output.Put('\r');
+            break;
+        case 't':
+            output.Put('\t');
+            break;
+        case 'u':
             {
-                yield(*f);
+                if (++next == last)
+                {
+                    return {f, UnescapeStringStatus::incomplete};
+                }
+
+                // Decodes surrogate pairs, too.
+                uint32_t U = 0;
+                next = json::unicode::DecodeTrimmedUCNSequence(next, last, U);
+
+                if (U == json::unicode::kInvalidCodepoint)
+                {
+                    return {f, UnescapeStringStatus::invalid_utf8_sequence};
+                }
+
+                json::unicode::EncodeUTF8(U, [&](uint8_t code_unit) { output.Put(static_cast<char>(code_unit)); });
             }
+            continue; // next already points past the UCN sequence
+        default:
+            return {next, UnescapeStringStatus::invalid_escaped_character}; // invalid escaped character
         }
+
+        ++next;
     }
 
     return {next, UnescapeStringStatus::success};
 }
 
+} // namespace impl
+
+// Same as UnescapeString, but writes the unescaped string into the buffer
+// starting at out, and advances out past the last character written.
+// Runs of characters which don't need to be unescaped are copied in bulk.
+//
+// PRE: out points to a buffer of at least (last - next) characters.
+//      (The unescaped string is never longer than the escaped string.)
+//      The buffer may be [next, last) itself, i.e. the string may be unescaped
+//      in place.
+inline UnescapeStringResult<char const*> UnescapeStringBulk(char const* next, char const* last, char*& out)
+{
+    impl::UnescapeToBuffer output{out};
+    auto const res = impl::UnescapeStringBulk(next, last, output);
+    out = output.out;
+    return res;
+}
+
+// Appends the unescaped string [next, last) to buf, which may be a std::string
+// or a std::vector<char>.
+// On error, buf holds the characters which have been unescaped so far.
+template <typename Buffer>
+UnescapeStringResult<char const*> AppendUnescapedString(Buffer& buf, char const* next, char const* last)
+{
+    size_t const offset = buf.size();
+    if (next == last)
+        return {next, UnescapeStringStatus::success};
+
+    buf.resize(offset + static_cast<size_t>(last - next));
+
+    char* const first = &buf[0];
+    char* out = first + offset;
+    auto const res = UnescapeStringBulk(next, last, out);
+
+    buf.resize(static_cast<size_t>(out - first));
+    return res;
+}
+
+// Unescapes the string [next, last) into str, replacing its contents.
+inline UnescapeStringResult<char const*> UnescapeStringBulk(std::string& str, char const* next, char const* last)
+{
+    str.clear();
+    return AppendUnescapedString(str, next, last);
+}
+
+// Checks whether [next, last) is a valid JSON string (without the enclosing
+// quotes), without actually unescaping the string.
+// Returns the same status (and position) as UnescapeString.
+inline UnescapeStringResult<char const*> ValidateString(char const* next, char const* last)
+{
+    impl::UnescapeToNothing output;
+    return impl::UnescapeStringBulk(next, last, output);
+}
+
+// Writes the escape sequence "\\uXXXX" for the UTF-16 code unit W to p.
+// Returns a pointer past the last character written.
+inline char* WriteUCN(char* p, uint32_t W)
+{
+    JSON_ASSERT(W <= 0xFFFF);
+
+    static constexpr char const kHexPairs[] =
+    "000102030405060708090A0B0C0D0E0F"
+    "101112131415161718191A1B1C1D1E1F"
+    "202122232425262728292A2B2C2D2E2F"
+    "303132333435363738393A3B3C3D3E3F"
+    "404142434445464748494A4B4C4D4E4F"
+    "505152535455565758595A5B5C5D5E5F"
+    "606162636465666768696A6B6C6D6E6F"
+    "707172737475767778797A7B7C7D7E7F"
+    "808182838485868788898A8B8C8D8E8F"
+    "909192939495969798999A9B9C9D9E9F"
+    "A0A1A2A3A4A5A6A7A8A9AAABACADAEAF"
+    "B0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+    "C0C1C2C3C4C5C6C7C8C9CACBCCCDCECF"
+    "D0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+    "E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEF"
+    "F0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+
+    p[0] = '\\';
+    p[1] = 'u';
+    std::memcpy(p + 2, &kHexPairs[2 * (W >> 8)], 2);
+    std::memcpy(p + 4, &kHexPairs[2 * (W & 0xFF)], 2);
+    return p + 6;
+}
+
+// Writes the escape sequence(s) for the code point U to p, using a surrogate
+// pair if U is outside the BMP.
+// Returns a pointer past the last character written (at most 12 characters).
+inline char* WriteUCNSequence(char* p, uint32_t U)
+{
+    JSON_ASSERT(json::unicode::IsValidCodepoint(U));
+
+    if (U < 0x10000)
+        return WriteUCN(p, U);
+
+    uint32_t const Up = U - 0x10000;
+
+    p = WriteUCN(p, 0xD800 + ((Up >> 10) & 0x3FF));
+    p = WriteUCN(p, 0xDC00 + ((Up      ) & 0x3FF));
+    return p;
+}
+
 enum class EscapeStringStatus {
     success,
     invalid_utf8_sequence,
@@ -238,8 +637,9 @@ struct EscapeStringResult
     EscapeStringStatus status;
 };
 
+// If ascii_only is true, all non-ASCII characters are escaped, too.
 template <typename It, typename Fn>
-EscapeStringResult<It> EscapeString(It next, It last, Fn yield)
+EscapeStringResult<It> EscapeString(It next, It last, Fn yield, bool ascii_only = false)
 {
     static constexpr char const kHexDigits[] = "0123456789ABCDEF";
 
@@ -314,6 +714,17 @@ EscapeStringResult<It> EscapeString(It next, It last, Fn yield)
                 return {next, EscapeStringStatus::invalid_utf8_sequence};
             }
 
+            if (ascii_only)
+            {
+                char buf[12];
+                char* const end = WriteUCNSequence(buf, U);
+                for (char* p = buf; p != end; ++p)
+                {
+                    yield(*p);
+                }
+                continue;
+            }
+
             //
             // Always escape U+2028 (LINE SEPARATOR) and U+2029 (PARAGRAPH
             // SEPARATOR). No string in JavaScript can contain a literal
@@ -353,5 +764,147 @@ EscapeStringResult<It> EscapeString(It next, It last, Fn yield)
     return {next, EscapeStringStatus::success};
 }
 
+// Same as EscapeString, but instead of emitting the escaped string one
+// character at a time, calls append(first, last) for each run of characters.
+// Runs of characters which don't need to be escaped are passed through
+// without being copied.
+template <typename Append>
+EscapeStringResult<char const*> EscapeStringBulk(char const* next, char const* last, Append append, bool ascii_only = false)
+{
+    static constexpr char const kHexDigits[] = "0123456789ABCDEF";
+
+    char ch_prev = '\0';
+
+    while (next != last)
+    {
+        auto const run_end = SkipSafeChars(next, last);
+        if (run_end != next)
+        {
+            append(next, run_end);
+            ch_prev = run_end[-1];
+            next = run_end;
+            if (next == last)
+                break;
+        }
+
+        char const ch = *next;
+        auto const uc = static_cast<unsigned char>(ch);
+
+        if (uc < 0x20) // (ASCII) control character
+        {
+            char buf[6] = {'\\', 'u', '0', '0', kHexDigits[uc >> 4], kHexDigits[uc & 0xF]};
+            switch (ch)
+            {
+            case '\b':
+                buf[1] = 'b';
+                append(buf, buf + 2);
+                break;
+            case '\f':
+                buf[1] = 'f';
+                append(buf, buf + 2);
+                break;
+            case '\n':
+                buf[1] = 'n';
+                append(buf, buf + 2);
+                break;
+            case '\r':
+                buf[1] = 'r';
+                append(buf, buf + 2);
+                break;
+            case '\t':
+                buf[1] = 't';
+                append(buf, buf + 2);
+                break;
+            default:
+                append(buf, buf + 6);
+                break;
+            }
+            ++next;
+        }
+        else if (uc < 0x80) // '"', '\\' or '/'
+        {
+            if (ch == '/' && ch_prev != '<')
+            {
+                append(next, next + 1);
+            }
+            else
+            {
+                char const buf[2] = {'\\', ch};
+                append(buf, buf + 2);
+            }
+            ++next;
+        }
+        else if (ascii_only) // (possibly) the start of a UTF-8 sequence.
+        {
+            // Escape all consecutive non-ASCII characters into a local buffer.
+            char buf[120];
+            char* p = buf;
+
+            do
+            {
+                uint32_t U = 0;
+                next = json::unicode::DecodeUTF8Sequence(next, last, U);
+
+                if (U == json::unicode::kInvalidCodepoint)
+                {
+                    append(buf, p);
+                    return {next, EscapeStringStatus::invalid_utf8_sequence};
+                }
+
+                p = WriteUCNSequence(p, U);
+            }
+            while (next != last && static_cast<unsigned char>(*next) >= 0x80 && (buf + sizeof(buf)) - p >= 12);
+
+            append(buf, p);
+            ch_prev = '\0';
+            continue;
+        }
+        else // (possibly) the start of a UTF-8 sequence.
+        {
+            // Validate the whole run of (non-ASCII or safe) characters at once.
+            auto const utf8_end = SkipSafeCharsUTF8(next, last);
+            auto const valid_end = json::unicode::ValidateUTF8(next, utf8_end);
+
+            // Always escape U+2028 (LINE SEPARATOR) and U+2029 (PARAGRAPH
+            // SEPARATOR). See EscapeString.
+            // Both are encoded as E2 80 A8 and E2 80 A9, resp.
+            for (auto p = next; p != valid_end; )
+            {
+                p = static_cast<char const*>(std::memchr(p, 0xE2, static_cast<size_t>(valid_end - p)));
+                if (p == nullptr)
+                    break;
+
+                // The UTF-8 sequence is valid, so p[1] and p[2] exist.
+                if (p[1] == '\x80' && (p[2] == '\xA8' || p[2] == '\xA9'))
+                {
+                    char const* const escaped = (p[2] == '\xA8') ? "\\u2028" : "\\u2029";
+                    append(next, p);
+                    append(escaped, escaped + 6);
+                    next = p + 3;
+                }
+
+                p += 3;
+            }
+
+            // The remaining UTF-8 sequences are valid. No need to re-encode.
+            append(next, valid_end);
+
+            if (valid_end != utf8_end)
+            {
+                uint32_t U = 0;
+                return {json::unicode::DecodeUTF8Sequence(valid_end, last, U), EscapeStringStatus::invalid_utf8_sequence};
+            }
+
+            ch_prev = valid_end[-1];
+            next = valid_end;
+            continue;
+        }
+
+        ch_prev = ch;
+    }
+
+    return {next, EscapeStringStatus::success};
+}
+
 } // namespace strings
 } // namespace json
@@ -0,0 +1,438 @@
+// Copyright 2018 Alexander Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "json_tape.h"
+#include "json_numbers.h"
+#include "json_strings.h"
+
+using namespace json;
+
+//==================================================================================================
+// TapeValue
+//==================================================================================================
+
+size_t TapeValue::size() const noexcept
+{
+    JSON_ASSERT(is_string() || is_array() || is_object());
+
+    if (is_string())
+        return string_size();
+
+    size_t const count = static_cast<size_t>(payload() >> 40);
+    if (count < kMaxCount)
+        return count;
+
+    // The count is saturated. Count the elements resp. members.
+    size_t n = 0;
+    if (is_array())
+    {
+        for (auto it = elements().begin(), end = elements().end(); it != end; ++it)
+            ++n;
+    }
+    else
+    {
+        for (auto it = items().begin(), end = items().end(); it != end; ++it)
+            ++n;
+    }
+
+    return n;
+}
+
+TapeValue TapeValue::operator[](size_t index) const noexcept
+{
+    JSON_ASSERT(is_array());
+
+    for (auto const v : elements())
+    {
+        if (index == 0)
+            return v;
+        --index;
+    }
+
+    return {};
+}
+
+TapeValue TapeValue::find(char const* key, size_t length) const noexcept
+{
+    if (!is_object())
+        return {};
+
+    TapeValue result;
+    for (auto const m : items())
+    {
+        if (m.key.string_size() == length && std::memcmp(m.key.string_data(), key, length) == 0)
+            result = m.value;
+    }
+
+    return result;
+}
+
+Value TapeValue::to_value() const
+{
+    switch (type())
+    {
+    case Type::undefined:
+        return {};
+    case Type::null:
+        return nullptr;
+    case Type::boolean:
+        return get_boolean();
+    case Type::number:
+        return get_number();
+    case Type::string:
+        return get_string();
+    case Type::array:
+        {
+            Value arr(json::array_tag);
+            for (auto const v : elements())
+                arr.get_array().push_back(v.to_value());
+            return arr;
+        }
+    case Type::object:
+        {
+            Value obj(json::object_tag);
+            for (auto const m : items())
+                obj.get_object()[m.key.get_string()] = m.value.to_value();
+            return obj;
+        }
+    }
+
+    return {};
+}
+
+//==================================================================================================
+// parse
+//==================================================================================================
+
+struct json::TapeCallbacks final : ParseCallbacks
+{
+    static constexpr uint64_t kMaxCount = 0xFFFF;
+    // The maximum size of the key table. Documents with more distinct keys are
+    // rare, and a larger table would mostly produce cache misses.
+    static constexpr size_t kMaxKeySlots = size_t{1} << 16;
+
+    Tape& tape;
+    std::vector<size_t> open; // Positions of the '[' and '{' words
+
+    // The interned keys: an open-addressing hash table.
+    struct KeySlot
+    {
+        uint64_t offset; // The offset of the key in the string buffer + 1, or 0 if the slot is empty
+        size_t next;     // The slot of the key which followed this key the last time (+ 1), or 0
+    };
+
+    std::vector<KeySlot> keys;
+    size_t num_keys = 0;
+    size_t prev_key = 0; // The slot of the previous key (+ 1), or 0
+    size_t num_misses = 0; // The number of keys not found in the full table
+
+    TapeCallbacks(Tape& tape_, size_t input_size) : tape(tape_)
+    {
+        tape.clear();
+
+        // Initial guesses only, which avoid most reallocations without reserving
+        // much more memory than the size of the input. There is no tight bound:
+        // each number takes two words (so e.g. [1,1,1,...] needs one word per
+        // byte of input), and each string takes its length plus 5 bytes in the
+        // string buffer. Both buffers grow as needed.
+        tape.words_.reserve(input_size / 16 + 16);
+        tape.strings_.reserve(input_size / 2);
+    }
+
+    void Push(char tag, uint64_t payload)
+    {
+        tape.words_.push_back((uint64_t{static_cast<unsigned char>(tag)} << 56) | payload);
+    }
+
+    // Appends the string [first, last) to the string buffer.
+    bool AppendString(char const* first, char const* last, bool needs_cleaning)
+    {
+        if (static_cast<size_t>(last - first) > UINT32_MAX)
+            return false;
+
+        auto& buf = tape.strings_;
+        size_t const offset = buf.size();
+
+        buf.resize(offset + 4);
+        if (needs_cleaning)
+        {
+            auto const res = strings::AppendUnescapedString(buf, first, last);
+            if (res.status != strings::UnescapeStringStatus::success)
+                return false;
+        }
+        else
+        {
+            buf.insert(buf.end(), first, last);
+        }
+
+        uint32_t const unescaped_length = static_cast<uint32_t>(buf.size() - (offset + 4));
+        std::memcpy(buf.data() + offset, &unescaped_length, sizeof(uint32_t));
+        buf.push_back('\0');
+
+        return true;
+    }
+
+    ParseStatus PushString(char const* first, char const* last, bool needs_cleaning)
+    {
+        size_t const offset = tape.strings_.size();
+        if (!AppendString(first, last, needs_cleaning))
+            return ParseStatus::invalid_string;
+
+        Push('s', offset);
+        return {};
+    }
+
+    static uint64_t HashKey(char const* key, size_t length)
+    {
+        static constexpr uint64_t kMul = 0x9E3779B97F4A7C15u;
+
+        uint64_t h = length * kMul;
+        for ( ; length >= 8; key += 8, length -= 8)
+        {
+            uint64_t w;
+            std::memcpy(&w, key, 8);
+            h = (h ^ w) * kMul;
+            h ^= h >> 29;
+        }
+        if (length > 0)
+        {
+            uint64_t w = 0;
+            std::memcpy(&w, key, length);
+            h = (h ^ w) * kMul;
+            h ^= h >> 29;
+        }
+        return h;
+    }
+
+    char const* KeyData(uint64_t offset) const { return tape.strings_.data() + offset + 4; }
+
+    uint32_t KeyLength(uint64_t offset) const
+    {
+        uint32_t length;
+        std::memcpy(&length, tape.strings_.data() + offset, sizeof(uint32_t));
+        return length;
+    }
+
+    bool KeyEquals(size_t slot, char const* key, size_t length) const
+    {
+        uint64_t const offset = keys[slot].offset - 1;
+        return KeyLength(offset) == length && std::memcmp(KeyData(offset), key, length) == 0;
+    }
+
+    void GrowKeys()
+    {
+        std::vector<KeySlot> old_keys(keys.empty() ? 64 : 2 * keys.size());
+        old_keys.swap(keys);
+
+        // (The successors are not rehashed, but just forgotten.)
+        prev_key = 0;
+
+        size_t const mask = keys.size() - 1;
+        for (auto const& k : old_keys)
+        {
+            if (k.offset == 0)
+                continue;
+
+            size_t slot = static_cast<size_t>(HashKey(KeyData(k.offset - 1), KeyLength(k.offset - 1))) & mask;
+            while (keys[slot].offset != 0)
+                slot = (slot + 1) & mask;
+            keys[slot].offset = k.offset;
+        }
+    }
+
+    // Stores each distinct key only once per tape. Equal keys share the same
+    // offset into the string buffer.
+    ParseStatus PushKey(char const* first, char const* last, bool needs_cleaning)
+    {
+        // Once the table is full and mostly misses, the keys are likely all
+        // distinct and looking them up is not worth the time.
+        if (num_misses > num_keys)
+            return PushString(first, last, needs_cleaning);
+
+        if (2 * (num_keys + 1) > keys.size() && keys.size() < kMaxKeySlots)
+            GrowKeys();
+
+        size_t const offset = tape.strings_.size();
+
+        // Escaped keys are unescaped into the string buffer first. The copy is
+        // dropped below if the key has been seen before.
+        char const* key = first;
+        size_t length = static_cast<size_t>(last - first);
+        if (needs_cleaning)
+        {
+            if (!AppendString(first, last, needs_cleaning))
+                return ParseStatus::invalid_string;
+
+            key = KeyData(offset);
+            length = KeyLength(offset);
+        }
+
+        // Objects in an array often have the same keys in the same order. So
+        // first try the key which followed the previous key the last time.
+        size_t slot = prev_key != 0 ? keys[prev_key - 1].next : 0;
+        if (slot != 0 && KeyEquals(slot - 1, key, length))
+        {
+            --slot;
+        }
+        else
+        {
+            size_t const mask = keys.size() - 1;
+            slot = static_cast<size_t>(HashKey(key, length)) & mask;
+            while (keys[slot].offset != 0 && !KeyEquals(slot, key, length))
+                slot = (slot + 1) & mask;
+
+            if (keys[slot].offset == 0)
+            {
+                if (!needs_cleaning && !AppendString(first, last, needs_cleaning))
+                    return ParseStatus::invalid_string;
+
+                // If the table is full, the key is stored, but not interned.
+                if (2 * (num_keys + 1) > keys.size())
+                {
+                    ++num_misses;
+                    Push('s', offset);
+                    return {};
+                }
+
+                keys[slot].offset = offset + 1;
+                ++num_keys;
+            }
+
+            if (prev_key != 0)
+                keys[prev_key - 1].next = slot + 1;
+        }
+
+        uint64_t const key_offset = keys[slot].offset - 1;
+        if (needs_cleaning && key_offset != offset)
+            tape.strings_.resize(offset);
+
+        prev_key = slot + 1;
+
+        Push('s', key_offset);
+        return {};
+    }
+
+    void PushEnd(char tag, size_t count)
+    {
+        JSON_ASSERT(!open.empty());
+
+        size_t const start = open.back();
+        open.pop_back();
+
+        Push(tag, start);
+
+        uint64_t const payload = (uint64_t{count < kMaxCount ? count : kMaxCount} << 40) | tape.words_.size();
+        tape.words_[start] |= payload;
+    }
+
+    ParseStatus HandleNull(Options const& /*options*/) override
+    {
+        Push('n', 0);
+        return {};
+    }
+
+    ParseStatus HandleBoolean(bool value, Options const& /*options*/) override
+    {
+        Push(value ? 't' : 'f', 0);
+        return {};
+    }
+
+    ParseStatus HandleNumber(char const* first, char const* last, NumberClass nc, Options const& options) override
+    {
+        if (options.parse_numbers_as_strings)
+            return PushString(first, last, /*needs_cleaning*/ false);
+
+        double const value = options.parse_numbers_as_float
+            ? numbers::StringToFloatNumber(first, last, nc)
+            : numbers::StringToNumber(first, last, nc);
+
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(double));
+
+        Push('d', 0);
+        tape.words_.push_back(bits);
+        return {};
+    }
+
+    ParseStatus HandleString(char const* first, char const* last, bool needs_cleaning, Options const& /*options*/) override
+    {
+        return PushString(first, last, needs_cleaning);
+    }
+
+    ParseStatus HandleBeginArray(Options const& /*options*/) override
+    {
+        open.push_back(tape.words_.size());
+        Push('[', 0);
+        return {};
+    }
+
+    ParseStatus HandleEndArray(size_t count, Options const& /*options*/) override
+    {
+        PushEnd(']', count);
+        return {};
+    }
+
+    ParseStatus HandleEndElement(size_t& /*count*/, Options const& /*options*/) override
+    {
+        return {};
+    }
+
+    ParseStatus HandleBeginObject(Options const& /*options*/) override
+    {
+        open.push_back(tape.words_.size());
+        Push('{', 0);
+        return {};
+    }
+
+    ParseStatus HandleEndObject(size_t count, Options const& /*options*/) override
+    {
+        PushEnd('}', count);
+        return {};
+    }
+
+    ParseStatus HandleEndMember(size_t& /*count*/, Options const& /*options*/) override
+    {
+        return {};
+    }
+
+    ParseStatus HandleKey(char const* first, char const* last, bool needs_cleaning, Options const& /*options*/) override
+    {
+        return PushKey(first, last, needs_cleaning);
+    }
+};
+
+ParseResult json::parse(Tape& tape, char const* next, char const* last, Options const& options)
+{
+    TapeCallbacks cb(tape, static_cast<size_t>(last - next));
+
+    auto const res = json::parse(cb, next, last, options);
+    if (res.ec != ParseStatus::success)
+        tape.clear();
+
+    return res;
+}
+
+ParseStatus json::parse(Tape& tape, std::string const& str, Options const& options)
+{
+    char const* next = str.data();
+    char const* last = str.data() + str.size();
+
+    return json::parse(tape, next, last, options).ec;
+}
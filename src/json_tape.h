@@ -0,0 +1,355 @@
+// Copyright 2018 Alexander Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "json.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace json {
+
+class TapeValue;
+struct TapeCallbacks;
+
+//==================================================================================================
+// Tape
+//==================================================================================================
+
+// A read-only JSON document, stored as a single array of 64-bit words (the
+// tape), plus a buffer which holds the strings.
+//
+// The values are stored in document order. Each value starts with a word which
+// holds a tag in the upper 8 bits and a payload in the lower 56 bits:
+//
+//      'n' 't' 'f'     null, true, false
+//      'd'             a number. The next word holds the bits of the double.
+//      's'             a string. The payload is the offset into the string
+//                      buffer, where the length (4 bytes), the characters, and
+//                      a '\0' are stored.
+//      '[' '{'         an array resp. object. The payload holds the number of
+//                      elements resp. members in the upper 16 bits (saturated),
+//                      and the index of the word after the matching ']' resp.
+//                      '}' in the lower 40 bits (the skip link).
+//      ']' '}'         the end of an array resp. object. The payload is the
+//                      index of the matching '[' resp. '{'.
+//
+// Object members are stored as a key ('s') followed by the value. Keys are
+// interned: each distinct key is stored only once per tape, and equal keys
+// refer to the same offset (see TapeValue::is_same_string). Only the first
+// 32768 distinct keys of a document are interned, all other keys are stored
+// for each member (and once most keys miss the full table, keys are no longer
+// looked up at all).
+//
+// Thanks to the skip links, moving to the next element or member is O(1).
+class Tape final
+{
+    friend class TapeValue;
+    friend struct TapeCallbacks;
+
+    std::vector<uint64_t> words_;
+    std::vector<char> strings_;
+
+public:
+    // Returns the root value, or an undefined value if the tape is empty.
+    TapeValue root() const noexcept;
+
+    // Removes the document, but keeps the allocated memory. Parsing into a
+    // cleared tape does not allocate unless the new document is larger.
+    void clear() noexcept
+    {
+        words_.clear();
+        strings_.clear();
+    }
+};
+
+//==================================================================================================
+// TapeValue
+//==================================================================================================
+
+// A reference to a value stored in a Tape.
+// Provides (mostly) the same read API as Value.
+//
+// NB: Unlike Value, objects are iterated in document order, and member lookup
+// is a linear search. If a key occurs more than once, the last member wins (as
+// in Value).
+class TapeValue final
+{
+    friend class Tape;
+
+    static constexpr uint64_t kPayloadMask = (uint64_t{1} << 56) - 1;
+    static constexpr uint64_t kLinkMask    = (uint64_t{1} << 40) - 1;
+    static constexpr uint64_t kMaxCount    = 0xFFFF;
+
+    Tape const* tape_ = nullptr;
+    size_t pos_ = 0;
+
+    TapeValue(Tape const* tape, size_t pos) : tape_(tape), pos_(pos) {}
+
+    uint64_t word() const noexcept { return tape_->words_[pos_]; }
+    char tag() const noexcept { return tape_ != nullptr ? static_cast<char>(word() >> 56) : '\0'; }
+    uint64_t payload() const noexcept { return word() & kPayloadMask; }
+
+    // Returns the index of the word after this value.
+    size_t next() const noexcept
+    {
+        switch (tag())
+        {
+        case '[':
+        case '{':
+            return static_cast<size_t>(payload() & kLinkMask);
+        case 'd':
+            return pos_ + 2;
+        default:
+            return pos_ + 1;
+        }
+    }
+
+public:
+    // Creates an undefined value.
+    TapeValue() = default;
+
+    Type type() const noexcept
+    {
+        switch (tag())
+        {
+        case 'n':
+            return Type::null;
+        case 't':
+        case 'f':
+            return Type::boolean;
+        case 'd':
+            return Type::number;
+        case 's':
+            return Type::string;
+        case '[':
+            return Type::array;
+        case '{':
+            return Type::object;
+        default:
+            return Type::undefined;
+        }
+    }
+
+    bool is_undefined()  const noexcept { return type() == Type::undefined; }
+    bool is_null()       const noexcept { return type() == Type::null;      }
+    bool is_boolean()    const noexcept { return type() == Type::boolean;   }
+    bool is_number()     const noexcept { return type() == Type::number;    }
+    bool is_string()     const noexcept { return type() == Type::string;    }
+    bool is_array()      const noexcept { return type() == Type::array;     }
+    bool is_object()     const noexcept { return type() == Type::object;    }
+    bool is_primitive()  const noexcept { return Type::null <= type() && type() <= Type::string; }
+    bool is_structured() const noexcept { return is_array() || is_object(); }
+
+    bool is(Type t) const noexcept { return type() == t; }
+
+    // PRE: is_boolean()
+    bool get_boolean() const noexcept
+    {
+        JSON_ASSERT(is_boolean());
+        return tag() == 't';
+    }
+
+    // PRE: is_number()
+    double get_number() const noexcept
+    {
+        JSON_ASSERT(is_number());
+
+        uint64_t const bits = tape_->words_[pos_ + 1];
+        double value;
+        std::memcpy(&value, &bits, sizeof(double));
+        return value;
+    }
+
+    // Returns the (null-terminated) characters of the string.
+    // PRE: is_string()
+    char const* string_data() const noexcept
+    {
+        JSON_ASSERT(is_string());
+        return tape_->strings_.data() + payload() + 4;
+    }
+
+    // PRE: is_string()
+    size_t string_size() const noexcept
+    {
+        JSON_ASSERT(is_string());
+
+        uint32_t length;
+        std::memcpy(&length, tape_->strings_.data() + payload(), sizeof(uint32_t));
+        return length;
+    }
+
+    // PRE: is_string()
+    String get_string() const { return String(string_data(), string_size()); }
+
+    // Returns whether this value and OTHER refer to the same string of the same
+    // tape. Since keys are interned, two keys of a tape are equal iff they are
+    // the same string, i.e. keys can be compared without comparing characters
+    // (unless the document has more than 32768 distinct keys, see Tape).
+    // PRE: is_string() and other.is_string()
+    bool is_same_string(TapeValue const& other) const noexcept
+    {
+        JSON_ASSERT(is_string());
+        JSON_ASSERT(other.is_string());
+        return tape_ == other.tape_ && payload() == other.payload();
+    }
+
+    // Returns the length of a string, or the number of elements resp. members
+    // of an array resp. object.
+    // PRE: is_string() or is_array() or is_object()
+    size_t size() const noexcept;
+
+    // PRE: is_string() or is_array() or is_object()
+    bool empty() const noexcept { return size() == 0; }
+
+    // Returns the element at INDEX, or an undefined value if INDEX is out of
+    // bounds. This is O(INDEX).
+    // PRE: is_array()
+    TapeValue operator[](size_t index) const noexcept;
+
+    // Returns the value of the member KEY, or an undefined value if this value
+    // is not an object or if no such member exists.
+    TapeValue find(char const* key, size_t length) const noexcept;
+
+    // (A template, so that v[0] selects the array overload.)
+    template <typename T, std::enable_if_t<std::is_convertible<T, char const*>::value, int> = 0>
+    TapeValue operator[](T key) const noexcept { return find(key, std::strlen(key)); }
+    TapeValue operator[](String const& key) const noexcept { return find(key.data(), key.size()); }
+
+    bool has_member(char const* key) const noexcept { return !(*this)[key].is_undefined(); }
+    bool has_member(String const& key) const noexcept { return !(*this)[key].is_undefined(); }
+
+    // Converts this value into a Value.
+    Value to_value() const;
+
+    //--------------------------------------------------------------------------
+    // Iteration
+    //
+
+    class element_iterator;
+    class item_iterator;
+    struct Member;
+
+    template <typename It>
+    struct ItRange {
+        It begin_;
+        It end_;
+        It begin() const { return begin_; }
+        It end() const { return end_; }
+    };
+
+    // PRE: is_array()
+    ItRange<element_iterator> elements() const;
+
+    // PRE: is_object()
+    ItRange<item_iterator> items() const;
+};
+
+class TapeValue::element_iterator
+{
+    Tape const* tape_ = nullptr;
+    size_t pos_ = 0;
+
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = TapeValue;
+    using reference         = TapeValue;
+    using pointer           = void;
+    using difference_type   = std::ptrdiff_t;
+
+    element_iterator() = default;
+    element_iterator(Tape const* tape, size_t pos) : tape_(tape), pos_(pos) {}
+
+    reference operator*() const { return TapeValue(tape_, pos_); }
+    element_iterator& operator++() { pos_ = TapeValue(tape_, pos_).next(); return *this; }
+    element_iterator operator++(int) { auto I = *this; ++*this; return I; }
+
+    friend bool operator==(element_iterator lhs, element_iterator rhs) { return lhs.pos_ == rhs.pos_; }
+    friend bool operator!=(element_iterator lhs, element_iterator rhs) { return lhs.pos_ != rhs.pos_; }
+};
+
+struct TapeValue::Member
+{
+    TapeValue key; // A string
+    TapeValue value;
+};
+
+class TapeValue::item_iterator
+{
+    Tape const* tape_ = nullptr;
+    size_t pos_ = 0; // Position of the key
+
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = Member;
+    using reference         = Member;
+    using pointer           = void;
+    using difference_type   = std::ptrdiff_t;
+
+    item_iterator() = default;
+    item_iterator(Tape const* tape, size_t pos) : tape_(tape), pos_(pos) {}
+
+    reference operator*() const { return {TapeValue(tape_, pos_), TapeValue(tape_, pos_ + 1)}; }
+    item_iterator& operator++() { pos_ = TapeValue(tape_, pos_ + 1).next(); return *this; }
+    item_iterator operator++(int) { auto I = *this; ++*this; return I; }
+
+    friend bool operator==(item_iterator lhs, item_iterator rhs) { return lhs.pos_ == rhs.pos_; }
+    friend bool operator!=(item_iterator lhs, item_iterator rhs) { return lhs.pos_ != rhs.pos_; }
+};
+
+inline TapeValue::ItRange<TapeValue::element_iterator> TapeValue::elements() const
+{
+    JSON_ASSERT(is_array());
+    return {element_iterator(tape_, pos_ + 1), element_iterator(tape_, next() - 1)};
+}
+
+inline TapeValue::ItRange<TapeValue::item_iterator> TapeValue::items() const
+{
+    JSON_ASSERT(is_object());
+    return {item_iterator(tape_, pos_ + 1), item_iterator(tape_, next() - 1)};
+}
+
+inline TapeValue Tape::root() const noexcept
+{
+    if (words_.empty())
+        return {};
+
+    return TapeValue(this, 0);
+}
+
+//==================================================================================================
+// parse
+//==================================================================================================
+
+// Parse the JSON stored in [NEXT, LAST) into TAPE.
+// Options::lazy_string_unescaping is ignored.
+// On error, TAPE is empty.
+ParseResult parse(Tape& tape, char const* next, char const* last, Options const& options = {});
+
+// Parse the JSON stored in STR into TAPE.
+ParseStatus parse(Tape& tape, std::string const& str, Options const& options = {});
+
+} // namespace json
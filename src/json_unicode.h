@@ -22,9 +22,11 @@
 
 #include "json_charclass.h"
 #include "json_options.h"
+#include "json_simd.h"
 
 #include <cassert>
 #include <cstdint>
+#include <cstring>
 #include <iterator>
 
 #ifndef JSON_ASSERT
@@ -134,6 +136,237 @@ It DecodeUTF8Sequence(It next, It last, uint32_t& U)
     return next;
 }
 
+// Returns a pointer to the start of the first invalid UTF-8 sequence in
+// [next, last), or last if the range contains only valid UTF-8 sequences.
+template <typename It>
+It ValidateUTF8(It next, It last)
+{
+    while (next != last)
+    {
+        if (static_cast<unsigned char>(*next) < 0x80)
+        {
+            ++next;
+            continue;
+        }
+
+        uint32_t U = 0;
+        auto const end = DecodeUTF8Sequence(next, last, U);
+        if (U == kInvalidCodepoint)
+            return next;
+
+        next = end;
+    }
+
+    return next;
+}
+
+#if JSON_USE_SSSE3
+//
+// Vectorized UTF-8 validation.
+//
+// Uses the lookup-table algorithm by Keiser and Lemire: Each pair of adjacent
+// bytes is classified by looking up the high nibble of the first byte, the low
+// nibble of the first byte and the high nibble of the second byte in three
+// tables. Each table entry is a set of error classes the pair might belong to
+// and a pair is invalid iff the intersection of the three sets is non-empty.
+// Missing or superfluous 3rd and 4th continuation bytes are detected separately.
+//
+// See:
+// J. Keiser, D. Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte"
+//
+
+namespace utf8_lookup {
+
+constexpr char kTooShort     = 1 << 0; // 11______ 0_______ or 11______ 11______
+constexpr char kTooLong      = 1 << 1; // 0_______ 10______
+constexpr char kOverlong3    = 1 << 2; // 11100000 100_____
+constexpr char kTooLarge     = 1 << 3; // 11110100 1001____, 11110100 101_____, 11110101 10______, 1111011_ 10______, 11111___ 10______
+constexpr char kSurrogate    = 1 << 4; // 11101101 101_____
+constexpr char kOverlong2    = 1 << 5; // 1100000_ 10______
+constexpr char kTooLarge1000 = 1 << 6; // 11110101 1000____, 1111011_ 1000____, 11111___ 1000____
+constexpr char kOverlong4    = 1 << 6; // 11110000 1000____
+constexpr char kTwoConts     = static_cast<char>(1 << 7); // 10______ 10______
+constexpr char kCarry        = kTooShort | kTooLong | kTwoConts;
+
+// Returns the error classes of the byte pairs (prev1[i], input[i]) in the high
+// bit of each byte.
+inline __m128i CheckSpecialCases(__m128i input, __m128i prev1)
+{
+    __m128i const kNibbleMask = _mm_set1_epi8(0x0F);
+
+    __m128i const kByte1High = _mm_setr_epi8(
+        // 0_______ ________ <ASCII in byte 1>
+        kTooLong, kTooLong, kTooLong, kTooLong,
+        kTooLong, kTooLong, kTooLong, kTooLong,
+        // 10______ ________ <continuation in byte 1>
+        kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+        // 1100____ ________ <two byte lead in byte 1>
+        kTooShort | kOverlong2,
+        // 1101____ ________ <two byte lead in byte 1>
+        kTooShort,
+        // 1110____ ________ <three byte lead in byte 1>
+        kTooShort | kOverlong3 | kSurrogate,
+        // 1111____ ________ <four+ byte lead in byte 1>
+        kTooShort | kTooLarge | kTooLarge1000 | kOverlong4);
+
+    __m128i const kByte1Low = _mm_setr_epi8(
+        // ____0000 ________
+        kCarry | kOverlong3 | kOverlong2 | kOverlong4,
+        // ____0001 ________
+        kCarry | kOverlong2,
+        // ____001_ ________
+        kCarry,
+        kCarry,
+        // ____0100 ________
+        kCarry | kTooLarge,
+        // ____0101 ________
+        kCarry | kTooLarge | kTooLarge1000,
+        // ____011_ ________
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        // ____1___ ________
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        // ____1101 ________
+        kCarry | kTooLarge | kTooLarge1000 | kSurrogate,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000);
+
+    __m128i const kByte2High = _mm_setr_epi8(
+        // ________ 0_______ <ASCII in byte 2>
+        kTooShort, kTooShort, kTooShort, kTooShort,
+        kTooShort, kTooShort, kTooShort, kTooShort,
+        // ________ 1000____
+        kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4,
+        // ________ 1001____
+        kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+        // ________ 101_____
+        kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+        kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+        // ________ 11______ <lead byte in byte 2>
+        kTooShort, kTooShort, kTooShort, kTooShort);
+
+    __m128i const byte_1_high = _mm_shuffle_epi8(kByte1High, _mm_and_si128(_mm_srli_epi16(prev1, 4), kNibbleMask));
+    __m128i const byte_1_low  = _mm_shuffle_epi8(kByte1Low,  _mm_and_si128(prev1, kNibbleMask));
+    __m128i const byte_2_high = _mm_shuffle_epi8(kByte2High, _mm_and_si128(_mm_srli_epi16(input, 4), kNibbleMask));
+
+    return _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+}
+
+// Returns a non-zero vector if input (preceded by prev_input) contains an
+// invalid UTF-8 sequence. Sequences which are incomplete at the end of input
+// are not reported (see IsIncomplete).
+inline __m128i CheckBlock(__m128i input, __m128i prev_input)
+{
+    __m128i const prev1 = _mm_alignr_epi8(input, prev_input, 16 - 1);
+    __m128i const prev2 = _mm_alignr_epi8(input, prev_input, 16 - 2);
+    __m128i const prev3 = _mm_alignr_epi8(input, prev_input, 16 - 3);
+
+    __m128i const special_cases = CheckSpecialCases(input, prev1);
+
+    // Bytes which must be the 2nd or 3rd continuation byte of a 3- or 4-byte
+    // sequence have the high bit set.
+    __m128i const is_third_byte  = _mm_subs_epu8(prev2, _mm_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+    __m128i const is_fourth_byte = _mm_subs_epu8(prev3, _mm_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+    __m128i const must_be_2_3_continuation = _mm_and_si128(_mm_or_si128(is_third_byte, is_fourth_byte), _mm_set1_epi8(static_cast<char>(0x80)));
+
+    return _mm_xor_si128(must_be_2_3_continuation, special_cases);
+}
+
+// Returns a non-zero vector if the last 3 bytes of input contain the start of
+// a UTF-8 sequence which continues in the next block.
+inline __m128i IsIncomplete(__m128i input)
+{
+    __m128i const kMaxValue = _mm_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1));
+
+    return _mm_subs_epu8(input, kMaxValue);
+}
+
+} // namespace utf8_lookup
+#endif
+
+inline char const* ValidateUTF8(char const* next, char const* last)
+{
+#if JSON_USE_SSSE3
+    if (last - next >= 16)
+    {
+        auto const first = next;
+
+        __m128i const kZero = _mm_setzero_si128();
+
+        __m128i prev_input = kZero;
+        __m128i prev_incomplete = kZero;
+
+        while (last - next >= 16)
+        {
+            __m128i const input = _mm_loadu_si128(reinterpret_cast<__m128i const*>(next));
+
+            __m128i error;
+            if (_mm_movemask_epi8(input) == 0) // ASCII only
+            {
+                error = prev_incomplete;
+                prev_incomplete = kZero;
+            }
+            else
+            {
+                error = utf8_lookup::CheckBlock(input, prev_input);
+                prev_incomplete = utf8_lookup::IsIncomplete(input);
+            }
+
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(error, kZero)) != 0xFFFF)
+                break;
+
+            prev_input = input;
+            next += 16;
+        }
+
+        // All UTF-8 sequences which end before next are valid. Back up to the
+        // start of the last sequence before next and let the scalar loop below
+        // find the exact position of the first invalid sequence (if any).
+        for (int i = 0; i < 4 && next != first; ++i)
+        {
+            --next;
+            if (!IsUTF8Trail(*next))
+                break;
+        }
+    }
+#endif
+
+    while (next != last)
+    {
+        // Skip ASCII characters 8 at a time.
+        while (last - next >= 8)
+        {
+            uint64_t block;
+            std::memcpy(&block, next, 8);
+            if ((block & 0x8080808080808080) != 0)
+                break;
+            next += 8;
+        }
+
+        for ( ; next != last && static_cast<unsigned char>(*next) < 0x80; ++next)
+        {
+        }
+
+        if (next == last)
+            break;
+
+        uint32_t U = 0;
+        auto const end = DecodeUTF8Sequence(next, last, U);
+        if (U == kInvalidCodepoint)
+            return next;
+
+        next = end;
+    }
+
+    return next;
+}
+
 template <typename Put8>
 void EncodeUTF8(uint32_t U, Put8 put)
 {
@@ -163,7 +396,6 @@ void EncodeUTF8(uint32_t U, Put8 put)
     }
 }
 
-#if 0
 template <typename It>
 It DecodeUTF16Sequence(It next, It last, uint32_t& U)
 {
@@ -196,7 +428,6 @@ It DecodeUTF16Sequence(It next, It last, uint32_t& U)
     U = (((W1 & 0x3FF) << 10) | (W2 & 0x3FF)) + 0x10000;
     return next;
 }
-#endif
 
 template <typename Put16>
 void EncodeUTF16(uint32_t U, Put16 put)
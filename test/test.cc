@@ -9,14 +9,24 @@
 #endif
 
 #include "../src/json.h"
+#include "../src/json_cbor.h"
+#include "../src/json_decode.h"
 #include "../src/json_numbers.h"
+#include "../src/json_ondemand.h"
+#include "../src/json_path.h"
+#include "../src/json_snapshot.h"
+#include "../src/json_strings.h"
+#include "../src/json_tape.h"
 
 #include "catch.hpp"
 
+#include <algorithm>
 #include <tuple>
 #include <limits>
+#include <cstdio>
 #include <cstring>
 #include <cmath>
+#include <random>
 
 template <typename T> void Unused(T&& /*unused*/) {}
 
@@ -117,7 +127,8 @@ TEST_CASE("Value - implicit constructors")
 
         json::Value j11 = 1.234f;
         CHECK(j11.is_number());
-        CHECK(j11.get_number() == static_cast<double>(1.234f));
+        CHECK(j11.get_number() == 1.234); // not static_cast<double>(1.234f)
+        CHECK(j11.as<float>() == 1.234f);
     }
 
     SECTION("string")
@@ -313,6 +324,48 @@ TEST_CASE("Parse")
     CHECK(val["Address"]["Street"] == "Hello World");
 }
 
+TEST_CASE("Value - Key")
+{
+    json::Value val;
+    json::parse(val, std::string(R"({"": 0, "a": 1, "ab": 2, "b": 3, "\u0000": 4, "\u0000x": 5, "\u00E4": 6})"));
+    REQUIRE(val.is_object());
+
+    std::vector<std::string> const keys = {"", "a", "ab", "b", std::string(1, '\0'), std::string("\0x", 2), "\xC3\xA4"};
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        json::Key const key(keys[i]);
+        CHECK(key.str() == keys[i]);
+        CHECK(val.has_member(key));
+        REQUIRE(val.get_ptr(key) != nullptr);
+        CHECK(val.get_ptr(key)->get_number() == static_cast<double>(i));
+        CHECK(val[key] == static_cast<double>(i));
+
+        json::Value const& cval = val;
+        CHECK(cval[key] == static_cast<double>(i));
+
+        for (auto const& k : keys)
+        {
+            CHECK((key.compare(k) < 0) == (keys[i] < k));
+            CHECK((key.compare(k) > 0) == (keys[i] > k));
+        }
+    }
+
+    for (auto const& k : {"aa", "c", "\x01"})
+    {
+        json::Key const key(k);
+        CHECK(!val.has_member(key));
+        CHECK(val.get_ptr(key) == nullptr);
+    }
+
+    json::Key const key("new");
+    val[key] = 7;
+    CHECK(val["new"] == 7);
+    CHECK(val.size() == keys.size() + 1);
+
+    json::Value arr = json::Array{};
+    CHECK(arr.get_ptr(key) == nullptr);
+}
+
 //------------------------------------------------------------------------------
 //
 //------------------------------------------------------------------------------
@@ -620,6 +673,127 @@ TEST_CASE("Value - custom")
 #endif
 }
 
+struct Person {
+    std::string name;
+    int age = 0;
+    bool admin = false;
+    std::vector<std::string> tags;
+    std::vector<Point> points;
+    std::map<std::string, double> scores;
+    std::vector<Person> friends;
+};
+namespace json
+{
+    template <>
+    struct Schema<Point>
+    {
+        static constexpr auto fields() {
+            return std::make_tuple(JSON_FIELD(Point, x), JSON_FIELD(Point, y));
+        }
+    };
+
+    template <>
+    struct Schema<Person>
+    {
+        static constexpr auto fields() {
+            return std::make_tuple(
+                JSON_FIELD(Person, name),
+                JSON_FIELD(Person, age),
+                JSON_FIELD(Person, admin),
+                json::field("tag-list", &Person::tags),
+                JSON_FIELD(Person, points),
+                JSON_FIELD(Person, scores),
+                JSON_FIELD(Person, friends));
+        }
+    };
+}
+TEST_CASE("decode")
+{
+    SECTION("struct")
+    {
+        std::string const inp = R"({
+            "name": "John \"J\" Smith",
+            "unknown": {"a": [1, {"b": null}], "name": "ignored"},
+            "age": 42,
+            "admin": true,
+            "tag-list": ["a", "b\u00E4"],
+            "points": [{"x": 1.5, "y": -2}, {"y": 4, "z": 5}],
+            "scores": {"x": 1, "\u00E4": 2},
+            "friends": [{"name": "Jane", "friends": []}]
+        })";
+
+        Person p;
+        p.age = 1;
+        p.tags = {"old"};
+        CHECK(json::decode(p, inp) == json::ParseStatus::success);
+        CHECK(p.name == "John \"J\" Smith");
+        CHECK(p.age == 42);
+        CHECK(p.admin == true);
+        CHECK(p.tags == (std::vector<std::string>{"a", "b\xC3\xA4"}));
+        REQUIRE(p.points.size() == 2);
+        CHECK(p.points[0] == (Point{1.5, -2.0}));
+        CHECK(p.points[1].y == 4.0);
+        CHECK(p.scores == (std::map<std::string, double>{{"x", 1.0}, {"\xC3\xA4", 2.0}}));
+        REQUIRE(p.friends.size() == 1);
+        CHECK(p.friends[0].name == "Jane");
+        CHECK(p.friends[0].friends.empty());
+
+        // Same result as going through a json::Value.
+        json::Value val;
+        REQUIRE(json::parse(val, inp) == json::ParseStatus::success);
+        CHECK(val["points"][0].as<Point>() == p.points[0]);
+    }
+
+    SECTION("integers")
+    {
+        int8_t i8 = 0;
+        CHECK(json::decode(i8, std::string("127")) == json::ParseStatus::success);
+        CHECK(i8 == 127);
+        CHECK(json::decode(i8, std::string("-128")) == json::ParseStatus::success);
+        CHECK(i8 == -128);
+        CHECK(json::decode(i8, std::string("128")) == json::ParseStatus::invalid_number);
+        CHECK(json::decode(i8, std::string("-129")) == json::ParseStatus::invalid_number);
+
+        uint64_t u64 = 0;
+        CHECK(json::decode(u64, std::string("18446744073709551615")) == json::ParseStatus::success);
+        CHECK(u64 == UINT64_MAX);
+        CHECK(json::decode(u64, std::string("18446744073709551616")) == json::ParseStatus::invalid_number);
+        CHECK(json::decode(u64, std::string("-1")) == json::ParseStatus::invalid_number);
+        CHECK(json::decode(u64, std::string("-18446744073709551616")) == json::ParseStatus::invalid_number);
+        u64 = 1;
+        CHECK(json::decode(u64, std::string("-0")) == json::ParseStatus::success);
+        CHECK(u64 == 0);
+        uint8_t u8 = 1;
+        CHECK(json::decode(u8, std::string("-00")) != json::ParseStatus::success); // Not valid JSON
+        CHECK(json::decode(u8, std::string("-0")) == json::ParseStatus::success);
+        CHECK(u8 == 0);
+        CHECK(json::decode(u64, std::string("1.0")) == json::ParseStatus::unexpected_type);
+
+        int64_t i64 = 0;
+        CHECK(json::decode(i64, std::string("-9223372036854775808")) == json::ParseStatus::success);
+        CHECK(i64 == INT64_MIN);
+
+        float f = 0;
+        CHECK(json::decode(f, std::string("0.1")) == json::ParseStatus::success);
+        CHECK(f == 0.1f);
+    }
+
+    SECTION("errors")
+    {
+        Person p;
+        auto const inp = std::string(R"({"name": "x", "age": "42"})");
+        auto const res = json::decode(p, inp.data(), inp.data() + inp.size());
+        CHECK(res.ec == json::ParseStatus::unexpected_type);
+        CHECK(res.ptr == inp.data() + 22); // The contents of "42"
+
+        CHECK(json::decode(p, std::string(R"([])")) == json::ParseStatus::unexpected_type);
+        CHECK(json::decode(p, std::string(R"({"tag-list": [1]})")) == json::ParseStatus::unexpected_type);
+        CHECK(json::decode(p, std::string(R"({"admin": null})")) == json::ParseStatus::unexpected_type);
+        CHECK(json::decode(p, std::string(R"({"unknown": "\x"})")) == json::ParseStatus::invalid_string);
+        CHECK(json::decode(p, std::string(R"({"name": "x",})")) == json::ParseStatus::expected_key);
+    }
+}
+
 //------------------------------------------------------------------------------
 //
 //------------------------------------------------------------------------------
@@ -1207,132 +1381,1659 @@ static const JSONTestSuiteTest kJSONTestSuiteFail[] = {
     {std::string("[\342\201\240]", 5), "n_structure_whitespace_U+2060_word_joiner"},
 };
 
-TEST_CASE("JSONTestSuite")
+TEST_CASE("JSONTestSuite")
+{
+    SECTION("pass")
+    {
+        for (auto const& test : kJSONTestSuitePass)
+        {
+            CAPTURE(test.name);
+
+            json::Value val;
+            auto const res = json::parse(val, test.input.data(), test.input.data() + test.input.size());
+            CHECK(res.ec == json::ParseStatus::success);
+
+            std::string str;
+            auto const ok = json::stringify(str, val);
+            CHECK(ok == true);
+
+            json::Value val2;
+            auto const res2 = json::parse(val2, str.data(), str.data() + str.size());
+            CHECK(res2.ec == json::ParseStatus::success);
+
+            CHECK(val == val2);
+            CHECK(!(val != val2));
+            CHECK(!(val < val2));
+            CHECK(val <= val2);
+            CHECK(!(val > val2));
+            CHECK(val >= val2);
+        }
+    }
+
+    SECTION("fail")
+    {
+        for (auto const& test : kJSONTestSuiteFail)
+        {
+            CAPTURE(test.name);
+
+            json::Options options;
+            //options.allow_comments = true;
+
+            json::Value val;
+            auto const res = json::parse(val, test.input.data(), test.input.data() + test.input.size(), options);
+            CHECK(res.ec != json::ParseStatus::success);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+//
+//------------------------------------------------------------------------------
+
+struct StringTest
+{
+    std::string inp;
+    std::string expected;
+};
+
+static const StringTest kTestStrings[] = {
+    {"[\"\"]", ""},
+    {"[\"Hello\"]", "Hello"},
+    {"[\"Hello\\nWorld\"]", "Hello\nWorld"},
+    {std::string("[\"Hello\\u0000World\"]", 20), std::string("Hello\0World", 11)},
+    {"[\"\\\"\\\\/\\b\\f\\n\\r\\t\"]", "\"\\/\b\f\n\r\t"},
+    {"[\"\\u0024\"]", "\x24"},
+    {"[\"\\u00A2\"]", "\xC2\xA2"},
+    {"[\"\\u20AC\"]", "\xE2\x82\xAC"},
+    {"[\"\\uD834\\uDD1E\"]", "\xF0\x9D\x84\x9E"},
+};
+
+TEST_CASE("Parse_string")
+{
+    for (auto const& test : kTestStrings)
+    {
+        json::Value val1;
+        auto const res1 = json::parse(val1, test.inp.data(), test.inp.data() + test.inp.size());
+        CHECK(res1.ec == json::ParseStatus::success);
+        CHECK(val1.is_array());
+        CHECK(val1.get_array().size() == 1);
+        CHECK(val1[0].is_string());
+        CHECK(val1[0].get_string() == test.expected);
+
+        std::string s;
+        auto const str_ok = json::stringify(s, val1);
+        CHECK(str_ok);
+
+        json::Value val2;
+        auto const res2 = json::parse(val2, s.data(), s.data() + s.size());
+        CHECK(res2.ec == json::ParseStatus::success);
+        CHECK(val2.is_array());
+        CHECK(val2.get_array().size() == 1);
+        CHECK(val2[0].is_string());
+        CHECK(val2[0].get_string() == test.expected);
+    }
+}
+
+TEST_CASE("Parse_string - lazy unescaping")
+{
+    json::Options options;
+    options.lazy_string_unescaping = true;
+
+    for (auto const& test : kTestStrings)
+    {
+        json::Value val1;
+        auto const res1 = json::parse(val1, test.inp.data(), test.inp.data() + test.inp.size(), options);
+        CHECK(res1.ec == json::ParseStatus::success);
+        CHECK(val1.is_array());
+        CHECK(val1.get_array().size() == 1);
+        CHECK(val1[0].is_string());
+
+        std::string s;
+        auto const str_ok = json::stringify(s, val1);
+        CHECK(str_ok);
+
+        json::Value const val2 = val1;
+        CHECK(val2[0].get_string() == test.expected);
+        CHECK(!val2[0].is_escaped_string());
+        CHECK(val1[0].get_string() == test.expected);
+        CHECK(!val1[0].is_escaped_string());
+
+        json::Value val3;
+        auto const res3 = json::parse(val3, s.data(), s.data() + s.size());
+        CHECK(res3.ec == json::ParseStatus::success);
+        CHECK(val3 == val1);
+    }
+
+    {
+        json::Value val;
+        json::parse(val, std::string(R"(["a\u00E4b", "<\/", "\t</", "\u2028\u2029", "\n)") + "\xE2\x80\xA8\"]", options);
+        REQUIRE(val.is_array());
+        for (auto const& v : val.get_array())
+        {
+            CHECK(v.is_escaped_string());
+        }
+        CHECK(val[0].get_escaped_string() == R"(a\u00E4b)");
+
+        std::string s;
+        json::stringify(s, val);
+        CHECK(s == R"(["a\u00E4b","<\/","\t<\/","\u2028\u2029","\n\u2028"])");
+
+        // Const access returns the unescaped contents, too.
+        json::Value const& cval = val;
+        CHECK(cval[1].is_escaped_string());
+        CHECK(cval[1].as<std::string>() == "</");
+        CHECK(!cval[1].is_escaped_string());
+        CHECK(cval[2] == "\t</");
+
+        json::Value copy;
+        copy = val;
+        CHECK(copy[0].is_escaped_string());
+        CHECK(copy == val);
+        CHECK(copy[4].get_string() == "\n\xE2\x80\xA8");
+
+        val[0] = "x";
+        CHECK(!val[0].is_escaped_string());
+        CHECK(val[0].get_string() == "x");
+    }
+
+    for (auto const& inp : {R"(["\x"])", R"(["\uD800"])", "[\"\xC0\x80\"]", "[\"\t\"]"})
+    {
+        json::Value val;
+        CHECK(json::parse(val, std::string(inp), options) == json::ParseStatus::invalid_string);
+    }
+}
+
+static std::u16string UTF8ToUTF16(std::string const& s)
+{
+    std::u16string out;
+    for (auto next = s.begin(); next != s.end(); )
+    {
+        uint32_t U = 0;
+        next = json::unicode::DecodeUTF8Sequence(next, s.end(), U);
+        REQUIRE(U != json::unicode::kInvalidCodepoint);
+        json::unicode::EncodeUTF16(U, [&](uint16_t code_unit) { out += static_cast<char16_t>(code_unit); });
+    }
+    return out;
+}
+
+TEST_CASE("Parse_string - UTF-16")
+{
+    for (auto const& test : kTestStrings)
+    {
+        std::u16string const inp = UTF8ToUTF16(test.inp);
+
+        json::Value val1;
+        auto const res1 = json::parse(val1, inp.data(), inp.data() + inp.size());
+        CHECK(res1.ec == json::ParseStatus::success);
+        CHECK(res1.ptr == inp.data() + inp.size());
+        CHECK(val1.is_array());
+        CHECK(val1.get_array().size() == 1);
+        CHECK(val1[0].is_string());
+        CHECK(val1[0].get_string() == test.expected);
+
+        std::string s8;
+        json::stringify(s8, val1);
+        std::u16string s16;
+        json::stringify(s16, val1);
+        CHECK(s16 == UTF8ToUTF16(s8));
+    }
+
+    std::string const input = "\xEF\xBB\xBF" R"({"key \u00E4\u2028": [1.5, -2, true, false, null, "a\"\u20AC\uD834\uDD1E", {}], ")"
+                              "\xF0\x9D\x84\x9E" R"(": ")" "\xE2\x82\xAC" R"(</"})";
+
+    json::Value val8;
+    REQUIRE(json::parse(val8, input) == json::ParseStatus::success);
+
+    json::Value val16;
+    REQUIRE(json::parse(val16, UTF8ToUTF16(input)) == json::ParseStatus::success);
+    CHECK(val8 == val16);
+
+    json::Options options;
+    options.indent_width = 2;
+
+    std::string s8;
+    json::stringify(s8, val8, options);
+    std::u16string s16;
+    json::stringify(s16, val16, options);
+    CHECK(s16 == UTF8ToUTF16(s8));
+
+    // Unpaired surrogates
+    for (auto const& inp : {std::u16string(u"[\"\xD834\"]"), std::u16string(u"[\"\xDD1E\"]"), std::u16string(u"{\"\xD834x\":1}")})
+    {
+        json::Value val;
+        CHECK(json::parse(val, inp) == json::ParseStatus::invalid_string);
+    }
+
+    {
+        std::u16string const inp = u"[1, nul]";
+        json::Value val;
+        auto const res = json::parse(val, inp.data(), inp.data() + inp.size());
+        CHECK(res.ec == json::ParseStatus::unrecognized_identifier);
+        CHECK(res.ptr == inp.data() + 4);
+    }
+}
+
+TEST_CASE("Stringify")
+{
+    std::string const input = R"({
+    "empty_array": [],
+    "empty_object" : {},
+    "FirstName": "John",
+    "LastName": "Doe",
+    "Age": 43,
+    "Address": {
+        "Street": "Downing \"Street\" 10",
+        "City": "London",
+        "Country": "Great Britain"
+    },
+    "Phone numbers": [
+        "+44 1234567",
+        "+44 2345678"
+    ]
+})";
+
+    json::Value val;
+    json::parse(val, input.data(), input.data() + input.size());
+
+    json::Options options;
+    options.indent_width = 4;
+
+    std::string str;
+    json::stringify(str, val, options);
+    //printf("%s\n", str.c_str());
+
+    json::Value val2;
+    json::parse(val2, str.data(), str.data() + str.size());
+
+    CHECK(val == val2);
+}
+
+TEST_CASE("EscapeStringBulk")
+{
+    static const std::string kPad = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+    static const std::string inputs[] = {
+        "",
+        "Hello",
+        "Hello\nWorld",
+        std::string("Hello\0World", 11),
+        "\"\\/\b\f\n\r\t\x01\x1F\x7F",
+        "</script>",
+        "<</<>/",
+        "\xC2\xA2\xE2\x82\xAC\xF0\x9D\x84\x9E",
+        "\xE2\x80\xA8\xE2\x80\xA9",
+        "\xE2\x82",
+        "\x80\xBF",
+        "\xE4\xB8\xAD\xE2\x80\xA8<\xE2\x80\xA9/\xE4\xB8\xAD\xE2\x80\xAA</\xE4\xB8",
+    };
+
+    for (auto const& inp : inputs)
+    {
+        // Place the special characters at all positions relative to a 16-byte block.
+        for (size_t i = 0; i <= 17; ++i)
+        {
+            std::string const s = kPad.substr(0, i) + inp + kPad.substr(i);
+            CAPTURE(s);
+
+            char const* const first = s.data();
+            char const* const last  = s.data() + s.size();
+
+            std::string expected;
+            auto const res1 = json::strings::EscapeString(first, last, [&](char ch) { expected += ch; });
+
+            std::string actual;
+            auto const res2 = json::strings::EscapeStringBulk(first, last, [&](char const* f, char const* l) { actual.append(f, l); });
+
+            CHECK(res1.status == res2.status);
+            CHECK(res1.next == res2.next);
+            if (res1.status == json::strings::EscapeStringStatus::success) {
+                CHECK(expected == actual);
+            }
+
+            std::string expected_ascii;
+            auto const res3 = json::strings::EscapeString(first, last, [&](char ch) { expected_ascii += ch; }, /*ascii_only*/ true);
+
+            std::string actual_ascii;
+            auto const res4 = json::strings::EscapeStringBulk(first, last, [&](char const* f, char const* l) { actual_ascii.append(f, l); }, /*ascii_only*/ true);
+
+            CHECK(res3.status == res1.status);
+            CHECK(res3.status == res4.status);
+            CHECK(res3.next == res4.next);
+            if (res3.status == json::strings::EscapeStringStatus::success) {
+                CHECK(expected_ascii == actual_ascii);
+            }
+        }
+    }
+}
+
+TEST_CASE("Stringify - ascii_only")
+{
+    json::Options options;
+    options.ascii_only = true;
+
+    std::string const input = "\xC2\xA2\xE2\x82\xAC\xF0\x9D\x84\x9E</\xE2\x80\xA8\x7F";
+
+    std::string long_input = std::string(300, 'x') + input;
+    for (int i = 0; i < 100; ++i) {
+        long_input += "\xE4\xB8\xAD";
+    }
+
+    json::Value val;
+    val[input] = json::Array{input, long_input};
+
+    std::string s;
+    CHECK(json::stringify(s, val, options));
+    CHECK(std::all_of(s.begin(), s.end(), [](char ch) { return static_cast<unsigned char>(ch) < 0x80; }));
+    CHECK(s.find(R"("\u00A2\u20AC\uD834\uDD1E<\/\u2028)" "\x7F" R"(")") != std::string::npos);
+
+    json::Value val2;
+    CHECK(json::parse(val2, s) == json::ParseStatus::success);
+    CHECK(val == val2);
+
+    std::u16string s16;
+    CHECK(json::stringify(s16, val, options));
+    CHECK(s16 == std::u16string(s.begin(), s.end()));
+
+    // Strings stored in their escaped form.
+    json::Options parse_options;
+    parse_options.lazy_string_unescaping = true;
+
+    json::Value val3;
+    CHECK(json::parse(val3, "[\"\\n\xC2\xA2\"]", parse_options) == json::ParseStatus::success);
+    std::string s3;
+    CHECK(json::stringify(s3, val3, options));
+    CHECK(s3 == R"(["\n\u00A2"])");
+
+    // Invalid UTF-8
+    json::Value val4 = "\xC2";
+    std::string s4;
+    CHECK(!json::stringify(s4, val4, options));
+}
+
+TEST_CASE("UnescapeStringBulk")
+{
+    static const std::string kPad = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+    static const std::string inputs[] = {
+        "",
+        "Hello",
+        "\\\"\\\\\\/\\b\\f\\n\\r\\t",
+        "<a href=\\\"x\\\">\\u003C\\/a\\u003E",
+        "\\u0000\\u00e4\\u20AC\\uD834\\uDD1E",
+        "\xC2\xA2\xE2\x82\xAC\xF0\x9D\x84\x9E",
+        "Hello\nWorld",
+        "\\x",
+        "\\",
+        "\\u",
+        "\\u12",
+        "\\uD834",
+        "\\uD834\\u0041",
+        "\\uDD1E",
+        "\xE2\x82",
+        "\x80\xBF",
+    };
+
+    for (auto const& inp : inputs)
+    {
+        // Place the special characters at all positions relative to a 16-byte block.
+        for (size_t i = 0; i <= 17; ++i)
+        {
+            for (size_t j : {size_t{0}, i})
+            {
+                std::string const s = kPad.substr(0, i) + inp + kPad.substr(j);
+                CAPTURE(s);
+
+                char const* const first = s.data();
+                char const* const last  = s.data() + s.size();
+
+                std::string expected;
+                auto const res1 = json::strings::UnescapeString(first, last, [&](char ch) { expected += ch; });
+
+                std::string actual(s.size(), '\0');
+                char* out = &actual[0];
+                auto const res2 = json::strings::UnescapeStringBulk(first, last, out);
+                actual.resize(static_cast<size_t>(out - actual.data()));
+
+                CHECK(res1.status == res2.status);
+                CHECK(res1.next == res2.next);
+                if (res1.status == json::strings::UnescapeStringStatus::success) {
+                    CHECK(expected == actual);
+                }
+
+                std::string str = "old contents";
+                auto const res3 = json::strings::UnescapeStringBulk(str, first, last);
+                CHECK(res1.status == res3.status);
+                CHECK(res1.next == res3.next);
+                if (res1.status == json::strings::UnescapeStringStatus::success) {
+                    CHECK(expected == str);
+                }
+
+                std::vector<char> buf = {'x'};
+                auto const res4 = json::strings::AppendUnescapedString(buf, first, last);
+                CHECK(res1.status == res4.status);
+                if (res1.status == json::strings::UnescapeStringStatus::success) {
+                    CHECK("x" + expected == std::string(buf.begin(), buf.end()));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("ValidateUTF8")
+{
+    // Lead bytes, trail bytes and the boundaries of the valid ranges.
+    static const unsigned char kBytes[] = {
+        'a', 0x7F, 0x80, 0x8F, 0x90, 0x9F, 0xA0, 0xBF, 0xC0, 0xC1, 0xC2, 0xDF,
+        0xE0, 0xE1, 0xEC, 0xED, 0xEE, 0xEF, 0xF0, 0xF1, 0xF3, 0xF4, 0xF5, 0xFF,
+    };
+
+    static const std::string kValid = "\xC2\xA2\xE2\x82\xAC\xF0\x9D\x84\x9E\xED\x9F\xBF\xEE\x80\x80\xF4\x8F\xBF\xBF";
+
+    std::mt19937 rng(0x5EED);
+    std::uniform_int_distribution<size_t> gen_byte(0, sizeof(kBytes) - 1);
+    std::uniform_int_distribution<size_t> gen_length(0, 80);
+    std::uniform_int_distribution<int> gen_choice(0, 9);
+
+    for (int iter = 0; iter < 20000; ++iter)
+    {
+        // Mostly valid input with a few random bytes.
+        std::string s;
+        size_t const length = gen_length(rng);
+        while (s.size() < length)
+        {
+            int const choice = gen_choice(rng);
+            if (choice < 4)
+                s += kValid.substr(gen_byte(rng) % kValid.size(), 4);
+            else if (choice < 8)
+                s += "0123456789abcdef";
+            else
+                s += static_cast<char>(kBytes[gen_byte(rng)]);
+        }
+        CAPTURE(s);
+
+        auto const expected = json::unicode::ValidateUTF8(s.cbegin(), s.cend()) - s.cbegin();
+        auto const actual = json::unicode::ValidateUTF8(s.data(), s.data() + s.size()) - s.data();
+        CHECK(expected == actual);
+
+        std::string unescaped;
+        auto const res = json::strings::UnescapeString(s.data(), s.data() + s.size(), [&](char ch) { unescaped += ch; });
+        CHECK(res.next - s.data() == expected);
+        CHECK(res.status == (static_cast<size_t>(expected) == s.size()
+                                ? json::strings::UnescapeStringStatus::success
+                                : json::strings::UnescapeStringStatus::invalid_utf8_sequence));
+    }
+}
+
+TEST_CASE("stringify_parallel")
+{
+    json::Value val;
+    for (int i = 0; i < 100; ++i)
+    {
+        json::Value obj;
+        obj["id"] = i;
+        obj["name"] = "item " + std::to_string(i);
+        obj["tags"] = json::Array{json::Value(i % 2 == 0), json::Value(nullptr), json::Value(1.5 * i)};
+        obj["empty"] = json::Array{};
+        val.push_back(std::move(obj));
+    }
+
+    json::Value root;
+    root["items"] = val;
+    root["a"] = 1;
+    root["b"] = json::Object{{"x", "y"}};
+
+    for (int indent : {-1, 0, 2, 4})
+    {
+        CAPTURE(indent);
+
+        json::Options options;
+        options.indent_width = static_cast<int8_t>(indent);
+
+        for (auto const* v : {&val, &root, &root["b"], &root["a"]})
+        {
+            std::string expected;
+            CHECK(json::stringify(expected, *v, options));
+
+            for (int num_threads : {1, 2, 3, 4, 16, 1000})
+            {
+                CAPTURE(num_threads);
+
+                std::string actual;
+                CHECK(json::stringify_parallel(actual, *v, options, num_threads));
+                CHECK(expected == actual);
+            }
+        }
+    }
+
+    val[57]["name"] = "\xFF";
+
+    std::string out;
+    CHECK(!json::stringify_parallel(out, val, {}, 4));
+}
+
+struct CountingCallbacks /*final*/ : json::ParseCallbacks
+{
+    size_t num_values = 0; // Top-level values
+    int depth = 0;
+
+    json::ParseStatus Value() { if (depth == 0) ++num_values; return {}; }
+
+    json::ParseStatus HandleNull(json::Options const&) override { return Value(); }
+    json::ParseStatus HandleBoolean(bool, json::Options const&) override { return Value(); }
+    json::ParseStatus HandleNumber(char const*, char const*, json::NumberClass, json::Options const&) override { return Value(); }
+    json::ParseStatus HandleString(char const*, char const*, bool, json::Options const&) override { return Value(); }
+    json::ParseStatus HandleBeginArray(json::Options const&) override { Value(); ++depth; return {}; }
+    json::ParseStatus HandleEndArray(size_t, json::Options const&) override { --depth; return {}; }
+    json::ParseStatus HandleEndElement(size_t&, json::Options const&) override { return {}; }
+    json::ParseStatus HandleBeginObject(json::Options const&) override { Value(); ++depth; return {}; }
+    json::ParseStatus HandleEndObject(size_t, json::Options const&) override { --depth; return {}; }
+    json::ParseStatus HandleEndMember(size_t&, json::Options const&) override { return {}; }
+    json::ParseStatus HandleKey(char const*, char const*, bool, json::Options const&) override { return {}; }
+};
+
+TEST_CASE("parse_lines")
+{
+    std::string inp;
+    std::vector<json::Value> expected;
+    for (int i = 0; i < 500; ++i)
+    {
+        std::string line;
+        switch (i % 5)
+        {
+        case 0:
+            line = R"({"id": )" + std::to_string(i) + R"(, "msg": "line\nbreak", "tags": [1, 2, {"x": null}]})";
+            break;
+        case 1:
+            line = std::to_string(i);
+            break;
+        case 2:
+            line = R"("string \u00E4")";
+            break;
+        case 3:
+            line = "  [true, false]\r";
+            break;
+        case 4:
+            line = "{}";
+            break;
+        }
+
+        json::Value val;
+        REQUIRE(json::parse(val, line) == json::ParseStatus::success);
+        expected.push_back(std::move(val));
+
+        inp += line;
+        inp += (i % 7 == 0) ? "\n \t\n" : "\n";
+    }
+    inp.pop_back(); // The last newline is optional.
+
+    for (int num_threads : {1, 2, 3, 16, 1000})
+    {
+        CAPTURE(num_threads);
+
+        std::vector<json::Value> values;
+        values.emplace_back("existing");
+        CHECK(json::parse_lines(values, inp, {}, num_threads) == json::ParseStatus::success);
+        REQUIRE(values.size() == 1 + expected.size());
+        CHECK(values[0] == "existing");
+        CHECK(std::equal(expected.begin(), expected.end(), values.begin() + 1));
+
+        std::vector<CountingCallbacks> cbs(static_cast<size_t>(num_threads));
+        std::vector<json::ParseCallbacks*> cb_ptrs;
+        for (auto& cb : cbs)
+            cb_ptrs.push_back(&cb);
+
+        auto const res = json::parse_lines(cb_ptrs.data(), num_threads, inp.data(), inp.data() + inp.size());
+        CHECK(res.ec == json::ParseStatus::success);
+
+        size_t num_values = 0;
+        for (auto const& cb : cbs)
+            num_values += cb.num_values;
+        CHECK(num_values == expected.size());
+    }
+
+    {
+        std::vector<json::Value> values;
+        CHECK(json::parse_lines(values, std::string()) == json::ParseStatus::success);
+        CHECK(json::parse_lines(values, std::string("\n\n  \n")) == json::ParseStatus::success);
+        CHECK(values.empty());
+    }
+
+    // The first error is reported.
+    std::string bad = inp;
+    auto const pos1 = bad.find("false", bad.size() / 4);
+    auto const pos2 = bad.find("false", bad.size() / 2);
+    bad[pos1] = 'x';
+    bad[pos2] = 'x';
+
+    for (int num_threads : {1, 4, 1000})
+    {
+        CAPTURE(num_threads);
+
+        std::vector<json::Value> values;
+        auto const res = json::parse_lines(values, bad.data(), bad.data() + bad.size(), {}, num_threads);
+        CHECK(res.ec == json::ParseStatus::unrecognized_identifier);
+        CHECK(res.ptr == bad.data() + pos1);
+        CHECK(values.empty());
+    }
+
+    {
+        std::vector<json::Value> values;
+        CHECK(json::parse_lines(values, std::string("1 2\n")) == json::ParseStatus::expected_eof);
+        CHECK(json::parse_lines(values, std::string("[1,\n2]")) == json::ParseStatus::unexpected_eof);
+    }
+}
+
+TEST_CASE("parse_parallel")
+{
+    std::string inp = "\xEF\xBB\xBF [";
+    for (int i = 0; i < 300; ++i)
+    {
+        if (i != 0)
+            inp += (i % 3 == 0) ? ",\n  " : ",";
+        switch (i % 4)
+        {
+        case 0:
+            inp += R"({"id": )" + std::to_string(i) + R"(, "s": "a,b]\"[{", "arr": [1, [2, {"x": []}]]})";
+            break;
+        case 1:
+            inp += std::to_string(i * 1.5);
+            break;
+        case 2:
+            inp += R"("\\")";
+            break;
+        case 3:
+            inp += "[true, null, {}]";
+            break;
+        }
+    }
+    inp += "] \n";
+
+    auto const check = [](std::string const& str, json::Options const& options) {
+        json::Value expected;
+        auto const expected_res = json::parse(expected, str.data(), str.data() + str.size(), options);
+
+        for (int num_threads : {2, 3, 64})
+        {
+            json::Value actual;
+            auto const res = json::parse_parallel(actual, str.data(), str.data() + str.size(), options, num_threads);
+            CHECK(res.ec == expected_res.ec);
+            CHECK(res.ptr == expected_res.ptr);
+            if (res.ec == json::ParseStatus::success)
+                CHECK(actual == expected);
+        }
+    };
+
+    json::Options options;
+    check(inp, options);
+
+    options.allow_trailing_characters = true;
+    check(inp + "[1]", options);
+    check(inp + "\"s\"", options);
+    check(inp.substr(0, inp.size() - 3) + ",]", options);
+
+    options.allow_trailing_comma = true;
+    check(inp.substr(0, inp.size() - 3) + ",]", options);
+    check(inp.substr(0, inp.size() - 3) + ",,]", options);
+
+    json::Options const default_options;
+    for (auto const& str : {"[]", " [ \n ] ", "[1]", "[", "[,]", "[1,]", "[1 2]", "[1,,2]", "[\"]", "[[[]]", "[]]", "[1] [2]", "{\"a\": [1, 2]}", "17", "[1,2}", "[}", "[1,{\"a\":2}}", "[1,2.5e3}{}"})
+    {
+        CAPTURE(str);
+        check(str, default_options);
+        check(str, options);
+    }
+
+    check(std::string(499, '[') + std::string(499, ']'), default_options);
+    check(std::string(500, '[') + std::string(500, ']'), default_options);
+    check(std::string(501, '[') + std::string(501, ']'), default_options);
+
+    // Random errors are reported at the same position as by parse.
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<size_t> gen_pos(0, inp.size() - 1);
+    for (int i = 0; i < 300; ++i)
+    {
+        std::string str = inp;
+        str[gen_pos(rng)] = "[]{},\":\\ x1"[i % 12];
+        CAPTURE(str);
+        check(str, default_options);
+    }
+}
+
+TEST_CASE("Parse - projection")
+{
+    std::string const inp = R"({
+        "id": 17,
+        "user": {"name": "John", "email": "john@example.com", "roles": ["admin", "dev"]},
+        "events": [{"type": "a", "ts": 1}, {"type": "b", "ts": 2}, {"type": "c", "ts": 3}, {"type": "d"}],
+        "payload": {"big": [1, 2, 3, {"x": "y"}], "esc\"aped": {"a/b": 1, "c~d": 2}},
+        "n": null
+    })";
+
+    auto const check = [&](std::vector<std::string> const& paths, char const* expected_json) {
+        CAPTURE(expected_json);
+
+        json::Projection projection;
+        for (auto const& p : paths)
+            CHECK(projection.add(p));
+
+        json::Value expected;
+        REQUIRE(json::parse(expected, std::string(expected_json)) == json::ParseStatus::success);
+
+        json::Value actual;
+        CHECK(json::parse(actual, projection, inp) == json::ParseStatus::success);
+        CHECK(actual == expected);
+    };
+
+    check({""}, inp.c_str());
+    check({"id"}, R"({"id": 17})");
+    check({"/id", "/n"}, R"({"id": 17, "n": null})");
+    check({"user.name", "user.roles"}, R"({"user": {"name": "John", "roles": ["admin", "dev"]}})");
+    check({"/user/roles/1"}, R"({"user": {"roles": [null, "dev"]}})");
+    check({"events.1.type", "/events/2"}, R"({"events": [null, {"type": "b"}, {"type": "c", "ts": 3}]})");
+    check({"events.0.ts", "events.3.ts"}, R"({"events": [{"ts": 1}, null, null, {}]})");
+    check({"/payload/esc\"aped/a~1b", "/payload/esc\"aped/c~0d"}, R"({"payload": {"esc\"aped": {"a/b": 1, "c~d": 2}}})");
+    check({"payload.big.3.x", "payload.big"}, R"({"payload": {"big": [1, 2, 3, {"x": "y"}]}})");
+    check({"missing", "id.x", "user.name.x", "events.x"}, R"({"user": {}, "events": []})");
+    check({"/events/01", "/events/-1"}, R"({"events": []})");
+
+    {
+        json::Projection projection;
+        CHECK(!projection.add("/a~2"));
+        CHECK(!projection.add("/a~"));
+        CHECK(projection.add("a~2"));
+    }
+
+    // Values which are not selected are still validated.
+    {
+        json::Projection projection;
+        projection.add("a");
+
+        json::Value val;
+        CHECK(json::parse(val, projection, std::string(R"({"a": 1, "b": [1, "\x"]})")) == json::ParseStatus::invalid_string);
+        CHECK(json::parse(val, projection, std::string(R"({"a": 1, "b\x": 2})")) == json::ParseStatus::invalid_string);
+        CHECK(json::parse(val, projection, std::string(R"({"a": 1, "b": [1 2]})")) == json::ParseStatus::expected_comma_or_closing_bracket);
+        CHECK(json::parse(val, projection, std::string(R"([1, 2])")) == json::ParseStatus::success);
+        CHECK(val == json::Array{});
+        CHECK(json::parse(val, projection, std::string(R"("str")")) == json::ParseStatus::success);
+        CHECK(val == "str");
+    }
+
+    // Many members and elements.
+    {
+        std::string big = R"({"arr": [)";
+        for (int i = 0; i < 1000; ++i)
+        {
+            if (i != 0)
+                big += ',';
+            big += R"({"k)" + std::to_string(i % 300) + R"(": )" + std::to_string(i) + "}";
+        }
+        big += "]";
+        for (int i = 0; i < 1000; ++i)
+            big += R"(, "m)" + std::to_string(i) + R"(": )" + std::to_string(i);
+        big += "}";
+
+        json::Value full;
+        REQUIRE(json::parse(full, big) == json::ParseStatus::success);
+
+        json::Projection projection;
+        projection.add("arr");
+        for (int i = 0; i < 1000; i += 2)
+            projection.add("m" + std::to_string(i));
+
+        json::Value val;
+        REQUIRE(json::parse(val, projection, big) == json::ParseStatus::success);
+        CHECK(val["arr"] == full["arr"]);
+        CHECK(val.size() == 501);
+        CHECK(val["m998"] == 998);
+        CHECK(!val.has_member("m999"));
+    }
+}
+
+TEST_CASE("Pointer")
+{
+    // RFC 6901, Section 5
+    json::Value doc;
+    REQUIRE(json::parse(doc, std::string(R"({
+        "foo": ["bar", "baz"],
+        "": 0,
+        "a/b": 1,
+        "c%d": 2,
+        "e^f": 3,
+        "g|h": 4,
+        "i\\j": 5,
+        "k\"l": 6,
+        " ": 7,
+        "m~n": 8
+    })")) == json::ParseStatus::success);
+
+    struct Test { char const* ptr; json::Value const* expected; };
+    Test const tests[] = {
+        {"",       &doc},
+        {"/foo",   &doc["foo"]},
+        {"/foo/0", &doc["foo"][0]},
+        {"/",      &doc[""]},
+        {"/a~1b",  &doc["a/b"]},
+        {"/c%d",   &doc["c%d"]},
+        {"/e^f",   &doc["e^f"]},
+        {"/g|h",   &doc["g|h"]},
+        {"/i\\j",  &doc["i\\j"]},
+        {"/k\"l",  &doc["k\"l"]},
+        {"/ ",     &doc[" "]},
+        {"/m~0n",  &doc["m~n"]},
+    };
+    for (auto const& test : tests)
+    {
+        CAPTURE(test.ptr);
+
+        json::Pointer const ptr(test.ptr);
+        CHECK(ptr.is_valid());
+        CHECK(ptr.to_string() == test.ptr);
+        CHECK(ptr.get(doc) == test.expected);
+
+        json::Value const& cdoc = doc;
+        CHECK(ptr.get(cdoc) == test.expected);
+    }
+
+    for (auto const str : {"/foo/2", "/foo/-", "/foo/01", "/foo/x", "/missing", "/foo/0/x", "//"})
+    {
+        CAPTURE(str);
+        json::Pointer const ptr(str);
+        CHECK(ptr.is_valid());
+        CHECK(ptr.get(doc) == nullptr);
+    }
+
+    for (auto const str : {"foo", "/~", "/~2", "/a~"})
+    {
+        CAPTURE(str);
+        json::Pointer const ptr(str);
+        CHECK(!ptr.is_valid());
+        CHECK(ptr.get(doc) == nullptr);
+        CHECK(ptr.set(doc, 1) == nullptr);
+        CHECK(!ptr.erase(doc));
+    }
+
+    SECTION("set")
+    {
+        json::Value val;
+        CHECK(json::Pointer("/a/b/1/c").set(val, 1) == nullptr);
+        CHECK(val.is_undefined());
+        CHECK(json::Pointer("/a/b/0").set(val, 0) != nullptr);
+        CHECK(json::Pointer("/a/b/1/c").set(val, 1) != nullptr);
+        CHECK(json::Pointer("/a/b/-").set(val, 2) != nullptr);
+        CHECK(json::Pointer("/a/x~1y").set(val, 3) != nullptr);
+        CHECK(*json::Pointer("/a/b/0").set(val, "s") == "s");
+
+        json::Value expected;
+        json::parse(expected, std::string(R"({"a": {"b": ["s", {"c": 1}, 2], "x/y": 3}})"));
+        CHECK(val == expected);
+
+        // Intermediate values which are neither objects nor arrays.
+        CHECK(json::Pointer("/a/b/0/x").set(val, 4) == nullptr);
+        CHECK(json::Pointer("/a/b/x").set(val, 4) == nullptr);
+        CHECK(val == expected);
+
+        // Array indices larger than the size of the array.
+        CHECK(json::Pointer("/a/b/4").set(val, 4) == nullptr);
+        CHECK(json::Pointer("/a/b/99999999999999999").set(val, 4) == nullptr);
+        CHECK(json::Pointer("/a/c/1").set(val, 4) == nullptr);
+        CHECK(val == expected);
+        CHECK(*json::Pointer("/a/b/3").set(val, 4) == 4);
+        CHECK(val["a"]["b"].size() == 4);
+
+        CHECK(*json::Pointer("").set(val, 5) == 5);
+        CHECK(val == 5);
+    }
+
+    SECTION("erase")
+    {
+        json::Value val = doc;
+        CHECK(json::Pointer("/foo/0").erase(val));
+        CHECK(val["foo"] == json::Array{"baz"});
+        CHECK(!json::Pointer("/foo/1").erase(val));
+        CHECK(!json::Pointer("/foo/-").erase(val));
+        CHECK(json::Pointer("/a~1b").erase(val));
+        CHECK(!val.has_member("a/b"));
+        CHECK(!json::Pointer("/a~1b").erase(val));
+        CHECK(!json::Pointer("/x/y").erase(val));
+        CHECK(!json::Pointer("").erase(val));
+        CHECK(val.size() == doc.size() - 1);
+    }
+}
+
+TEST_CASE("JSONPath")
+{
+    std::string const text = R"({
+        "store": {
+            "book": [
+                {"category": "reference", "author": "Nigel Rees", "title": "Sayings of the Century", "price": 8.95},
+                {"category": "fiction", "author": "Evelyn Waugh", "title": "Sword of Honour", "price": 12.99},
+                {"category": "fiction", "author": "Herman Melville", "title": "Moby Dick", "isbn": "0-553-21311-3", "price": 8.99},
+                {"category": "fiction", "author": "J. R. R. Tolkien", "title": "The Lord of the Rings", "isbn": "0-395-19395-8", "price": 22.99}
+            ],
+            "bicycle": {"color": "red", "price": 19.95}
+        },
+        "a.b": [0, 1, 2, 3, 4, 5]
+    })";
+
+    json::Value doc;
+    REQUIRE(json::ParseStatus::success == json::parse(doc, text));
+
+    auto const query = [&](std::string const& expr) {
+        json::Path const path(expr);
+        CHECK(path.is_valid());
+
+        json::Array result;
+        json::PathMatches matches(path, doc);
+        while (auto const* v = matches.next())
+        {
+            result.push_back(*v);
+        }
+        return json::Value(std::move(result));
+    };
+
+    CHECK(query("$") == json::Array{doc});
+    CHECK(query("$.store.book[0].author") == json::Array{"Nigel Rees"});
+    CHECK(query("$['store']['book'][-1][\"title\"]") == json::Array{"The Lord of the Rings"});
+    CHECK(query("$.store.book[*].author") == json::Array{"Nigel Rees", "Evelyn Waugh", "Herman Melville", "J. R. R. Tolkien"});
+    CHECK(query("$..author") == json::Array{"Nigel Rees", "Evelyn Waugh", "Herman Melville", "J. R. R. Tolkien"});
+    CHECK(query("$.store..price") == json::Array{19.95, 8.95, 12.99, 8.99, 22.99}); // Object members are sorted by key
+    CHECK(query("$..book[2].title") == json::Array{"Moby Dick"});
+    CHECK(query("$..book[0,1].price") == json::Array{8.95, 12.99});
+    CHECK(query("$..book[?(@.isbn)].title") == json::Array{"Moby Dick", "The Lord of the Rings"});
+    CHECK(query("$..book[?(@.price < 10)].title") == json::Array{"Sayings of the Century", "Moby Dick"});
+    CHECK(query("$..book[?@.category == 'fiction' && @.price <= 12.99].author") == json::Array{"Evelyn Waugh", "Herman Melville"});
+    CHECK(query("$..book[?(@.price > 20 || @.category == \"reference\")].price") == json::Array{8.95, 22.99});
+    CHECK(query("$..book[?(@.category != 'fiction')].price") == json::Array{8.95});
+    CHECK(query("$.store.book[?(@.missing == null)]").size() == 0);
+    CHECK(query("$.store.*.color") == json::Array{"red"});
+    CHECK(query("$.store.book[0].nope") == json::Array{});
+    CHECK(query("$.store.book[4]") == json::Array{});
+
+    SECTION("slices")
+    {
+        CHECK(query("$['a.b'][1:3]") == json::Array{1, 2});
+        CHECK(query("$['a.b'][:2]") == json::Array{0, 1});
+        CHECK(query("$['a.b'][-2:]") == json::Array{4, 5});
+        CHECK(query("$['a.b'][::2]") == json::Array{0, 2, 4});
+        CHECK(query("$['a.b'][::-2]") == json::Array{5, 3, 1});
+        CHECK(query("$['a.b'][4:1:-1]") == json::Array{4, 3, 2});
+        CHECK(query("$['a.b'][5:100]") == json::Array{5});
+        CHECK(query("$['a.b'][::0]") == json::Array{});
+        CHECK(query("$['a.b'][3:1]") == json::Array{});
+    }
+
+    SECTION("invalid")
+    {
+        CHECK(!json::Path().is_valid());
+        CHECK(!json::Path("").is_valid());
+        CHECK(!json::Path("store").is_valid());
+        CHECK(!json::Path("$.").is_valid());
+        CHECK(!json::Path("$[").is_valid());
+        CHECK(!json::Path("$['a").is_valid());
+        CHECK(!json::Path("$[0,1:2]").is_valid());
+        CHECK(!json::Path("$[?(@.a <)]").is_valid());
+        CHECK(!json::Path("$[?(@.a == 1]").is_valid());
+
+        json::PathMatches matches(json::Path("$["), doc);
+        CHECK(matches.next() == nullptr);
+    }
+
+    SECTION("query")
+    {
+        char const* const exprs[] = {
+            "$",
+            "$.store.book[0].author",
+            "$['store']['book'][-1][\"title\"]",
+            "$.store.book[*].author",
+            "$..author",
+            "$..book[2].title",
+            "$..book[0,1].price",
+            "$..book[?(@.isbn)].title",
+            "$..book[?(@.price < 10)]",
+            "$..book[?(@.category == 'fiction' && @.price <= 12.99)].author",
+            "$.store.*.color",
+            "$.store.book[4]",
+            "$['a.b'][1:3]",
+            "$['a.b'][-2:]",
+            "$['a.b'][::2]",
+            "$['a.b'][::0]",
+            "$[",
+        };
+
+        for (auto const* expr : exprs)
+        {
+            CAPTURE(expr);
+
+            json::Path const path(expr);
+
+            std::vector<json::Value> expected;
+            json::PathMatches matches(path, doc);
+            while (auto const* v = matches.next())
+            {
+                expected.push_back(*v);
+            }
+
+            std::vector<json::Value> actual;
+            CHECK(json::ParseStatus::success == json::query(actual, path, text));
+            CHECK(actual == expected);
+        }
+
+        struct RawMatches final : json::QueryCallbacks
+        {
+            std::vector<std::string> matches;
+
+            json::ParseStatus HandleMatch(char const* first, char const* last, json::Options const& /*options*/) override
+            {
+                matches.emplace_back(first, last);
+                return json::ParseStatus::success;
+            }
+        };
+
+        // Matches are reported in the order in which they appear in the input.
+        std::vector<json::Value> actual;
+        CHECK(json::ParseStatus::success == json::query(actual, json::Path("$.store..price"), text));
+        CHECK(actual == (std::vector<json::Value>{8.95, 12.99, 8.99, 22.99, 19.95}));
+        CHECK(json::ParseStatus::success == json::query(actual, json::Path("$['a.b'][4:1:-1]"), text));
+        CHECK(actual == (std::vector<json::Value>{2.0, 3.0, 4.0}));
+
+        RawMatches raw;
+        json::query(raw, json::Path("$..['color', 'isbn']"), text.data(), text.data() + text.size());
+        CHECK(raw.matches == (std::vector<std::string>{R"("0-553-21311-3")", R"("0-395-19395-8")", R"("red")"}));
+
+        // Nested matches are reported first.
+        CHECK(json::ParseStatus::success == json::query(actual, json::Path("$..a"), R"({"a": {"b": [{"a": 1}]}})"));
+        CHECK(actual == (std::vector<json::Value>{1.0, json::Object{{"b", json::Array{json::Object{{"a", 1.0}}}}}}));
+
+        // Values which are selected more than once are reported more than once
+        // (by both engines).
+        struct DupTest { char const* expr; char const* text; size_t count; };
+        for (auto const& test : {
+                DupTest{"$[0,-1]", R"([6])", 2},
+                DupTest{"$[0,0,0]", R"([6])", 3},
+                DupTest{"$..a..b", R"({"a": {"a": {"b": 1}}})", 2},
+                DupTest{"$..a..[?(@.x)]", R"({"a": {"a": {"c": {"x": 1}}}})", 2},
+            })
+        {
+            CAPTURE(test.expr);
+
+            json::Path const path(test.expr);
+
+            json::Value v;
+            REQUIRE(json::parse(v, test.text) == json::ParseStatus::success);
+
+            std::vector<json::Value> expected;
+            json::PathMatches matches(path, v);
+            while (auto const* m = matches.next())
+            {
+                expected.push_back(*m);
+            }
+
+            CHECK(json::ParseStatus::success == json::query(actual, path, test.text));
+            CHECK(actual == expected);
+            CHECK(actual.size() == test.count);
+        }
+
+        // Duplicate keys: query matches all members, a Value keeps the last one.
+        {
+            json::Path const path("$.a");
+            CHECK(json::ParseStatus::success == json::query(actual, path, R"({"a": 1, "b": 2, "a": 3})"));
+            CHECK(actual == (std::vector<json::Value>{1.0, 3.0}));
+
+            json::Value v;
+            REQUIRE(json::parse(v, std::string(R"({"a": 1, "b": 2, "a": 3})")) == json::ParseStatus::success);
+            json::PathMatches matches(path, v);
+            auto const* m = matches.next();
+            REQUIRE(m != nullptr);
+            CHECK(*m == 3.0);
+            CHECK(matches.next() == nullptr);
+        }
+
+        // Skipped values are still validated.
+        CHECK(json::ParseStatus::invalid_string == json::query(actual, json::Path("$.a"), R"({"b": ["\x"], "a": 1})"));
+        CHECK(json::ParseStatus::expected_comma_or_closing_brace == json::query(actual, json::Path("$.a"), R"({"a": 1 "b": 2})"));
+        CHECK(json::ParseStatus::unrecognized_identifier == json::query(actual, json::Path("$.a"), R"({"b": nul, "a": 1})"));
+        CHECK(json::ParseStatus::expected_eof == json::query(actual, json::Path("$.a"), R"({"a": 1} 2)"));
+
+        json::Options options;
+        options.strip_comments = true;
+        options.allow_trailing_comma = true;
+        CHECK(json::ParseStatus::success == json::query(actual, json::Path("$.a[-1]"), R"({"b": /*x*/ [1,], "a": [1, 2, /* three */ 3,],})", options));
+        CHECK(actual == (std::vector<json::Value>{3.0}));
+    }
+}
+
+TEST_CASE("ondemand")
+{
+    std::string const text = R"({
+        "user": {"id": 12345, "name": "J\u00E4ne", "tags": ["a", "b"]},
+        "items": [{"name": "x", "price": 1.5}, {"name": "y", "price": -2e3}, {"name": "z"}],
+        "flags": [true, false, null],
+        "blob": {"nested": [1, {"a": []}], "s": "\\"}
+    })";
+
+    SECTION("lookup")
+    {
+        json::ondemand::Document doc(text);
+        CHECK(doc["user"]["id"].get_int64() == 12345);
+        CHECK(doc["flags"].type() == json::Type::array);
+
+        // Out of order, wraps around.
+        auto user = doc["user"].get_object();
+        CHECK(user["name"].get_string() == "J\xC3\xA4ne");
+        CHECK(user["id"].get_uint64() == 12345);
+        CHECK(!user["missing"]);
+        CHECK(user["tags"].type() == json::Type::array);
+
+        char const* first = nullptr;
+        char const* last = nullptr;
+        CHECK(doc["blob"].raw_json(first, last));
+        CHECK(std::string(first, last) == R"({"nested": [1, {"a": []}], "s": "\\"})");
+
+        CHECK(doc["items"].type() == json::Type::array);
+        CHECK(doc["user"]["tags"].type() == json::Type::array);
+        CHECK(doc.finish() == json::ParseStatus::success);
+    }
+
+    SECTION("iteration")
+    {
+        json::ondemand::Document doc(text);
+
+        std::vector<std::string> names;
+        double total = 0;
+        auto items = doc["items"].get_array();
+        while (auto item = items.next())
+        {
+            auto obj = item.get_object();
+            names.push_back(obj["name"].get_string());
+            total += obj["price"].get_number();
+        }
+        CHECK(names == (std::vector<std::string>{"x", "y", "z"}));
+        CHECK(total == -1998.5);
+        CHECK(!items.next());
+
+        auto flags = doc["flags"].get_array();
+        auto f0 = flags.next();
+        CHECK(f0.get_boolean(false) == true);
+        CHECK(!f0.get_boolean(false)); // Already consumed
+        auto f1 = flags.next();
+        int64_t i = 0;
+        CHECK(!f1.get(i)); // Wrong type, skipped
+        CHECK(flags.next().is_null());
+        CHECK(!flags.next());
+
+        std::vector<std::string> keys;
+        std::string key;
+        auto blob = doc["blob"].get_object();
+        while (auto v = blob.next(key))
+        {
+            keys.push_back(key);
+        }
+        CHECK(keys == (std::vector<std::string>{"nested", "s"}));
+        CHECK(doc.finish() == json::ParseStatus::success);
+    }
+
+    SECTION("types")
+    {
+        std::string const str = R"([null, true, 1, -1.5e2, "s\n", [], {}, NaN, -Infinity, 18446744073709551615, -9223372036854775809])";
+        json::ondemand::Document doc(str);
+        auto arr = doc.root().get_array();
+
+        CHECK(arr.next().type() == json::Type::null);
+        CHECK(arr.next().type() == json::Type::boolean);
+        auto v = arr.next();
+        CHECK(v.type() == json::Type::number);
+        CHECK(v.get_uint64() == 1);
+        CHECK(arr.next().get_number() == -150.0);
+        CHECK(arr.next().get_string() == "s\n");
+        CHECK(!arr.next().get_object());
+        CHECK(!arr.next().get_array());
+        CHECK(std::isnan(arr.next().get_number()));
+        CHECK(arr.next().get_number() == -std::numeric_limits<double>::infinity());
+        CHECK(arr.next().get_uint64() == UINT64_MAX);
+        CHECK(arr.next().get_int64(-1) == -1); // Not representable
+        CHECK(!arr.next());
+        CHECK(doc.finish() == json::ParseStatus::success);
+
+        std::string const zero = "-0";
+        json::ondemand::Document zero_doc(zero);
+        CHECK(zero_doc.root().get_uint64(1) == 0);
+    }
+
+    SECTION("errors")
+    {
+        {
+            std::string const str = R"({"a": [1, 2 3], "b": 1})";
+            json::ondemand::Document doc(str);
+            CHECK(doc["b"].get_int64(-1) == -1);
+            CHECK(doc.status() == json::ParseStatus::expected_comma_or_closing_bracket);
+            CHECK(doc.finish() == json::ParseStatus::expected_comma_or_closing_bracket);
+        }
+        {
+            // Only the values which are accessed are checked...
+            std::string const str = R"({"a": 1, "b": [1, 2 3]})";
+            json::ondemand::Document doc(str);
+            CHECK(doc["a"].get_int64() == 1);
+            CHECK(doc.status() == json::ParseStatus::success);
+            // ...unless the document is finished.
+            CHECK(doc.finish() == json::ParseStatus::expected_comma_or_closing_bracket);
+        }
+        {
+            std::string const str = R"({"a": "\x"})";
+            json::ondemand::Document doc(str);
+            CHECK(doc["a"].get_string() == "");
+            CHECK(doc.status() == json::ParseStatus::invalid_string);
+        }
+        {
+            std::string const str = R"({"a": 1} x)";
+            json::ondemand::Document doc(str);
+            CHECK(doc["a"].get_int64() == 1);
+            CHECK(doc.finish() == json::ParseStatus::expected_eof);
+        }
+        {
+            std::string const str = std::string(600, '[') + std::string(600, ']');
+            json::ondemand::Document doc(str);
+            CHECK(doc.finish() == json::ParseStatus::max_depth_reached);
+        }
+    }
+}
+
+TEST_CASE("Snapshot")
 {
-    SECTION("pass")
+    std::string const str = R"({"b": [1, -2.5, "s\n\u00E4", null, true, false, [], {}], "a": {"x": 1, "y": {"x": "zz"}}, "": 0, "aa": [{"x": 2}]})";
+
+    json::Value value;
+    REQUIRE(json::parse(value, str) == json::ParseStatus::success);
+
+    SECTION("memory")
     {
-        for (auto const& test : kJSONTestSuitePass)
+        std::string buf;
+        REQUIRE(json::write_snapshot(buf, value));
+        CHECK(buf.size() % 8 == 0);
+
+        json::Snapshot snap;
+        REQUIRE(snap.open(buf.data(), buf.size()));
+
+        auto const root = snap.root();
+        CHECK(root.is_object());
+        CHECK(root.size() == 4);
+        CHECK(root[""].get_number() == 0.0);
+        CHECK(root["a"]["x"].get_number() == 1.0);
+        CHECK(root["a"]["y"]["x"].get_string() == "zz");
+        CHECK(root["aa"][0]["x"].get_number() == 2.0);
+        CHECK(root["c"].is_undefined());
+        CHECK(root["ab"].is_undefined());
+        CHECK(!root.has_member("A"));
+
+        auto const b = root["b"];
+        CHECK(b.size() == 8);
+        CHECK(b[0].get_number() == 1.0);
+        CHECK(b[1].get_number() == -2.5);
+        CHECK(b[2].get_string() == "s\n\xC3\xA4");
+        CHECK(b[2].string_data()[4] == '\0');
+        CHECK(b[3].is_null());
+        CHECK(b[4].get_boolean() == true);
+        CHECK(b[5].get_boolean() == false);
+        CHECK(b[6].empty());
+        CHECK(b[7].is_object());
+        CHECK(b[8].is_undefined());
+        CHECK(b.elements().end() - b.elements().begin() == 8);
+
+        // Members are visited in sorted order.
+        std::vector<std::string> keys;
+        for (auto const m : root.items())
+            keys.push_back(m.key.get_string());
+        CHECK(keys == (std::vector<std::string>{"", "a", "aa", "b"}));
+
+        CHECK(root.to_value() == value);
+
+        // Not a snapshot.
+        CHECK(!snap.open(str.data(), str.size()));
+        CHECK(!snap.is_open());
+        CHECK(snap.root().is_undefined());
+    }
+
+    SECTION("corrupted")
+    {
+        std::string buf;
+        REQUIRE(json::write_snapshot(buf, value));
+
+        // Flip each bit. Either the snapshot is rejected, or reading it stays
+        // inside the snapshot.
+        for (size_t i = 0; i < buf.size() * 8; ++i)
         {
-            CAPTURE(test.name);
+            std::string copy = buf;
+            copy[i / 8] = static_cast<char>(copy[i / 8] ^ (1 << (i % 8)));
 
-            json::Value val;
-            auto const res = json::parse(val, test.input.data(), test.input.data() + test.input.size());
-            CHECK(res.ec == json::ParseStatus::success);
+            json::Snapshot snap;
+            if (!snap.open(copy.data(), copy.size(), /*verify*/ true))
+                continue;
 
-            std::string str;
-            auto const ok = json::stringify(str, val);
-            CHECK(ok == true);
+            auto const root = snap.root();
+            root.to_value();
+            if (root.is_object())
+                root["b"].to_value();
+        }
 
-            json::Value val2;
-            auto const res2 = json::parse(val2, str.data(), str.data() + str.size());
-            CHECK(res2.ec == json::ParseStatus::success);
+        // Truncated
+        json::Snapshot snap;
+        CHECK(!snap.open(buf.data(), buf.size() - 8));
 
-            CHECK(val == val2);
-            CHECK(!(val != val2));
-            CHECK(!(val < val2));
-            CHECK(val <= val2);
-            CHECK(!(val > val2));
-            CHECK(val >= val2);
+        // Keys not sorted. Swap the first two members of the root object.
+        {
+            uint64_t root;
+            std::memcpy(&root, buf.data() + 24, sizeof(uint64_t));
+            size_t const offset = static_cast<size_t>(root & ((uint64_t{1} << 56) - 1));
+
+            std::string unsorted = buf;
+            std::swap_ranges(&unsorted[offset + 8], &unsorted[offset + 24], &unsorted[offset + 24]);
+            CHECK(snap.open(unsorted.data(), unsorted.size()));
+            CHECK(!snap.open(unsorted.data(), unsorted.size(), /*verify*/ true));
+            CHECK(snap.open(buf.data(), buf.size(), /*verify*/ true));
         }
+
+        // Foreign byte order
+        std::string swapped = buf;
+        std::reverse(swapped.begin() + 8, swapped.begin() + 12);
+        CHECK(!snap.open(swapped.data(), swapped.size()));
     }
 
-    SECTION("fail")
+    SECTION("file")
     {
-        for (auto const& test : kJSONTestSuiteFail)
+        char const* const filename = "test_snapshot.tmp";
+        REQUIRE(json::write_snapshot_file(filename, value));
+
         {
-            CAPTURE(test.name);
+            json::Snapshot snap;
+            REQUIRE(snap.open(filename));
+            CHECK(snap.root().to_value() == value);
+            REQUIRE(snap.open(filename, /*verify*/ true));
+            CHECK(snap.root().to_value() == value);
+        }
 
-            json::Options options;
-            //options.allow_comments = true;
+        std::remove(filename);
 
-            json::Value val;
-            auto const res = json::parse(val, test.input.data(), test.input.data() + test.input.size(), options);
-            CHECK(res.ec != json::ParseStatus::success);
-        }
+        json::Snapshot snap;
+        CHECK(!snap.open(filename));
     }
-}
 
-//------------------------------------------------------------------------------
-//
-//------------------------------------------------------------------------------
+    SECTION("undefined")
+    {
+        std::string buf = "x";
+        CHECK(!json::write_snapshot(buf, json::Value(json::array_tag, {json::Value()})));
+        CHECK(buf == "x");
+    }
+}
 
-struct StringTest
+TEST_CASE("Tape")
 {
-    std::string inp;
-    std::string expected;
-};
+    SECTION("accessors")
+    {
+        std::string const str = R"({"b": [1, -2.5, "s\n\u00E4", null, true, false, [], {}], "a": {"x": 1, "y": {"z": "zz"}}, "a": {"x": 2}})";
+
+        json::Tape tape;
+        REQUIRE(json::parse(tape, str) == json::ParseStatus::success);
+
+        auto const root = tape.root();
+        CHECK(root.is_object());
+        CHECK(root.size() == 3);
+
+        // Duplicate keys: the last member wins.
+        CHECK(root["a"]["x"].get_number() == 2.0);
+        CHECK(root["a"]["y"].is_undefined());
+        CHECK(root["c"].is_undefined());
+        CHECK(!root.has_member("c"));
+        CHECK(root["b"][0]["x"].is_undefined());
+
+        auto const b = root["b"];
+        CHECK(b.is_array());
+        CHECK(b.size() == 8);
+        CHECK(b[0].get_number() == 1.0);
+        CHECK(b[1].get_number() == -2.5);
+        CHECK(b[2].get_string() == "s\n\xC3\xA4");
+        CHECK(b[2].string_size() == 4);
+        CHECK(b[2].string_data()[4] == '\0');
+        CHECK(b[3].is_null());
+        CHECK(b[4].get_boolean() == true);
+        CHECK(b[5].get_boolean() == false);
+        CHECK(b[6].is_array());
+        CHECK(b[6].empty());
+        CHECK(b[7].is_object());
+        CHECK(b[7].empty());
+        CHECK(b[8].is_undefined());
+
+        // Members are visited in document order.
+        std::vector<std::string> keys;
+        for (auto const m : root.items())
+            keys.push_back(m.key.get_string());
+        CHECK(keys == (std::vector<std::string>{"b", "a", "a"}));
+
+        size_t n = 0;
+        for (auto const v : b.elements())
+        {
+            CHECK(v.type() == b[n].type());
+            ++n;
+        }
+        CHECK(n == 8);
 
-static const StringTest kTestStrings[] = {
-    {"[\"\"]", ""},
-    {"[\"Hello\"]", "Hello"},
-    {"[\"Hello\\nWorld\"]", "Hello\nWorld"},
-    {std::string("[\"Hello\\u0000World\"]", 20), std::string("Hello\0World", 11)},
-    {"[\"\\\"\\\\/\\b\\f\\n\\r\\t\"]", "\"\\/\b\f\n\r\t"},
-    {"[\"\\u0024\"]", "\x24"},
-    {"[\"\\u00A2\"]", "\xC2\xA2"},
-    {"[\"\\u20AC\"]", "\xE2\x82\xAC"},
-    {"[\"\\uD834\\uDD1E\"]", "\xF0\x9D\x84\x9E"},
-};
+        json::Value value;
+        REQUIRE(json::parse(value, str) == json::ParseStatus::success);
+        CHECK(root.to_value() == value);
+    }
 
-TEST_CASE("Parse_string")
-{
-    for (auto const& test : kTestStrings)
+    SECTION("interned keys")
     {
-        json::Value val1;
-        auto const res1 = json::parse(val1, test.inp.data(), test.inp.data() + test.inp.size());
-        CHECK(res1.ec == json::ParseStatus::success);
-        CHECK(val1.is_array());
-        CHECK(val1.get_array().size() == 1);
-        CHECK(val1[0].is_string());
-        CHECK(val1[0].get_string() == test.expected);
+        std::string str = R"([{"a": 1, "b\u0061": "a"}, {"ba": 2, "a": "ba"}, {)";
+        // More distinct keys than are interned.
+        for (int i = 0; i < 70000; ++i)
+        {
+            str += (i == 0 ? "\"k" : ", \"k") + std::to_string(i) + "\": " + std::to_string(i);
+        }
+        str += R"(}, {"a": 3, "\u0061b": 4}])";
+
+        json::Tape tape;
+        REQUIRE(json::parse(tape, str) == json::ParseStatus::success);
+
+        auto const root = tape.root();
+        std::vector<json::TapeValue> k0;
+        std::vector<json::TapeValue> k1;
+        for (auto const m : root[0].items())
+            k0.push_back(m.key);
+        for (auto const m : root[1].items())
+            k1.push_back(m.key);
+        REQUIRE(k0.size() == 2);
+        REQUIRE(k1.size() == 2);
+
+        // Equal keys refer to the same string, also if they have been escaped.
+        CHECK(k0[0].is_same_string(k1[1]));
+        CHECK(k0[1].is_same_string(k1[0]));
+        CHECK(k0[0].string_data() == k1[1].string_data());
+        CHECK(!k0[0].is_same_string(k0[1]));
+        CHECK(k1[0].get_string() == "ba");
+
+        // String values are not interned.
+        CHECK(!k0[0].is_same_string(root[0]["ba"]));
+        CHECK(root[1]["a"].get_string() == "ba");
+
+        CHECK(root[2].size() == 70000);
+        CHECK(root[2]["k69999"].get_number() == 69999.0);
+        CHECK(root[3]["ab"].get_number() == 4.0);
+        CHECK((*root[3].items().begin()).key.get_string() == "a");
+
+        json::Value value;
+        REQUIRE(json::parse(value, str) == json::ParseStatus::success);
+        CHECK(root.to_value() == value);
+
+        // Invalid escaped keys.
+        CHECK(json::parse(tape, std::string(R"([{"a": 1}, {"\x": 2}])")) == json::ParseStatus::invalid_string);
+    }
 
-        std::string s;
-        auto const str_ok = json::stringify(s, val1);
-        CHECK(str_ok);
+    SECTION("large")
+    {
+        std::string str = "[";
+        for (int i = 0; i < 70000; ++i)
+        {
+            str += std::to_string(i);
+            str += ',';
+        }
+        str += "{}]";
 
-        json::Value val2;
-        auto const res2 = json::parse(val2, s.data(), s.data() + s.size());
-        CHECK(res2.ec == json::ParseStatus::success);
-        CHECK(val2.is_array());
-        CHECK(val2.get_array().size() == 1);
-        CHECK(val2[0].is_string());
-        CHECK(val2[0].get_string() == test.expected);
+        json::Tape tape;
+        REQUIRE(json::parse(tape, str) == json::ParseStatus::success);
+
+        auto const root = tape.root();
+        CHECK(root.size() == 70001);
+        CHECK(root[69999].get_number() == 69999.0);
+        CHECK(root[70000].is_object());
+    }
+
+    SECTION("errors")
+    {
+        json::Tape tape;
+        REQUIRE(json::parse(tape, "[1, 2]") == json::ParseStatus::success);
+        CHECK(json::parse(tape, "[1, 2") != json::ParseStatus::success);
+        CHECK(tape.root().is_undefined());
+        CHECK(json::parse(tape, R"(["\x"])") == json::ParseStatus::invalid_string);
+        CHECK(tape.root().is_undefined());
+
+        // Tapes can be reused.
+        REQUIRE(json::parse(tape, R"("s")") == json::ParseStatus::success);
+        CHECK(tape.root().get_string() == "s");
     }
 }
 
-TEST_CASE("Stringify")
+static std::string FromHex(char const* hex)
 {
-    std::string const input = R"({
-    "empty_array": [],
-    "empty_object" : {},
-    "FirstName": "John",
-    "LastName": "Doe",
-    "Age": 43,
-    "Address": {
-        "Street": "Downing \"Street\" 10",
-        "City": "London",
-        "Country": "Great Britain"
-    },
-    "Phone numbers": [
-        "+44 1234567",
-        "+44 2345678"
-    ]
-})";
+    std::string bytes;
+    for ( ; hex[0] != '\0' && hex[1] != '\0'; hex += 2)
+        bytes += static_cast<char>(std::stoi(std::string(hex, 2), nullptr, 16));
+    return bytes;
+}
 
-    json::Value val;
-    json::parse(val, input.data(), input.data() + input.size());
+static std::string ToCbor(json::Value const& value)
+{
+    std::string out;
+    json::to_cbor(out, value);
+    return out;
+}
 
-    json::Options options;
-    options.indent_width = 4;
+TEST_CASE("CBOR")
+{
+    SECTION("encode")
+    {
+        // RFC 8949, Appendix A
+        CHECK(ToCbor(0) == FromHex("00"));
+        CHECK(ToCbor(23) == FromHex("17"));
+        CHECK(ToCbor(24) == FromHex("1818"));
+        CHECK(ToCbor(100) == FromHex("1864"));
+        CHECK(ToCbor(1000) == FromHex("1903e8"));
+        CHECK(ToCbor(1000000) == FromHex("1a000f4240"));
+        CHECK(ToCbor(1000000000000.0) == FromHex("1b000000e8d4a51000"));
+        CHECK(ToCbor(18446744073709549568.0) == FromHex("1bfffffffffffff800"));
+        CHECK(ToCbor(-1) == FromHex("20"));
+        CHECK(ToCbor(-100) == FromHex("3863"));
+        CHECK(ToCbor(-9223372036854775808.0) == FromHex("3b7fffffffffffffff"));
+        CHECK(ToCbor(-0.0) == FromHex("f98000"));
+        CHECK(ToCbor(1.5) == FromHex("f93e00"));
+        CHECK(ToCbor(5.960464477539063e-8) == FromHex("f90001"));
+        CHECK(ToCbor(0.00006103515625) == FromHex("f90400"));
+        CHECK(ToCbor(-4.1) == FromHex("fbc010666666666666"));
+        CHECK(ToCbor(1.0e+300) == FromHex("fb7e37e43c8800759c"));
+        CHECK(ToCbor(3.4028234663852886e+38) == FromHex("fa7f7fffff"));
+        CHECK(ToCbor(18446744073709551616.0) == FromHex("fa5f800000"));
+        CHECK(ToCbor(std::numeric_limits<double>::infinity()) == FromHex("f97c00"));
+        CHECK(ToCbor(-std::numeric_limits<double>::infinity()) == FromHex("f9fc00"));
+        CHECK(ToCbor(std::numeric_limits<double>::quiet_NaN()) == FromHex("f97e00"));
+        CHECK(ToCbor(false) == FromHex("f4"));
+        CHECK(ToCbor(true) == FromHex("f5"));
+        CHECK(ToCbor(nullptr) == FromHex("f6"));
+        CHECK(ToCbor(json::Value()) == FromHex("f7"));
+        CHECK(ToCbor("") == FromHex("60"));
+        CHECK(ToCbor("\xC3\xBC") == FromHex("62c3bc"));
+        CHECK(ToCbor(json::Value(json::array_tag, {1, json::Value(json::array_tag, {2, 3})})) == FromHex("8201820203"));
+
+        json::Value obj;
+        REQUIRE(json::parse(obj, R"({"b": [2, 3], "a": 1})") == json::ParseStatus::success);
+        CHECK(ToCbor(obj) == FromHex("a26161016162820203"));
+    }
 
-    std::string str;
-    json::stringify(str, val, options);
-    //printf("%s\n", str.c_str());
+    SECTION("decode")
+    {
+        auto const decode = [](char const* hex) {
+            json::Value value;
+            auto const bytes = FromHex(hex);
+            CHECK(json::from_cbor(value, bytes) == json::ParseStatus::success);
+            return value;
+        };
 
-    json::Value val2;
-    json::parse(val2, str.data(), str.data() + str.size());
+        CHECK(decode("1b000000e8d4a51000") == 1000000000000.0);
+        CHECK(decode("3bffffffffffffffff") == -18446744073709551616.0);
+        CHECK(decode("f93c00") == 1.0);
+        CHECK(decode("f90001") == 5.960464477539063e-8);
+        CHECK(decode("fa47c35000") == 100000.0);
+        CHECK(decode("fbc010666666666666") == -4.1);
+        CHECK(decode("f9fc00") == -std::numeric_limits<double>::infinity());
+        CHECK(std::isnan(decode("f97e00").get_number()));
+        CHECK(decode("f7").is_null());
+        CHECK(decode("f0").is_null());
+        CHECK(decode("7f657374726561646d696e67ff") == "streaming");
+        CHECK(decode("5f42010243030405ff") == "AQIDBAU");
+        CHECK(decode("c074323031332d30332d32315432303a30343a30305a") == "2013-03-21T20:04:00Z");
+        CHECK(decode("c11a514b67b0") == 1363896240);
+        CHECK(decode("9f018202039f0405ffff") == json::Value(json::array_tag, {1, json::Value(json::array_tag, {2, 3}), json::Value(json::array_tag, {4, 5})}));
+        CHECK(decode("bf6346756ef563416d7421ff") == json::Value(json::object_tag, {{"Fun", true}, {"Amt", -2}}));
+
+        json::Value value;
+        REQUIRE(json::parse(value, R"({"s": "a\"b\\c\n", "n": [0, -1, 1.5, 1e300, -4.1, 4294967296], "o": {"": null, "t": true}})") == json::ParseStatus::success);
 
-    CHECK(val == val2);
+        json::Value copy;
+        CHECK(json::from_cbor(copy, ToCbor(value)) == json::ParseStatus::success);
+        CHECK(copy == value);
+    }
+
+    SECTION("callbacks")
+    {
+        std::map<std::string, std::vector<int>> m;
+        json::DecodeCallbacks cb(m);
+
+        auto const bytes = FromHex("a26161820102616280");
+        auto const res = json::parse_cbor(cb, bytes.data(), bytes.data() + bytes.size());
+        CHECK(res.ec == json::ParseStatus::success);
+        CHECK(res.ptr == bytes.data() + bytes.size());
+        CHECK(m == (std::map<std::string, std::vector<int>>{{"a", {1, 2}}, {"b", {}}}));
+    }
+
+    SECTION("errors")
+    {
+        auto const status = [](std::string const& bytes, json::Options const& options = {}) {
+            json::Value value;
+            return json::from_cbor(value, bytes, options);
+        };
+
+        CHECK(status("") == json::ParseStatus::unexpected_eof);
+        CHECK(status(FromHex("18")) == json::ParseStatus::unexpected_eof);
+        CHECK(status(FromHex("6261")) == json::ParseStatus::unexpected_eof);
+        CHECK(status(FromHex("9bffffffffffffffff")) == json::ParseStatus::unexpected_eof);
+        CHECK(status(FromHex("9f01")) == json::ParseStatus::unexpected_eof);
+        CHECK(status(FromHex("1c")) == json::ParseStatus::invalid_value);
+        CHECK(status(FromHex("ff")) == json::ParseStatus::invalid_value);
+        CHECK(status(FromHex("1f")) == json::ParseStatus::invalid_value);
+        CHECK(status(FromHex("a10102")) == json::ParseStatus::invalid_key);
+        CHECK(status(FromHex("61ff")) == json::ParseStatus::invalid_string);
+        CHECK(status(FromHex("7f4161ff")) == json::ParseStatus::invalid_string);
+        CHECK(status(std::string(600, '\x81') + '\x00') == json::ParseStatus::max_depth_reached);
+        CHECK(status(FromHex("0000")) == json::ParseStatus::expected_eof);
+
+        // CBOR sequences
+        json::Options options;
+        options.allow_trailing_characters = true;
+
+        auto const bytes = FromHex("0102");
+        json::Value value;
+        auto const res = json::from_cbor(value, bytes.data(), bytes.data() + bytes.size(), options);
+        CHECK(res.ec == json::ParseStatus::success);
+        CHECK(res.ptr == bytes.data() + 1);
+        CHECK(value == 1);
+    }
 }
 
 TEST_CASE("Comments")
@@ -2402,6 +4103,338 @@ TEST_CASE("DOubles 2")
     check_double(  1.2345e+22,   "1.2345e+22"             );
 }
 
+TEST_CASE("StringToNumber - hard cases")
+{
+    static const char* const inputs[] = {
+        "9007199254740993",             // 2^53 + 1, round to even
+        "9007199254740995",
+        "9007199254740993.0000000001",
+        "1.00000000000000011102230246251565404236316680908203125", // 1 + 2^-53, round to even
+        "1.00000000000000011102230246251565404236316680908203126",
+        "2.2250738585072011e-308",
+        "2.2250738585072014e-308",
+        "4.9406564584124654e-324",
+        "2.4703282292062327e-324",
+        "2.4703282292062328e-324",
+        "1.7976931348623157e308",
+        "1.7976931348623158e308",
+        "1.7976931348623159e308",
+        "7.2057594037927933e16",
+        "8.988465674311579e307",
+        "3.0540412659e-08",
+        "1234567890123456789",
+        "12345678901234567890",
+        "0.1",
+        "0.3",
+        "123.456e-300",
+        "1e-342",
+        "1e-343",
+        "1e308",
+        "1e309",
+        "-3.1415926535897932384626433832795",
+    };
+
+    for (auto const* inp : inputs)
+    {
+        CAPTURE(inp);
+
+        double const expected = std::strtod(inp, nullptr);
+
+        double actual;
+        CHECK(json::numbers::StringToNumber(actual, inp, inp + std::strlen(inp)));
+        CHECK(std::memcmp(&expected, &actual, sizeof(double)) == 0);
+    }
+}
+
+TEST_CASE("StringToNumber - long mantissas")
+{
+    // Exercise the block-wise digit scanning with all combinations of integer
+    // and fraction lengths around multiples of 8.
+    std::string const digits = "31415926535897932384626433832795028841971693993751";
+
+    for (size_t int_len = 0; int_len <= 26; ++int_len)
+    {
+        for (size_t frac_len = 0; frac_len <= 26; ++frac_len)
+        {
+            if (int_len == 0 && frac_len == 0)
+                continue;
+
+            std::string inp = (int_len == 0) ? std::string("0") : digits.substr(0, int_len);
+            if (frac_len > 0)
+            {
+                inp += '.';
+                inp += digits.substr(int_len, frac_len);
+            }
+
+            for (char const* suffix : {"", "e-5", "E+17"})
+            {
+                std::string const s = inp + suffix;
+                CAPTURE(s);
+
+                double const expected = std::strtod(s.c_str(), nullptr);
+
+                double actual;
+                CHECK(json::numbers::StringToNumber(actual, s.data(), s.data() + s.size()));
+                CHECK(std::memcmp(&expected, &actual, sizeof(double)) == 0);
+            }
+        }
+    }
+
+    // More digits than fit into the buffer.
+    {
+        std::string s = std::string(800, '9') + "." + std::string(800, '1') + "e-400";
+        CAPTURE(s);
+
+        double const expected = std::strtod(s.c_str(), nullptr);
+
+        double actual;
+        CHECK(json::numbers::StringToNumber(actual, s.data(), s.data() + s.size()));
+        CHECK(std::memcmp(&expected, &actual, sizeof(double)) == 0);
+    }
+
+    // Invalid characters at block boundaries.
+    for (char const* inp : {"12345678a", "1234567a8", "0.12345678a", "0.1234567a8", "1234567812345678."})
+    {
+        CAPTURE(inp);
+
+        double actual;
+        CHECK(!json::numbers::StringToNumber(actual, inp, inp + std::strlen(inp)));
+    }
+}
+
+TEST_CASE("FloatToString/StringToFloat")
+{
+    static const float values[] = {
+        0.1f,
+        0.3f,
+        1.234f,
+        1.0e+10f,
+        3.14159265f,
+        16777216.0f,
+        16777218.0f,
+        std::numeric_limits<float>::min(),
+        std::numeric_limits<float>::max(),
+        std::numeric_limits<float>::denorm_min(),
+        std::numeric_limits<float>::epsilon(),
+    };
+
+    auto check_float = [](float value)
+    {
+        CAPTURE(value);
+
+        char buf[32];
+        char* const end = json::numbers::FloatToString(buf, buf + 32, value);
+        *end = '\0';
+        CAPTURE(buf);
+
+        // Round-trip.
+        float actual;
+        CHECK(json::numbers::StringToFloat(actual, buf, end));
+        CHECK(std::memcmp(&value, &actual, sizeof(float)) == 0);
+
+        float const expected = std::strtof(buf, nullptr);
+        CHECK(std::memcmp(&value, &expected, sizeof(float)) == 0);
+
+        // At most 9 significant digits.
+        std::string digits(buf, end);
+        digits.erase(std::min(digits.find('e'), digits.size()));
+        digits.erase(std::remove_if(digits.begin(), digits.end(), [](char ch) { return ch < '0' || ch > '9'; }), digits.end());
+        digits.erase(0, digits.find_first_not_of('0'));
+        digits.erase(digits.find_last_not_of('0') + 1);
+        CHECK(digits.size() <= 9);
+    };
+
+    for (float const v : values)
+    {
+        check_float(v);
+        check_float(-v);
+    }
+
+    std::mt19937 rng(1234);
+    for (int i = 0; i < 10000; ++i)
+    {
+        uint32_t const bits = rng();
+
+        float value;
+        std::memcpy(&value, &bits, sizeof(float));
+        if (!std::isfinite(value))
+            continue;
+
+        check_float(value);
+    }
+
+    {
+        char buf[32];
+        CHECK(std::string(buf, json::numbers::FloatToString(buf, buf + 32, 0.1f)) == "0.1");
+        CHECK(std::string(buf, json::numbers::FloatToString(buf, buf + 32, 16777216.0f)) == "16777216");
+        CHECK(std::string(buf, json::numbers::FloatToString(buf, buf + 32, 1.0e+10f)) == "10000000000.0");
+        CHECK(std::string(buf, json::numbers::FloatToString(buf, buf + 32, -0.0f)) == "-0.0");
+    }
+
+    // Inputs which require correct rounding, i.e. which are not correctly
+    // rounded by first rounding to double-precision.
+    static const char* const inputs[] = {
+        "1.00000005960464477539062500000000001", // 1 + 2^-24 (+ tiny), round up
+        "1.000000059604644775390625",            // 1 + 2^-24, round to even (down)
+        "1.00000005960464477539062499999999999", // round down
+        "1.00000017881393432617187500000000001", // 1 + 3 * 2^-24 (+ tiny)
+        "1.000000178813934326171875",            // 1 + 3 * 2^-24, round to even (up)
+        "3.4028235677973366e38",                 // FLT_MAX + 1/2 ulp, round to even (infinity)
+        "3.4028235677973365e38",
+        "7.0064923216240861e-46",                // denorm_min / 2
+        "7.0064923216240862e-46",
+        "1e-50",
+        "1e50",
+    };
+
+    for (auto const* inp : inputs)
+    {
+        CAPTURE(inp);
+
+        float const expected = std::strtof(inp, nullptr);
+
+        float actual;
+        CHECK(json::numbers::StringToFloat(actual, inp, inp + std::strlen(inp)));
+        CHECK(std::memcmp(&expected, &actual, sizeof(float)) == 0);
+    }
+}
+
+TEST_CASE("Traits<float>")
+{
+    // FloatToNumber and NumberToFloat must match the conversions via the
+    // shortest decimal representation, in particular for midpoints between
+    // adjacent single-precision numbers.
+    std::mt19937_64 rng(2345);
+    for (int i = 0; i < 10000; ++i)
+    {
+        uint64_t const bits = rng();
+
+        float f;
+        uint32_t const f_bits = static_cast<uint32_t>(bits);
+        std::memcpy(&f, &f_bits, sizeof(float));
+
+        char buf[32];
+        char* end = json::numbers::FloatToString(buf, buf + 32, f, /*emit_trailing_dot_zero*/ false);
+        double expected_d;
+        json::numbers::StringToNumber(expected_d, buf, end);
+        double const actual_d = json::numbers::FloatToNumber(f);
+        CHECK((std::isnan(f) ? std::isnan(actual_d) : std::memcmp(&expected_d, &actual_d, sizeof(double)) == 0));
+
+        if (!std::isfinite(f))
+            continue;
+
+        float const g = std::nextafter(f, std::numeric_limits<float>::infinity());
+        for (double const d : {static_cast<double>(f) + (static_cast<double>(g) - static_cast<double>(f)) / 2, expected_d})
+        {
+            end = json::numbers::NumberToString(buf, buf + 32, d, /*emit_trailing_dot_zero*/ false);
+            float expected_f;
+            json::numbers::StringToFloat(expected_f, buf, end);
+            float const actual_f = json::numbers::NumberToFloat(d);
+            CHECK(std::memcmp(&expected_f, &actual_f, sizeof(float)) == 0);
+        }
+    }
+
+    for (float const f : {0.1f, 1.234f, 3.0e-40f, -7.5f, std::numeric_limits<float>::max()})
+    {
+        CAPTURE(f);
+
+        json::Value const v = f;
+        CHECK(v.as<float>() == f);
+
+        char buf[32];
+        std::string const expected(buf, json::numbers::FloatToString(buf, buf + 32, f, /*emit_trailing_dot_zero*/ false));
+
+        std::string str;
+        json::stringify(str, v);
+        CHECK(str == expected);
+    }
+
+    // StringToFloatNumber takes a shortcut for inputs with at most 6 significant
+    // digits.
+    for (auto const* inp : {"0", "-0", "0.1", "-123456", "1234567", "0.000123456e-30", "1.17549e-38", "1.17550e-38",
+                            "3.40282e38", "3.40283e38", "1e-46", "1e-45", "16777217", "1.00000005960464477539062500000000001"})
+    {
+        CAPTURE(inp);
+
+        auto const nc = std::strpbrk(inp, ".eE") != nullptr ? json::NumberClass::floating_point : json::NumberClass::integer;
+        double const expected = json::numbers::FloatToNumber(json::numbers::StringToFloat(inp, inp + std::strlen(inp), nc));
+        double const actual = json::numbers::StringToFloatNumber(inp, inp + std::strlen(inp), nc);
+        CHECK(std::memcmp(&expected, &actual, sizeof(double)) == 0);
+    }
+
+    json::Options options;
+    options.parse_numbers_as_float = true;
+
+    json::Value v;
+    CHECK(json::ParseStatus::success == json::parse(v, "[0.1, 16777217, 1.00000005960464477539062500000000001, 1e39]", options));
+
+    std::string str;
+    json::stringify(str, v);
+    CHECK(str == "[0.1,16777216,1.0000001,Infinity]");
+
+    json::Tape tape;
+    CHECK(json::ParseStatus::success == json::parse(tape, "[0.1, 16777217, 1.00000005960464477539062500000000001, 1e39]", options));
+    CHECK(tape.root().to_value() == v);
+}
+
+TEST_CASE("StringsToNumbers/NumbersToString")
+{
+    std::vector<std::string> inputs = {
+        "0", "-0", "0.0", "1", "-1", "0.5", "123.456", "-0.001", "1e10", "1E-10", "1e+308", "1e309", "1e-400",
+        "9007199254740993", "12345678901234567890", "1234567890123456789", "0.1234567890123456789",
+        "0.00000000000000000001", "4.9406564584124654e-324", "1.7976931348623157e308", "1e00001", "1e99999",
+        "Infinity", "-Infinity", "NaN",
+        // invalid:
+        "", "-", "01", "1.", ".5", "+1", "1e", "1e+", "1x", "0x10", "1.5e3.0",
+    };
+
+    std::mt19937_64 rng(4321);
+    for (int i = 0; i < 1000; ++i)
+    {
+        uint64_t const bits = rng();
+
+        double value;
+        std::memcpy(&value, &bits, sizeof(double));
+
+        char buf[32];
+        inputs.emplace_back(buf, json::numbers::NumberToString(buf, buf + 32, value));
+    }
+
+    std::vector<json::numbers::NumberString> strings;
+    for (auto const& inp : inputs)
+    {
+        strings.push_back({inp.data(), inp.data() + inp.size()});
+    }
+
+    std::vector<double> values(strings.size());
+    CHECK(!json::numbers::StringsToNumbers(values.data(), strings.data(), strings.size()));
+
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        CAPTURE(inputs[i]);
+
+        double expected;
+        json::numbers::StringToNumber(expected, strings[i].first, strings[i].last);
+        CHECK(std::memcmp(&expected, &values[i], sizeof(double)) == 0);
+    }
+
+    std::string str = "[";
+    json::numbers::NumbersToString(str, values.data(), values.size(), ',');
+    str += ']';
+
+    std::string expected = "[";
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        char buf[32];
+        if (i > 0)
+            expected += ',';
+        expected.append(buf, json::numbers::NumberToString(buf, buf + 32, values[i]));
+    }
+    expected += ']';
+
+    CHECK(str == expected);
+}
+
 TEST_CASE("number conversions")
 {
     static const double Infinity = std::numeric_limits<double>::infinity();